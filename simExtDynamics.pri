@@ -191,6 +191,12 @@ VORTEX_ENGINE {
     DEFINES += dynReal=float
 }
 
+#CONFIG += DYN_PROFILING # step profiler, see dynPlugin_getProfilingData
+
+DYN_PROFILING {
+    DEFINES += DYN_PROFILING
+}
+
 DOUBLE_PRECISION {
     DEFINES += BT_USE_DOUBLE_PRECISION
     DEFINES += dDOUBLE
@@ -220,20 +226,28 @@ SOURCES += ../common/simLib.cpp \
 
 HEADERS += sourceCode/dynamics/CollShapeDyn.h \
     sourceCode/dynamics/ConstraintDyn.h \
+    sourceCode/dynamics/ContactArena.h \
     sourceCode/dynamics/ParticleContainer.h \
     sourceCode/dynamics/ParticleObject.h \
     sourceCode/dynamics/ParticleDyn.h \
+    sourceCode/dynamics/ParticleDyn_soa.h \
+    sourceCode/dynamics/ParticleSystem.h \
     sourceCode/dynamics/RigidBodyDyn.h \
     sourceCode/dynamics/RigidBodyContainerDyn.h \
+    sourceCode/dynamics/StepProfiler.h \
     sourceCode/simExtDynamics.h \
 
 SOURCES += sourceCode/dynamics/CollShapeDyn.cpp \
     sourceCode/dynamics/ConstraintDyn.cpp \
+    sourceCode/dynamics/ContactArena.cpp \
     sourceCode/dynamics/ParticleContainer.cpp \
     sourceCode/dynamics/ParticleObject.cpp \
     sourceCode/dynamics/ParticleDyn.cpp \
+    sourceCode/dynamics/ParticleDyn_soa.cpp \
+    sourceCode/dynamics/ParticleSystem.cpp \
     sourceCode/dynamics/RigidBodyDyn.cpp \
     sourceCode/dynamics/RigidBodyContainerDyn.cpp \
+    sourceCode/dynamics/StepProfiler.cpp \
     sourceCode/simExtDynamics.cpp \
 
 BULLET_2_78_ENGINE {
@@ -4,6 +4,8 @@
 
 CCollShapeDyn::CCollShapeDyn()
 {
+    _rigidBodyDependencyCount=0;
+    _collisionShapeListIndex=-1;
 }
 
 CCollShapeDyn::~CCollShapeDyn()
@@ -30,33 +32,31 @@ int CCollShapeDyn::getObjectID()
     return(_objectID);
 }
 
-void CCollShapeDyn::addRigidBodyDependency(int rigidBodyID)
+void CCollShapeDyn::addRigidBodyDependency()
 {
-    if (!isRigidBodyDependent(rigidBodyID)) // just in case
-        _rigidBodyDependencies.push_back(rigidBodyID);
+    _rigidBodyDependencyCount++;
 }
 
-bool CCollShapeDyn::removeRigidBodyDependency(int rigidBodyID)
+bool CCollShapeDyn::removeRigidBodyDependency()
 { // return value true means this object should be removed (no more dependent rigid bodies)
-    for (int i=0;i<int(_rigidBodyDependencies.size());i++)
-    {
-        if (_rigidBodyDependencies[i]==rigidBodyID)
-        {
-            _rigidBodyDependencies.erase(_rigidBodyDependencies.begin()+i);
-            break;
-        }
-    }
-    return(_rigidBodyDependencies.size()==0);
+    if (_rigidBodyDependencyCount>0)
+        _rigidBodyDependencyCount--;
+    return(_rigidBodyDependencyCount==0);
 }
 
-bool CCollShapeDyn::isRigidBodyDependent(int rigidBodyID)
+int CCollShapeDyn::getRigidBodyDependencyCount()
 {
-    for (int i=0;i<int(_rigidBodyDependencies.size());i++)
-    {
-        if (_rigidBodyDependencies[i]==rigidBodyID)
-            return(true);
-    }
-    return(false);
+    return(_rigidBodyDependencyCount);
+}
+
+int CCollShapeDyn::getCollisionShapeListIndex()
+{
+    return(_collisionShapeListIndex);
+}
+
+void CCollShapeDyn::setCollisionShapeListIndex(int index)
+{
+    _collisionShapeListIndex=index;
 }
 
 CDummyGeomProxy* CCollShapeDyn::getGeomData_nullForNonRespondable()
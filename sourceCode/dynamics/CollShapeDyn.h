@@ -12,9 +12,11 @@ public:
 
     int getObjectID();
     void setObjectID(int newID);
-    void addRigidBodyDependency(int rigidBodyID);
-    bool removeRigidBodyDependency(int rigidBodyID);
-    bool isRigidBodyDependent(int rigidBodyID);
+    void addRigidBodyDependency();
+    bool removeRigidBodyDependency();
+    int getRigidBodyDependencyCount();
+    int getCollisionShapeListIndex();
+    void setCollisionShapeListIndex(int index);
     C7Vector getLocalInertiaFrame_scaled();
     C7Vector getInverseLocalInertiaFrame_scaled();
     CDummyGeomProxy* getGeomData_nullForNonRespondable();
@@ -24,7 +26,8 @@ protected:
     C7Vector _localInertiaFrame_scaled;
     C7Vector _inverseLocalInertiaFrame_scaled;
     CDummyGeomProxy* _geomData;
-    std::vector<int> _rigidBodyDependencies;
+    int _rigidBodyDependencyCount; // number of rigid bodies sharing this collision shape
+    int _collisionShapeListIndex; // position in CRigidBodyContainerDyn::_allCollisionShapes
     std::vector<dynReal> _meshVertices_scaled;
     std::vector<int> _meshIndices;
 };
@@ -5,6 +5,8 @@
 
 CConstraintDyn::CConstraintDyn()
 {
+    _motorTargetsSet=false;
+    _constraintID=-1;
 }
 
 CConstraintDyn::~CConstraintDyn()
@@ -20,7 +22,16 @@ void CConstraintDyn::_setPrismaticJointLimits(CDummyJoint* joint)
 }
 
 void CConstraintDyn::_handleRevoluteMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
-{
+{ // engines implement the input and apply parts
+    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
+    float position,error;
+    _getRevoluteMotorControllerInputs(joint,position,error);
+    int auxV=0;
+    if (_dynPassCount==0)
+        auxV|=1;
+    float velocity,force;
+    evaluateMotorController(joint,auxV,passCnt,totalPasses,position,_lastEffortOnJoint,error,velocity,force);
+    _applyRevoluteMotorController(velocity,force);
 }
 
 void CConstraintDyn::_handleRevoluteMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses)
@@ -28,13 +39,42 @@ void CConstraintDyn::_handleRevoluteMotor_controllerDisabled(CDummyJoint* joint,
 }
 
 void CConstraintDyn::_handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
-{
+{ // engines implement the input and apply parts
+    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
+    float position,error;
+    _getPrismaticMotorControllerInputs(joint,position,error);
+    int auxV=0;
+    if (_dynPassCount==0)
+        auxV|=1;
+    float velocity,force;
+    evaluateMotorController(joint,auxV,passCnt,totalPasses,position,_lastEffortOnJoint,error,velocity,force);
+    _applyPrismaticMotorController(velocity,force);
 }
 
 void CConstraintDyn::_handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses)
 {
 }
 
+void CConstraintDyn::_getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
+{
+    position=0.0f;
+    error=0.0f;
+}
+
+void CConstraintDyn::_applyRevoluteMotorController(float velocity,float force)
+{
+}
+
+void CConstraintDyn::_getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
+{
+    position=0.0f;
+    error=0.0f;
+}
+
+void CConstraintDyn::_applyPrismaticMotorController(float velocity,float force)
+{
+}
+
 dynReal CConstraintDyn::getSliderPositionScaled()
 {
     return(0.0);
@@ -61,6 +101,49 @@ void CConstraintDyn::handleMotorControl(CDummyJoint* joint,int passCnt,int total
         _handlePrismaticMotorControl(joint,passCnt,totalPasses);
 }
 
+void CConstraintDyn::handleVelocityMotorControl(CDummyJoint* joint,int jointType,int passCnt,int totalPasses)
+{ // same as handleMotorControl, for a revolute or prismatic joint whose motor is not in position control (i.e. no joint control callback)
+    if (jointType==sim_joint_revolute_subtype)
+    {
+        _setRevoluteJointLimits(joint);
+        if (totalPasses!=0) // execute this part not twice if the joint just got added
+            _handleRevoluteMotor_controllerDisabled(joint,passCnt,totalPasses);
+    }
+    else
+    {
+        _setPrismaticJointLimits(joint);
+        if (totalPasses!=0) // execute this part not twice if the joint just got added
+            _handlePrismaticMotor_controllerDisabled(joint,passCnt,totalPasses);
+    }
+}
+
+void CConstraintDyn::evaluateMotorController(CDummyJoint* joint,int auxValue,int passCnt,int totalPasses,float position,float effort,float error,float& velocity,float& force)
+{ // the simulator evaluates the built-in controller, or the joint callback
+    int inputValuesInt[5];
+    inputValuesInt[0]=passCnt;
+    inputValuesInt[1]=totalPasses;
+    inputValuesInt[2]=0; // reserved for future ext.
+    inputValuesInt[3]=0; // reserved for future ext.
+    inputValuesInt[4]=0; // reserved for future ext.
+    float inputValuesFloat[7];
+    inputValuesFloat[0]=position;
+    inputValuesFloat[1]=effort;
+    inputValuesFloat[2]=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
+    inputValuesFloat[3]=error;
+    inputValuesFloat[4]=0.0f; // reserved for future ext.
+    inputValuesFloat[5]=0.0f; // reserved for future ext.
+    inputValuesFloat[6]=0.0f; // reserved for future ext.
+    float outputValues[5];
+    _simHandleJointControl(joint,auxValue,inputValuesInt,inputValuesFloat,outputValues);
+    velocity=outputValues[0];
+    force=outputValues[1];
+}
+
+bool CConstraintDyn::isMotorPositionControlled(CDummyJoint* joint)
+{ // position control goes through _simHandleJointControl (built-in PID or joint callback)
+    return(_simIsDynamicMotorEnabled(joint)&&_simIsDynamicMotorPositionCtrlEnabled(joint));
+}
+
 void CConstraintDyn::_handleRevoluteMotorControl(CDummyJoint* joint,int passCnt,int totalPasses)
 { // Here we set joint limits, activate/deactivate motors, and do the control of the motors:
 
@@ -266,6 +349,67 @@ void CConstraintDyn::incrementDynPassCounter()
     _dynPassCount++;
 }
 
+void CConstraintDyn::getState(SConstraintState& state)
+{
+    state.lastJointPos=_lastJointPos;
+    state.jointPosAlt=_jointPosAlt;
+    state.lastEffortOnJoint=_lastEffortOnJoint;
+    state.targetPositionToHoldAtZeroVel=_targetPositionToHoldAtZeroVel_velocityMode;
+    state.dynPassCount=_dynPassCount;
+    state.lastJointPosSet=_lastJointPosSet;
+    state.targetPositionToHoldAtZeroVelOn=_targetPositionToHoldAtZeroVelOn_velocityMode;
+}
+
+void CConstraintDyn::setState(const SConstraintState& state)
+{
+    _lastJointPos=state.lastJointPos;
+    _jointPosAlt=state.jointPosAlt;
+    _lastEffortOnJoint=state.lastEffortOnJoint;
+    _targetPositionToHoldAtZeroVel_velocityMode=state.targetPositionToHoldAtZeroVel;
+    _dynPassCount=state.dynPassCount;
+    _lastJointPosSet=state.lastJointPosSet;
+    _targetPositionToHoldAtZeroVelOn_velocityMode=state.targetPositionToHoldAtZeroVelOn;
+}
+
+float CConstraintDyn::getPositionalError(bool ignoreAxis)
+{ // distance between the constraint frame seen from the parent body and seen from the child body (unscaled)
+  // With ignoreAxis (prismatic joints), the offset along the joint axis is the joint position and not an error
+    C7Vector p(_parentBody->getShapeFrameTransformation()*_initialLocalTransform);
+    C7Vector c(_childBody->getShapeFrameTransformation());
+    if (_jointOrForceSensorLoopClosureLinkedDummyAChildID!=-1)
+        c=c*_linkedDummyBInitialLocalTransform*_linkedDummyAInitialLocalTransform.getInverse(); // special case (looped)
+    else
+        c=c*_secondInitialLocalTransform; // regular case (non-looped)
+    C3Vector d((p.getInverse()*c).X);
+    if (ignoreAxis)
+        d(2)=0.0f;
+    return(d.getLength());
+}
+
+bool CConstraintDyn::motorTargetChanged(CDummyJoint* joint)
+{ // true if the motor got enabled/disabled or got a new target since the last call
+    float targets[4];
+    targets[0]=float(_simIsDynamicMotorEnabled(joint)!=0);
+    targets[1]=float(_simIsDynamicMotorPositionCtrlEnabled(joint)!=0);
+    targets[2]=_simGetDynamicMotorTargetVelocity(joint);
+    targets[3]=_simGetDynamicMotorTargetPosition(joint);
+    bool retVal=!_motorTargetsSet;
+    for (int i=0;i<4;i++)
+    {
+        if (targets[i]!=_lastMotorTargets[i])
+            retVal=true;
+        _lastMotorTargets[i]=targets[i];
+    }
+    _motorTargetsSet=true;
+    return(retVal);
+}
+
+void CConstraintDyn::wakeUpBodies()
+{
+    _parentBody->wakeUp();
+    _childBody->wakeUp();
+}
+
 dynReal CConstraintDyn::getAngleMinusAlpha(dynReal angle,dynReal alpha)
 {    // Returns angle-alpha. Angle and alpha are cyclic angles!!
     dynReal sinAngle0 = sinf (angle);
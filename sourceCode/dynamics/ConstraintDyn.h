@@ -4,6 +4,17 @@
 #include "RigidBodyDyn.h"
 #include "7Vector.h"
 
+struct SConstraintState
+{ // what the motor control keeps from one step to the next
+    dynReal lastJointPos;
+    dynReal jointPosAlt;
+    dynReal lastEffortOnJoint;
+    dynReal targetPositionToHoldAtZeroVel;
+    int dynPassCount;
+    bool lastJointPosSet;
+    bool targetPositionToHoldAtZeroVelOn;
+};
+
 class CConstraintDyn  
 {
 public:
@@ -27,6 +38,11 @@ public:
     bool getIsJoint();
     bool announceBodyWillBeDestroyed(int bodyID);
     void incrementDynPassCounter();
+    void getState(SConstraintState& state);
+    void setState(const SConstraintState& state);
+    float getPositionalError(bool ignoreAxis);
+    bool motorTargetChanged(CDummyJoint* joint);
+    void wakeUpBodies();
 
     void reportConfigurationToJoint(CDummyJoint* joint,CDummyDummy* linkedDummyA,CDummyDummy* linkedDummyB,bool doNotApplyJointIntrinsicPosition);//,CRigidBodyDyn* parentBody,CRigidBodyDyn* childBody);
     void reportSecondPartConfigurationToJoint(CDummyJoint* joint);
@@ -34,6 +50,9 @@ public:
     void reportSecondPartConfigurationToForceSensor(CDummyForceSensor* forceSensor);
 
     void handleMotorControl(CDummyJoint* joint,int passCnt,int totalPasses);
+    void handleVelocityMotorControl(CDummyJoint* joint,int jointType,int passCnt,int totalPasses);
+    bool isMotorPositionControlled(CDummyJoint* joint);
+    static void evaluateMotorController(CDummyJoint* joint,int auxValue,int passCnt,int totalPasses,float position,float effort,float error,float& velocity,float& force);
 
 protected:
     virtual void _setRevoluteJointLimits(CDummyJoint* joint);
@@ -42,6 +61,10 @@ protected:
     virtual void _handleRevoluteMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses);
     virtual void _handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses);
     virtual void _handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses);
+    virtual void _getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error);
+    virtual void _applyRevoluteMotorController(float velocity,float force);
+    virtual void _getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error);
+    virtual void _applyPrismaticMotorController(float velocity,float force);
 
     void _handleRevoluteMotorControl(CDummyJoint* joint,int passCnt,int totalPasses);
     void _handlePrismaticMotorControl(CDummyJoint* joint,int passCnt,int totalPasses);
@@ -79,6 +102,9 @@ protected:
     int _bodyAID;
     int _bodyBID;
 
+    bool _motorTargetsSet;
+    float _lastMotorTargets[4]; // enabled, position control enabled, target velocity, target position
+
     CRigidBodyDyn* _parentBody;
     CRigidBodyDyn* _childBody;
 
@@ -0,0 +1,205 @@
+#include "ContactArena.h"
+#include "simLib.h"
+#include <algorithm>
+
+CContactArena::CContactArena() : _allocationCount(0)
+{
+    _count=0;
+}
+
+CContactArena::~CContactArena()
+{
+}
+
+void CContactArena::clear()
+{ // we keep the capacity
+    _count=0;
+    _passIndices.clear();
+    _objectIDs.clear();
+    _objectOffsets.clear();
+    _objectContacts.clear();
+}
+
+void CContactArena::addContact(const SContactInfo& contact)
+{
+    if (_count>=int(_subPassNumbers.size()))
+        _reserve(2*_count+64);
+    _subPassNumbers[_count]=contact.subPassNumber;
+    _objectIDs1[_count]=contact.objectID1;
+    _objectIDs2[_count]=contact.objectID2;
+    for (int i=0;i<3;i++)
+    {
+        _positions[3*_count+i]=contact.position(i);
+        _surfaceNormals[3*_count+i]=contact.surfaceNormal(i);
+        _directionsAndAmplitudes[3*_count+i]=contact.directionAndAmplitude(i);
+    }
+    _count++;
+}
+
+int CContactArena::getCount()
+{
+    return(_count);
+}
+
+void CContactArena::swap(CContactArena& other)
+{ // constant time, buffers are exchanged. The allocation counts stay, what matters is their sum
+    std::swap(_count,other._count);
+    _subPassNumbers.swap(other._subPassNumbers);
+    _objectIDs1.swap(other._objectIDs1);
+    _objectIDs2.swap(other._objectIDs2);
+    _positions.swap(other._positions);
+    _surfaceNormals.swap(other._surfaceNormals);
+    _directionsAndAmplitudes.swap(other._directionsAndAmplitudes);
+    _passIndices.swap(other._passIndices);
+    _objectIDs.swap(other._objectIDs);
+    _objectOffsets.swap(other._objectOffsets);
+    _objectContacts.swap(other._objectContacts);
+    _indexScratch.swap(other._indexScratch);
+}
+
+void CContactArena::indexLastPass(int pass)
+{ // contacts are appended pass after pass. Index the ones added since the last call
+    SContactPassIndex passIndex;
+    passIndex.subPassNumber=pass;
+    passIndex.firstContact=0;
+    if (_passIndices.size()>0)
+        passIndex.firstContact=_passIndices[_passIndices.size()-1].firstContact+_passIndices[_passIndices.size()-1].contactCount;
+    passIndex.contactCount=_count-passIndex.firstContact;
+    passIndex.firstObject=int(_objectIDs.size());
+
+    // Reserve first, so that the growth is counted. There are at most 2 entries per contact:
+    size_t maxEntries=size_t(2*passIndex.contactCount);
+    reserveCounted(_passIndices,_passIndices.size()+1);
+    reserveCounted(_indexScratch,maxEntries);
+    reserveCounted(_objectIDs,_objectIDs.size()+maxEntries);
+    reserveCounted(_objectOffsets,_objectOffsets.size()+maxEntries);
+    reserveCounted(_objectContacts,_objectContacts.size()+maxEntries);
+    _indexScratch.clear();
+    for (int i=passIndex.firstContact;i<_count;i++)
+    {
+        _indexScratch.push_back(std::make_pair(_objectIDs1[i],i));
+        if (_objectIDs2[i]!=_objectIDs1[i])
+            _indexScratch.push_back(std::make_pair(_objectIDs2[i],i));
+    }
+    std::sort(_indexScratch.begin(),_indexScratch.end()); // by object, then by contact order
+    for (int i=0;i<int(_indexScratch.size());i++)
+    {
+        if ( (i==0)||(_indexScratch[i].first!=_indexScratch[i-1].first) )
+        {
+            _objectIDs.push_back(_indexScratch[i].first);
+            _objectOffsets.push_back(int(_objectContacts.size()));
+        }
+        _objectContacts.push_back(_indexScratch[i].second);
+    }
+    passIndex.objectCount=int(_objectIDs.size())-passIndex.firstObject;
+    _passIndices.push_back(passIndex);
+}
+
+int CContactArena::getPassCount()
+{
+    return(int(_passIndices.size()));
+}
+
+const SContactPassIndex& CContactArena::getPassIndex(int pass)
+{
+    return(_passIndices[pass]);
+}
+
+int CContactArena::getObjectRange(const SContactPassIndex& passIndex,int objectHandle,int& count)
+{ // returns the start position (see getObjectContact) of the contacts of objectHandle in that pass
+    count=0;
+    std::vector<int>::iterator begin=_objectIDs.begin()+passIndex.firstObject;
+    std::vector<int>::iterator end=begin+passIndex.objectCount;
+    std::vector<int>::iterator it=std::lower_bound(begin,end,objectHandle);
+    if ( (it==end)||(*it!=objectHandle) )
+        return(0);
+    int objectPos=int(it-_objectIDs.begin());
+    int start=_objectOffsets[objectPos];
+    if (objectPos+1<int(_objectOffsets.size()))
+        count=_objectOffsets[objectPos+1]-start;
+    else
+        count=int(_objectContacts.size())-start;
+    return(start);
+}
+
+int CContactArena::getObjectContact(int position)
+{
+    return(_objectContacts[position]);
+}
+
+int CContactArena::getIndexedContact(int dynamicPass,int objectHandle,int index)
+{ // returns the index of the index-th contact of objectHandle, or -1
+    for (int p=0;p<int(_passIndices.size());p++)
+    {
+        const SContactPassIndex& passIndex=_passIndices[p];
+        if ( (passIndex.subPassNumber==dynamicPass)||(dynamicPass==sim_handle_all) )
+        {
+            if (objectHandle==sim_handle_all)
+            {
+                if (index<passIndex.contactCount)
+                    return(passIndex.firstContact+index);
+                index-=passIndex.contactCount;
+            }
+            else
+            {
+                int count;
+                int start=getObjectRange(passIndex,objectHandle,count);
+                if (index<count)
+                    return(_objectContacts[start+index]);
+                index-=count;
+            }
+        }
+    }
+    return(-1);
+}
+
+int CContactArena::getSubPassNumber(int index)
+{
+    return(_subPassNumbers[index]);
+}
+
+int CContactArena::getObjectID1(int index)
+{
+    return(_objectIDs1[index]);
+}
+
+int CContactArena::getObjectID2(int index)
+{
+    return(_objectIDs2[index]);
+}
+
+const float* CContactArena::getPosition(int index)
+{
+    return(&_positions[3*index]);
+}
+
+const float* CContactArena::getSurfaceNormal(int index)
+{
+    return(&_surfaceNormals[3*index]);
+}
+
+const float* CContactArena::getDirectionAndAmplitude(int index)
+{
+    return(&_directionsAndAmplitudes[3*index]);
+}
+
+void CContactArena::countAllocation()
+{
+    _allocationCount.fetch_add(1,std::memory_order_relaxed); // also called from _asyncStepThread
+}
+
+unsigned int CContactArena::getAllocationCount()
+{
+    return(_allocationCount.load(std::memory_order_relaxed));
+}
+
+void CContactArena::_reserve(int count)
+{
+    _subPassNumbers.resize(count);
+    _objectIDs1.resize(count);
+    _objectIDs2.resize(count);
+    _positions.resize(3*count);
+    _surfaceNormals.resize(3*count);
+    _directionsAndAmplitudes.resize(3*count);
+    countAllocation();
+}
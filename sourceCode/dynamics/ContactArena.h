@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include "3Vector.h"
+
+struct SContactInfo
+{
+    int subPassNumber;
+    int objectID1;
+    int objectID2;
+    C3Vector position;
+    C3Vector surfaceNormal;
+    C3Vector directionAndAmplitude;
+};
+
+struct SContactPassIndex
+{ // contacts of one sub-pass, indexed by object (CSR-style)
+    int subPassNumber;
+    int firstContact;
+    int contactCount;
+    int firstObject; // in _objectIDs and _objectOffsets
+    int objectCount;
+};
+
+class CContactArena
+{ // contacts of one simulation step, stored as structure of arrays. Capacity is kept from step to step
+public:
+    CContactArena();
+    virtual ~CContactArena();
+
+    void clear();
+    void addContact(const SContactInfo& contact);
+    int getCount();
+    void swap(CContactArena& other);
+
+    void indexLastPass(int pass);
+    int getPassCount();
+    const SContactPassIndex& getPassIndex(int pass);
+    int getObjectRange(const SContactPassIndex& passIndex,int objectHandle,int& count);
+    int getObjectContact(int position);
+    int getIndexedContact(int dynamicPass,int objectHandle,int index);
+
+    int getSubPassNumber(int index);
+    int getObjectID1(int index);
+    int getObjectID2(int index);
+    const float* getPosition(int index);
+    const float* getSurfaceNormal(int index);
+    const float* getDirectionAndAmplitude(int index);
+
+    void countAllocation();
+    unsigned int getAllocationCount();
+
+    template<class T> void reserveCounted(std::vector<T>& v,size_t size)
+    { // all containers of the contact path grow through here (geometrically), so that each growth is counted
+        if (size>v.capacity())
+        {
+            if (size<2*v.capacity())
+                size=2*v.capacity();
+            v.reserve(size);
+            countAllocation();
+        }
+    }
+
+private:
+    void _reserve(int count);
+
+    int _count; // the arrays below have at least that many valid entries
+    std::vector<int> _subPassNumbers;
+    std::vector<int> _objectIDs1;
+    std::vector<int> _objectIDs2;
+    std::vector<float> _positions; // 3 values per contact
+    std::vector<float> _surfaceNormals; // 3 values per contact
+    std::vector<float> _directionsAndAmplitudes; // 3 values per contact
+
+    std::vector<SContactPassIndex> _passIndices; // one per sub-pass, built after each _stepDynamics
+    std::vector<int> _objectIDs; // sorted within a sub-pass
+    std::vector<int> _objectOffsets; // start of each object above in _objectContacts
+    std::vector<int> _objectContacts; // contact indices, in contact order within an object
+    std::vector<std::pair<int,int> > _indexScratch;
+
+    std::atomic<unsigned int> _allocationCount; // heap allocations done by the contact pipeline (arena and index growth, contact points, contact batch, ODE feedback structures, etc.)
+};
@@ -1,9 +1,10 @@
 #include "ParticleContainer.h"
+#include "RigidBodyContainerDyn.h"
 #include "simLib.h"
 
 CParticleContainer::CParticleContainer()
 {
-    
+    _nextUniqueID=0;
 }
 
 CParticleContainer::~CParticleContainer()
@@ -28,12 +29,20 @@ CParticleObject* CParticleContainer::getObject(int objectID,bool getAlsoTheOnesF
     return(nullptr);
 }
 
+int CParticleContainer::getObjectCount()
+{ // including the nullptr slots
+    return(int(_allObjects.size()));
+}
+
 int CParticleContainer::addObject(CParticleObject* it)
 {
     int newID=0;
     while (getObject(newID,true)!=nullptr)
         newID++;
     it->setObjectID(newID);
+    it->setUniqueID(_nextUniqueID++);
+    if (CRigidBodyContainerDyn::getParticleEngine()==dyn_particleengine_soa)
+        it->setParticleSystem(&_particleSystem);
     if (newID>=int(_allObjects.size()))
         _allObjects.push_back(nullptr);
     _allObjects[newID]=it;
@@ -93,13 +102,20 @@ bool CParticleContainer::addParticlesIfNeeded()
     return(particlesPresent);
 }
 
-void CParticleContainer::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity)
-{
+int CParticleContainer::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity)
+{ // returns the number of particles handled
+    int cnt=0;
     for (int i=0;i<int(_allObjects.size());i++)
     {
         if ( (_allObjects[i]!=nullptr)&&(!_allObjects[i]->isFlaggedForDestruction()) )
-            _allObjects[i]->handleAntiGravityForces_andFluidFrictionForces(gravity);
+            cnt+=_allObjects[i]->handleAntiGravityForces_andFluidFrictionForces(gravity);
     }
+    return(cnt);
+}
+
+void CParticleContainer::stepParticleSystem(CRigidBodyContainerDyn* container,float dt,const C3Vector& gravity)
+{
+    _particleSystem.step(container,dt,gravity);
 }
 
 void CParticleContainer::removeKilledParticles()
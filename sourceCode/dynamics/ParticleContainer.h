@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "ParticleObject.h"
+#include "ParticleSystem.h"
 
 class CParticleContainer
 {
@@ -11,6 +12,7 @@ public:
 
     int addObject(CParticleObject* it);
     CParticleObject* getObject(int objectID,bool getAlsoTheOnesFlaggedForDestruction);
+    int getObjectCount();
     void removeAllObjects();
     void removeObject(int objectID);
     void** getParticles(int index,int* particlesCount,int* objectType,float** cols);
@@ -20,8 +22,11 @@ public:
     void removeAllParticles();
     void updateParticlesPosition(float simulationTime);
 
-    void handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity);
+    int handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity);
+    void stepParticleSystem(CRigidBodyContainerDyn* container,float dt,const C3Vector& gravity);
 
 private:
     std::vector<CParticleObject*> _allObjects; // can contain nullptr!
+    CParticleSystem _particleSystem; // particles of the objects added in dyn_particleengine_soa mode
+    unsigned int _nextUniqueID; // object IDs get reused, unique IDs not
 };
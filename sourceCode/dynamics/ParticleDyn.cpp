@@ -11,6 +11,7 @@ CParticleDyn::CParticleDyn(const C3Vector& position,const C3Vector& velocity,int
     _objectType=objType;
     _size=size;
     _massOverVolume=massOverVolume;
+    _mass=massOverVolume*((piValue*size*size*size)/6.0f);
     _killTime=killTime;
     if (addColor!=nullptr)
     {
@@ -29,8 +30,8 @@ bool CParticleDyn::addToEngineIfNeeded(float parameters[18],int objectID)
     return(false);
 }
 
-void CParticleDyn::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
-{
+void CParticleDyn::applyFluidForce(const C3Vector& force)
+{ // scaled. Anti-gravity and fluid friction force of the coming pass, see CParticleObject::handleAntiGravityForces_andFluidFrictionForces
 }
 
 void CParticleDyn::removeFromEngine()
@@ -41,11 +42,34 @@ void CParticleDyn::updatePosition()
 {
 }
 
+C3Vector CParticleDyn::getVelocity()
+{ // not scaled. Engines return the current velocity once the particle was added to them
+    return(_initialVelocityVector);
+}
+
+void CParticleDyn::getState(SParticleState& state)
+{
+    _currentPosition.getInternalData(state.position);
+    getVelocity().getInternalData(state.velocity);
+    state.size=_size;
+    state.massOverVolume=_massOverVolume;
+    state.killTime=_killTime;
+    state.additionalColor[0]=_additionalColor[0];
+    state.additionalColor[1]=_additionalColor[1];
+    state.additionalColor[2]=_additionalColor[2];
+    state.uniqueID=_uniqueID;
+}
+
 bool CParticleDyn::didTimeOut(float simulationTime)
 {
     return(simulationTime>_killTime);
 }
 
+float CParticleDyn::getKillTime()
+{
+    return(_killTime);
+}
+
 int CParticleDyn::getInitializationState()
 {
     return(_initializationState);
@@ -61,6 +85,16 @@ void CParticleDyn::setUniqueID(int id)
     _uniqueID=id;
 }
 
+C3Vector CParticleDyn::getPosition()
+{ // not scaled
+    return(_currentPosition);
+}
+
+float CParticleDyn::getMass()
+{ // not scaled
+    return(_mass);
+}
+
 bool CParticleDyn::getRenderData(float* pos,float* size,int* objType,float** additionalColor)
 {
     if (_initializationState==1)
@@ -2,6 +2,17 @@
 
 #include "3Vector.h"
 
+struct SParticleState
+{ // not scaled
+    float position[3];
+    float velocity[3];
+    float size;
+    float massOverVolume;
+    float killTime;
+    float additionalColor[3];
+    int uniqueID;
+};
+
 class CParticleDyn
 {
 public:
@@ -10,15 +21,20 @@ public:
     virtual ~CParticleDyn();
 
     virtual bool addToEngineIfNeeded(float parameters[18],int objectID);
-    virtual void handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff);
+    virtual void applyFluidForce(const C3Vector& force);
     virtual void updatePosition();
     virtual void removeFromEngine();
+    virtual C3Vector getVelocity();
 
     bool didTimeOut(float simulationTime);
+    float getKillTime();
     int getInitializationState();
     int getUniqueID();
     void setUniqueID(int id);
     bool getRenderData(float* pos,float* size,int* objType,float** additionalColor);
+    C3Vector getPosition();
+    float getMass();
+    void getState(SParticleState& state);
 
 protected:    
     int _uniqueID;
@@ -28,6 +44,7 @@ protected:
     int _objectType;
     float _size;
     float _massOverVolume;
+    float _mass; // not scaled
     float _killTime;
     float _additionalColor[3];
 };
@@ -0,0 +1,46 @@
+#include "ParticleDyn_soa.h"
+#include "ParticleSystem.h"
+#include "ParticleObject.h"
+
+CParticleDyn_soa::CParticleDyn_soa(const C3Vector& position,const C3Vector& velocity,int objType,float size,float massOverVolume,float killTime,float addColor[3],CParticleSystem* particleSystem,CParticleObject* particleObject) : CParticleDyn(position,velocity,objType,size,massOverVolume,killTime,addColor)
+{
+    _particleSystem=particleSystem;
+    _particleObject=particleObject;
+    _particleIndex=-1;
+}
+
+CParticleDyn_soa::~CParticleDyn_soa()
+{ // particle objects can be destroyed without removing their particles first (e.g. when the Newton world is destroyed)
+    removeFromEngine();
+}
+
+bool CParticleDyn_soa::addToEngineIfNeeded(float parameters[18],int objectID)
+{ // return value indicates if there are particles that need to be simulated
+    if (_initializationState!=0)
+        return(_initializationState==1);
+    _initializationState=1;
+    _particleIndex=_particleSystem->addParticle(_particleObject,_currentPosition,_initialVelocityVector,_size,_massOverVolume);
+    return(true);
+}
+
+void CParticleDyn_soa::removeFromEngine()
+{
+    if (_initializationState==1)
+    {
+        _particleSystem->removeParticle(_particleIndex);
+        _initializationState=2;
+    }
+}
+
+void CParticleDyn_soa::updatePosition()
+{
+    if (_initializationState==1)
+        _currentPosition=_particleSystem->getPosition(_particleIndex);
+}
+
+C3Vector CParticleDyn_soa::getVelocity()
+{
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    return(_particleSystem->getVelocity(_particleIndex));
+}
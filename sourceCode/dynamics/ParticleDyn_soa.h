@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ParticleDyn.h"
+
+class CParticleSystem;
+class CParticleObject;
+
+class CParticleDyn_soa : public CParticleDyn
+{ // dyn_particleengine_soa: the particle lives in a CParticleSystem, not in the physics engine
+public:
+    CParticleDyn_soa(const C3Vector& position,const C3Vector& velocity,int objType,float size,float massOverVolume,float killTime,float addColor[3],CParticleSystem* particleSystem,CParticleObject* particleObject);
+    virtual ~CParticleDyn_soa();
+
+    bool addToEngineIfNeeded(float parameters[18],int objectID);
+    void updatePosition();
+    void removeFromEngine();
+    C3Vector getVelocity();
+
+protected:    
+    CParticleSystem* _particleSystem;
+    CParticleObject* _particleObject;
+    int _particleIndex; // in _particleSystem
+};
@@ -1,5 +1,9 @@
 #include "ParticleObject.h"
+#include "ParticleDyn_soa.h"
+#include "RigidBodyContainerDyn.h"
 #include "simLib.h"
+#include <algorithm>
+#include <cmath>
 #ifdef INCLUDE_BULLET_2_78_CODE
 #include "ParticleDyn_bullet278.h"
 #endif
@@ -19,6 +23,7 @@
 CParticleObject::CParticleObject(int theObjectType,float size,float massVolumic,const void* params,float lifeTime,int maxItemCount)
 {
     _objectID=0;
+    _uniqueID=0;
     if (size>100.0f)
         size=100.0f;
     _size=size;
@@ -33,6 +38,12 @@ CParticleObject::CParticleObject(int theObjectType,float size,float massVolumic,
     _objectType=theObjectType;
     _nextUniqueIDForParticle=0;
     _flaggedForDestruction=false;
+    _particleSystem=nullptr;
+    _killWheelTickDuration=0.05f;
+    if (_particlesLifeTime>0.0f)
+        _killWheelTickDuration=_particlesLifeTime/16.0f; // the wheel spans 4 lifetimes
+    _killWheelLastTick=0;
+    _renderFrame=1;
     parameters[0]=0.0f; // Bullet friction
     parameters[1]=0.0f; // Bullet restitution
     parameters[2]=0.0f; // ODE friction
@@ -125,6 +136,26 @@ int CParticleObject::getObjectID()
     return(_objectID);
 }
 
+void CParticleObject::setUniqueID(unsigned int id)
+{ // see CParticleContainer::addObject
+    _uniqueID=id;
+}
+
+unsigned int CParticleObject::getUniqueID()
+{
+    return(_uniqueID);
+}
+
+int CParticleObject::getObjectType()
+{
+    return(_objectType);
+}
+
+void CParticleObject::setParticleSystem(CParticleSystem* particleSystem)
+{ // before particles are added
+    _particleSystem=particleSystem;
+}
+
 int CParticleObject::getOtherFloatsPerItem()
 {
     int retVal=0;
@@ -140,78 +171,54 @@ int CParticleObject::getOtherFloatsPerItem()
 void CParticleObject::addParticle(float simulationTime,const float* itemData)
 {
     if (itemData==nullptr)
-    { // We wanna remove all particles!
-        for (int i=0;i<int(_particles.size());i++)
+    { // We wanna remove all particles! The slots stay (empty), so that renderers see the removal
+        _clearSlots();
+        for (int i=int(_particles.size())-1;i>=0;i--)
         {
             if (_particles[i]!=nullptr)
-            {
-                if (_particles[i]->getInitializationState()==1)
-                    _particlesToDestroy.push_back(_particles[i]); // This still needs removal from the physics engine!
-                else
-                    delete _particles[i]; // ok to delete it here
-            }
-        }
-        _particles.clear();
-        return;
-    }
-    
-    // Now we first wanna remove particles that have timed out or that are not active anymore:
-    int oldestIndex=-1;
-    int firstFreeIndex=-1;
-    int smallestUniqueID=_nextUniqueIDForParticle+2;
-    for (int i=0;i<int(_particles.size());i++)
-    {
-        if (_particles[i]!=nullptr)
-        {
-            if ( _particles[i]->didTimeOut(simulationTime)||(_particles[i]->getInitializationState()==2) )
-            { // We have to remove this one from _particles:
-                if (_particles[i]->getInitializationState()==1)
-                    _particlesToDestroy.push_back(_particles[i]); // We cannot destroy this one now
-                else
-                    delete _particles[i]; // We can directly destroy this one here
-                _particles[i]=nullptr;
-                if (firstFreeIndex==-1)
-                    firstFreeIndex=i;
-            }
+                _releaseSlot(i); // This might still need removal from the physics engine!
             else
-            { // this one stays a bit more (or will be removed just after if the list is full))
-                int uniqueID=_particles[i]->getUniqueID();
-                if (smallestUniqueID>uniqueID)
-                {
-                    smallestUniqueID=uniqueID;
-                    oldestIndex=i;
-                }
-            }
-        }
-        else
-        {
-            if (firstFreeIndex==-1)
-                firstFreeIndex=i;
+                _freeSlots.push_back(i);
         }
+        return;
     }
+    _expireParticles(simulationTime);
+    _addParticle(simulationTime,itemData);
+}
 
-    int positionToAddNewParticle=firstFreeIndex;
-    
-    if (positionToAddNewParticle==-1)
+void CParticleObject::addParticles(float simulationTime,int itemCount,const float* itemData)
+{ // itemData: itemCount items of 6+getOtherFloatsPerItem() floats
+    _expireParticles(simulationTime);
+    int stride=6+getOtherFloatsPerItem();
+    for (int i=0;i<itemCount;i++)
+        _addParticle(simulationTime,itemData+i*stride);
+}
+
+void CParticleObject::_addParticle(float simulationTime,const float* itemData)
+{ // timed out particles were already removed
+    if (_freeSlots.size()==0)
     { // we don't have a free spot anymore:
         if (int(_particles.size())>=_maxItemCount)
         { // the buffer is full
-            if (_objectType&sim_particle_cyclic)
-            { // the buffer is cyclic. We remove the oldest element:
-                _particlesToDestroy.push_back(_particles[oldestIndex]);
-                _particles[oldestIndex]=nullptr;
-                positionToAddNewParticle=oldestIndex;
-            }
-            else
+            if ((_objectType&sim_particle_cyclic)==0)
                 return; // saturated
+            // the buffer is cyclic. We remove the oldest element:
+            while ( (_emissionOrder.size()!=0)&&(!_isSlotCurrent(_emissionOrder.front())) )
+                _emissionOrder.pop_front();
+            if (_emissionOrder.size()==0)
+                return;
+            _releaseSlot(_emissionOrder.front().slot);
+            _emissionOrder.pop_front();
         }
         else
         { // The buffer is not yet full!
-            positionToAddNewParticle=_particles.size();
+            _freeSlots.push_back(int(_particles.size()));
             _particles.push_back(nullptr);
+            _slotChangeFrames.push_back(_renderFrame);
         }
     }
-
+    int slot=_freeSlots[_freeSlots.size()-1];
+    _freeSlots.pop_back();
 
     float size=_size;
     float massOverVolume=_massVolumic;
@@ -235,27 +242,166 @@ void CParticleObject::addParticle(float simulationTime,const float* itemData)
     C3Vector pos(itemData);
     C3Vector vel(itemData+3);
     vel-=pos;
+    _particles[slot]=_createParticle(pos,vel,size,massOverVolume,killTime,additionalColor);
+    _particles[slot]->setUniqueID(_nextUniqueIDForParticle++);
+    _slotChangeFrames[slot]=_renderFrame;
+    _registerParticle(slot);
+}
+
+void CParticleObject::_registerParticle(int slot)
+{ // adds a new particle to the emission order and to the timing wheel
+    SParticleSlotRef ref;
+    ref.slot=slot;
+    ref.uniqueID=_particles[slot]->getUniqueID();
+    ref.killTime=_particles[slot]->getKillTime();
+    if (_objectType&sim_particle_cyclic)
+    {
+        _emissionOrder.push_back(ref);
+        if (int(_emissionOrder.size())>2*_maxItemCount+64)
+        { // too many stale entries (e.g. particles restored out of order). Compact:
+            std::deque<SParticleSlotRef> order;
+            for (int i=0;i<int(_emissionOrder.size());i++)
+            {
+                if (_isSlotCurrent(_emissionOrder[i]))
+                    order.push_back(_emissionOrder[i]);
+            }
+            _emissionOrder.swap(order);
+        }
+    }
+    if (ref.killTime!=SIM_MAX_FLOAT)
+        _killWheel[((long long)(ref.killTime/_killWheelTickDuration))&(dyn_particle_killwheelsize-1)].push_back(ref);
+}
+
+void CParticleObject::_releaseSlot(int slot)
+{
+    if (_particles[slot]->getInitializationState()==1)
+        _particlesToDestroy.push_back(_particles[slot]); // We cannot destroy this one now
+    else
+        delete _particles[slot]; // We can directly destroy this one here
+    _particles[slot]=nullptr;
+    _slotChangeFrames[slot]=_renderFrame;
+    _freeSlots.push_back(slot);
+}
+
+bool CParticleObject::_isSlotCurrent(const SParticleSlotRef& ref)
+{
+    return( (_particles[ref.slot]!=nullptr)&&(_particles[ref.slot]->getUniqueID()==ref.uniqueID) );
+}
+
+void CParticleObject::_expireParticles(float simulationTime)
+{ // timing wheel: only the buckets of the ticks since the last call are visited. Entries of later rounds stay
+    long long tick=(long long)(simulationTime/_killWheelTickDuration);
+    long long firstTick=_killWheelLastTick;
+    if ( (firstTick>tick)||(tick-firstTick>=dyn_particle_killwheelsize) )
+        firstTick=tick-dyn_particle_killwheelsize+1; // time went back, or we visit all buckets anyway
+    for (long long t=firstTick;t<=tick;t++)
+    {
+        std::vector<SParticleSlotRef>& bucket=_killWheel[t&(dyn_particle_killwheelsize-1)];
+        for (int i=0;i<int(bucket.size());)
+        {
+            bool current=_isSlotCurrent(bucket[i]);
+            if ( (!current)||(simulationTime>bucket[i].killTime) )
+            {
+                if (current)
+                    _releaseSlot(bucket[i].slot);
+                bucket[i]=bucket[bucket.size()-1];
+                bucket.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+    _killWheelLastTick=tick; // the current tick is visited again next time
+    while ( (_emissionOrder.size()!=0)&&(!_isSlotCurrent(_emissionOrder.front())) )
+        _emissionOrder.pop_front();
+}
+
+void CParticleObject::_clearSlots()
+{
+    _freeSlots.clear();
+    _emissionOrder.clear();
+    for (int i=0;i<dyn_particle_killwheelsize;i++)
+        _killWheel[i].clear();
+}
+
+CParticleDyn* CParticleObject::_createParticle(const C3Vector& pos,const C3Vector& vel,float size,float massOverVolume,float killTime,float* additionalColor)
+{
+    if (_particleSystem!=nullptr)
+        return(new CParticleDyn_soa(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor,_particleSystem,this));
+
+    CParticleDyn* retVal=nullptr;
 #ifdef INCLUDE_BULLET_2_78_CODE
-    _particles[positionToAddNewParticle]=new CParticleDyn_bullet278(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
+    retVal=new CParticleDyn_bullet278(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
 #endif
 
 #ifdef INCLUDE_BULLET_2_83_CODE
-    _particles[positionToAddNewParticle]=new CParticleDyn_bullet283(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
+    retVal=new CParticleDyn_bullet283(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
 #endif
 
 #ifdef INCLUDE_ODE_CODE
-    _particles[positionToAddNewParticle]=new CParticleDyn_ode(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
+    retVal=new CParticleDyn_ode(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
 #endif
 
 #ifdef INCLUDE_NEWTON_CODE
-    _particles[positionToAddNewParticle]=new CParticleDyn_newton(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
+    retVal=new CParticleDyn_newton(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
 #endif
 
 #ifdef INCLUDE_VORTEX_CODE
-    _particles[positionToAddNewParticle]=new CParticleDyn_vortex(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
+    retVal=new CParticleDyn_vortex(pos,vel,_objectType,size,massOverVolume,killTime,additionalColor);
 #endif
+    return(retVal);
+}
 
-    _particles[positionToAddNewParticle]->setUniqueID(_nextUniqueIDForParticle++);
+void CParticleObject::getParticleStates(std::vector<SParticleState>& states)
+{ // appends the live particles
+    for (int i=0;i<int(_particles.size());i++)
+    {
+        if ( (_particles[i]!=nullptr)&&(_particles[i]->getInitializationState()!=2) )
+        {
+            SParticleState state;
+            _particles[i]->getState(state);
+            states.push_back(state);
+        }
+    }
+}
+
+void CParticleObject::restoreParticles(const SParticleState* states,int count)
+{ // replaces all particles. The new ones are added to the engine with the next step, at the saved position and velocity
+    addParticle(0.0f,nullptr); // removes all
+    for (int i=0;i<count;i++)
+    {
+        float addColor[3]={states[i].additionalColor[0],states[i].additionalColor[1],states[i].additionalColor[2]};
+        float* additionalColor=nullptr;
+        if (_objectType&sim_particle_itemcolors)
+            additionalColor=addColor;
+        CParticleDyn* particle=_createParticle(C3Vector(states[i].position),C3Vector(states[i].velocity),states[i].size,states[i].massOverVolume,states[i].killTime,additionalColor);
+        particle->setUniqueID(states[i].uniqueID);
+        if (states[i].uniqueID>=_nextUniqueIDForParticle)
+            _nextUniqueIDForParticle=states[i].uniqueID+1;
+        int slot=int(_particles.size());
+        if (_freeSlots.size()!=0)
+        {
+            slot=_freeSlots[_freeSlots.size()-1];
+            _freeSlots.pop_back();
+        }
+        else
+        {
+            _particles.push_back(nullptr);
+            _slotChangeFrames.push_back(_renderFrame);
+        }
+        _particles[slot]=particle;
+        _slotChangeFrames[slot]=_renderFrame;
+    }
+    // The emission order is the unique ID order:
+    std::vector<std::pair<int,int> > order;
+    for (int i=0;i<int(_particles.size());i++)
+    {
+        if (_particles[i]!=nullptr)
+            order.push_back(std::make_pair(_particles[i]->getUniqueID(),i));
+    }
+    std::sort(order.begin(),order.end());
+    for (int i=0;i<int(order.size());i++)
+        _registerParticle(order[i].second);
 }
 
 void** CParticleObject::getParticles(int* particlesCount,int* objectType,float** col)
@@ -269,6 +415,73 @@ void** CParticleObject::getParticles(int* particlesCount,int* objectType,float**
     return(nullptr);
 }
 
+int CParticleObject::getRenderData(int sinceFrame,int maxCount,int* slots,float* positions,float* sizes,float* colors,int* frame)
+{ // sinceFrame<0: all particles that can be rendered. Otherwise the slots that changed since that frame, emptied slots have a size of 0
+  // Fills up to maxCount items (any array can be nullptr) and returns the total count. frame is what to pass as sinceFrame next time
+    int retVal=0;
+    for (int i=0;i<int(_particles.size());i++)
+    {
+        if ( (sinceFrame>=0)&&(_slotChangeFrames[i]<=sinceFrame) )
+            continue;
+        float pos[3]={0.0f,0.0f,0.0f};
+        float size=0.0f;
+        int objType;
+        float* additionalColor=nullptr;
+        bool renderable=( (_particles[i]!=nullptr)&&_particles[i]->getRenderData(pos,&size,&objType,&additionalColor) );
+        if (!renderable)
+        {
+            if (sinceFrame<0)
+                continue;
+            size=0.0f;
+        }
+        if (retVal<maxCount)
+        {
+            if (slots!=nullptr)
+                slots[retVal]=i;
+            if (positions!=nullptr)
+            {
+                for (int j=0;j<3;j++)
+                    positions[3*retVal+j]=pos[j];
+            }
+            if (sizes!=nullptr)
+                sizes[retVal]=size;
+            if (colors!=nullptr)
+            {
+                for (int j=0;j<3;j++)
+                    colors[3*retVal+j]=0.0f;
+                if ( renderable&&(_objectType&sim_particle_itemcolors) )
+                {
+                    for (int j=0;j<3;j++)
+                        colors[3*retVal+j]=additionalColor[j];
+                }
+            }
+        }
+        retVal++;
+    }
+    if (frame!=nullptr)
+        frame[0]=_renderFrame; // later changes get a larger frame
+    _renderFrame++;
+    return(retVal);
+}
+
+int CParticleObject::getRenderBuffers(int sinceFrame,int** slots,float** positions,float** sizes,float** colors,int* frame)
+{ // like getRenderData, but the arrays belong to the particle object and stay valid until the next call
+    int n=int(_particles.size())+1;
+    if (int(_renderSizes.size())<n)
+    {
+        _renderSlots.resize(n);
+        _renderPositions.resize(3*n);
+        _renderSizes.resize(n);
+        _renderColors.resize(3*n);
+    }
+    int retVal=getRenderData(sinceFrame,n,&_renderSlots[0],&_renderPositions[0],&_renderSizes[0],&_renderColors[0],frame);
+    slots[0]=&_renderSlots[0];
+    positions[0]=&_renderPositions[0];
+    sizes[0]=&_renderSizes[0];
+    colors[0]=&_renderColors[0];
+    return(retVal);
+}
+
 bool CParticleObject::isParticleRespondable()
 {
     return((_objectType&sim_particle_particlerespondable)!=0);
@@ -284,23 +497,144 @@ int CParticleObject::getShapeRespondableMask()
     return(retVal);
 }
 
+float CParticleObject::getContactFriction()
+{ // used by CParticleSystem, from the current engine's parameters
+    float retVal=0.0f;
+#ifdef INCLUDE_BULLET_2_78_CODE
+    retVal=parameters[0];
+#endif
+#ifdef INCLUDE_BULLET_2_83_CODE
+    retVal=parameters[0];
+#endif
+#ifdef INCLUDE_ODE_CODE
+    retVal=parameters[2];
+#endif
+#ifdef INCLUDE_NEWTON_CODE
+    retVal=parameters[16];
+#endif
+#ifdef INCLUDE_VORTEX_CODE
+    retVal=parameters[9];
+#endif
+    return(retVal);
+}
+
+float CParticleObject::getContactRestitution()
+{ // used by CParticleSystem, from the current engine's parameters. ODE particles have no restitution
+    float retVal=0.0f;
+#ifdef INCLUDE_BULLET_2_78_CODE
+    retVal=parameters[1];
+#endif
+#ifdef INCLUDE_BULLET_2_83_CODE
+    retVal=parameters[1];
+#endif
+#ifdef INCLUDE_NEWTON_CODE
+    retVal=parameters[17];
+#endif
+#ifdef INCLUDE_VORTEX_CODE
+    retVal=parameters[10];
+#endif
+    return(retVal);
+}
+
 bool CParticleObject::addParticlesIfNeeded()
 { // return value indicates if there are particles that need to be simulated
     bool particlesPresent=false;
     for (int i=0;i<int(_particles.size());i++)
     {
         if (_particles[i]!=nullptr)
+        {
+            bool wasAdded=(_particles[i]->getInitializationState()!=0);
             particlesPresent|=_particles[i]->addToEngineIfNeeded(parameters,_objectID);
+            if (!wasAdded)
+                _slotChangeFrames[i]=_renderFrame; // now it has render data
+        }
     }
     return(particlesPresent);
 }
 
-void CParticleObject::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity)
-{
+int CParticleObject::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity)
+{ // batched: velocities, heights and masses are gathered, the forces computed in one vectorizable sweep, then applied. Returns the number of particles handled
+    if (_particleSystem!=nullptr)
+        return(0); // CParticleSystem integrates those forces itself
+    bool antiGravity=((_objectType&sim_particle_ignoresgravity)!=0)||((_objectType&sim_particle_water)!=0);
+    bool fluidFriction=(parameters[5]!=0.0f)||(parameters[6]!=0.0f)||(parameters[7]!=0.0f)||(parameters[8]!=0.0f);
+    if ( (!antiGravity)&&(!fluidFriction) )
+        return(0);
+
+    _fluidParticles.clear();
     for (int i=0;i<int(_particles.size());i++)
     {
-        if (_particles[i]!=nullptr)
-            _particles[i]->handleAntiGravityForces_andFluidFrictionForces(gravity,parameters[5],parameters[6],parameters[7],parameters[8]);
+        if ( (_particles[i]!=nullptr)&&(_particles[i]->getInitializationState()==1) )
+            _fluidParticles.push_back(_particles[i]);
+    }
+    int cnt=int(_fluidParticles.size());
+    if (cnt==0)
+        return(0);
+    _fluidVelocityX.resize(cnt);
+    _fluidVelocityY.resize(cnt);
+    _fluidVelocityZ.resize(cnt);
+    _fluidHeight.resize(cnt);
+    _fluidMass.resize(cnt);
+    _fluidForceX.resize(cnt);
+    _fluidForceY.resize(cnt);
+    _fluidForceZ.resize(cnt);
+
+    // Gather:
+    for (int i=0;i<cnt;i++)
+    {
+        C3Vector v(_fluidParticles[i]->getVelocity());
+        _fluidVelocityX[i]=v(0);
+        _fluidVelocityY[i]=v(1);
+        _fluidVelocityZ[i]=v(2);
+        _fluidHeight[i]=_fluidParticles[i]->getPosition()(2); // updated after each pass
+        _fluidMass[i]=_fluidParticles[i]->getMass();
+    }
+
+    // Compute:
+    float antiGravityScaling=1.0f;
+    float forceScaling=1.0f;
+#if defined(INCLUDE_BULLET_2_78_CODE)||defined(INCLUDE_BULLET_2_83_CODE)||defined(INCLUDE_ODE_CODE)
+    antiGravityScaling=CRigidBodyContainerDyn::getMassScalingFactorDyn()*CRigidBodyContainerDyn::getGravityScalingFactorDyn(); // ********** SCALING
+    forceScaling=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
+#endif
+    C3Vector antiGravityForcePerMass(gravity*-antiGravityScaling);
+    _computeFluidForces(cnt,antiGravityForcePerMass,forceScaling);
+
+    // Scatter:
+    for (int i=0;i<cnt;i++)
+        _fluidParticles[i]->applyFluidForce(C3Vector(_fluidForceX[i],_fluidForceY[i],_fluidForceZ[i]));
+    return(cnt);
+}
+
+void CParticleObject::_computeFluidForces(int cnt,const C3Vector& antiGravityForcePerMass,float forceScaling)
+{ // branchless over the gathered arrays, so that the compiler can vectorize the loop. Water particles above z=0 use the air friction coefficients and feel gravity
+    float water=((_objectType&sim_particle_water)!=0)?1.0f:0.0f;
+    float ignoresGravity=(((_objectType&sim_particle_ignoresgravity)!=0)&&(water==0.0f))?1.0f:0.0f;
+    float linearFluid=parameters[5];
+    float quadraticFluid=parameters[6];
+    float linearAirMinusFluid=parameters[7]-parameters[5];
+    float quadraticAirMinusFluid=parameters[8]-parameters[6];
+    float agx=antiGravityForcePerMass(0);
+    float agy=antiGravityForcePerMass(1);
+    float agz=antiGravityForcePerMass(2);
+    const float* vx=&_fluidVelocityX[0];
+    const float* vy=&_fluidVelocityY[0];
+    const float* vz=&_fluidVelocityZ[0];
+    const float* height=&_fluidHeight[0];
+    const float* mass=&_fluidMass[0];
+    float* fx=&_fluidForceX[0];
+    float* fy=&_fluidForceY[0];
+    float* fz=&_fluidForceZ[0];
+    for (int i=0;i<cnt;i++)
+    {
+        float v=sqrtf(vx[i]*vx[i]+vy[i]*vy[i]+vz[i]*vz[i]);
+        float inAir=water*((height[i]>=0.0f)?1.0f:0.0f);
+        float antiGravityMass=mass[i]*(ignoresGravity+water-inAir);
+        // -normalized(v)*(v*lfc+v*v*qfc) is -v*(lfc+v*qfc):
+        float k=-forceScaling*((linearFluid+inAir*linearAirMinusFluid)+v*(quadraticFluid+inAir*quadraticAirMinusFluid));
+        fx[i]=vx[i]*k+antiGravityMass*agx;
+        fy[i]=vy[i]*k+antiGravityMass*agy;
+        fz[i]=vz[i]*k+antiGravityMass*agz;
     }
 }
 
@@ -315,60 +649,34 @@ void CParticleObject::removeKilledParticles()
 }
 
 void CParticleObject::removeAllParticles()
-{
-    for (int i=0;i<int(_particles.size());i++)
+{ // the slots stay (empty), so that renderers see the removal
+    _clearSlots();
+    for (int i=int(_particles.size())-1;i>=0;i--)
     {
         if (_particles[i]!=nullptr)
         {
             _particles[i]->removeFromEngine();
             delete _particles[i];
+            _particles[i]=nullptr;
+            _slotChangeFrames[i]=_renderFrame;
         }
+        _freeSlots.push_back(i);
     }
-    _particles.clear();
     removeKilledParticles();
 }
 
 void CParticleObject::updateParticlesPosition(float simulationTime)
 {
-// Now we first wanna remove particles that have timed out or that are not active anymore (this part added on 26/02/2011):
-//***************************************
-    int oldestIndex=-1;
-    int firstFreeIndex=-1;
-    int smallestUniqueID=_nextUniqueIDForParticle+2;
+    _expireParticles(simulationTime);
     for (int i=0;i<int(_particles.size());i++)
     {
         if (_particles[i]!=nullptr)
         {
-            if ( _particles[i]->didTimeOut(simulationTime)||(_particles[i]->getInitializationState()==2) )
-            { // We have to remove this one from _particles:
-                if (_particles[i]->getInitializationState()==1)
-                    _particlesToDestroy.push_back(_particles[i]); // We cannot destroy this one now
-                else
-                    delete _particles[i]; // We can directly destroy this one here
-                _particles[i]=nullptr;
-                if (firstFreeIndex==-1)
-                    firstFreeIndex=i;
-            }
-            else
-            { // this one stays a bit more (or will be removed just after if the list is full))
-                int uniqueID=_particles[i]->getUniqueID();
-                if (smallestUniqueID>uniqueID)
-                {
-                    smallestUniqueID=uniqueID;
-                    oldestIndex=i;
-                }
-            }
-        }
-        else
-        {
-            if (firstFreeIndex==-1)
-                firstFreeIndex=i;
-        }
-    }
-//***************************************
-    for (int i=0;i<int(_particles.size());i++)
-    {
-        if (_particles[i]!=nullptr)
+            C3Vector previousPosition(_particles[i]->getPosition());
             _particles[i]->updatePosition();
+            C3Vector position(_particles[i]->getPosition());
+            if ( (position(0)!=previousPosition(0))||(position(1)!=previousPosition(1))||(position(2)!=previousPosition(2)) )
+                _slotChangeFrames[i]=_renderFrame;
+        }
     }
 }
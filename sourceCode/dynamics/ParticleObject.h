@@ -2,6 +2,20 @@
 
 #include "ParticleDyn.h"
 #include <vector>
+#include <deque>
+
+class CParticleSystem;
+
+struct SParticleSlotRef
+{ // a particle in _particles. Stale once the slot was released (the slot is empty or holds another particle)
+    int slot;
+    int uniqueID;
+    float killTime;
+};
+
+enum {
+    dyn_particle_killwheelsize=64 // slots of the lifetime timing wheel, power of 2
+};
 
 class CParticleObject  
 {
@@ -11,11 +25,18 @@ public:
 
     void setObjectID(int newID);
     int getObjectID();
+    void setUniqueID(unsigned int id);
+    unsigned int getUniqueID();
+    int getObjectType();
+    void setParticleSystem(CParticleSystem* particleSystem);
     void addParticle(float simulationTime,const float* itemData);
+    void addParticles(float simulationTime,int itemCount,const float* itemData);
     int getOtherFloatsPerItem();
 
     bool isParticleRespondable();
     int getShapeRespondableMask();
+    float getContactFriction();
+    float getContactRestitution();
     bool canBeDestroyed();
     void flagForDestruction();
     bool isFlaggedForDestruction();
@@ -26,16 +47,30 @@ public:
     void removeKilledParticles();
     void removeAllParticles();
     void updateParticlesPosition(float simulationTime);
+    void getParticleStates(std::vector<SParticleState>& states);
+    void restoreParticles(const SParticleState* states,int count);
 
-    void handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity);
+    int handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity);
 
     void** getParticles(int* particlesCount,int* objectType,float** col);
+    int getRenderData(int sinceFrame,int maxCount,int* slots,float* positions,float* sizes,float* colors,int* frame);
+    int getRenderBuffers(int sinceFrame,int** slots,float** positions,float** sizes,float** colors,int* frame);
 
     float color[12];
     float parameters[18];
 
 protected:
+    CParticleDyn* _createParticle(const C3Vector& pos,const C3Vector& vel,float size,float massOverVolume,float killTime,float* additionalColor);
+    void _addParticle(float simulationTime,const float* itemData);
+    void _registerParticle(int slot);
+    void _releaseSlot(int slot);
+    bool _isSlotCurrent(const SParticleSlotRef& ref);
+    void _expireParticles(float simulationTime);
+    void _clearSlots();
+    void _computeFluidForces(int cnt,const C3Vector& antiGravityForcePerMass,float forceScaling);
+
     int _objectID;
+    unsigned int _uniqueID; // object IDs get reused, this one not
     int _nextUniqueIDForParticle;
 
     int _objectType;
@@ -44,7 +79,31 @@ protected:
     float _particlesLifeTime;
     int _maxItemCount;
     bool _flaggedForDestruction;
+    CParticleSystem* _particleSystem; // dyn_particleengine_soa only, otherwise nullptr
 
-    std::vector<CParticleDyn*> _particles;
+    std::vector<CParticleDyn*> _particles; // can contain nullptr!
     std::vector<CParticleDyn*> _particlesToDestroy;
+
+    std::vector<int> _freeSlots; // empty slots of _particles
+    std::deque<SParticleSlotRef> _emissionOrder; // sim_particle_cyclic only: oldest first, stale entries are skipped
+    std::vector<SParticleSlotRef> _killWheel[dyn_particle_killwheelsize]; // particles with a lifetime, by kill time tick
+    float _killWheelTickDuration;
+    long long _killWheelLastTick;
+
+    std::vector<int> _slotChangeFrames; // parallel to _particles: render frame of the last change (added, removed, moved)
+    int _renderFrame; // incremented with each render data read
+    std::vector<int> _renderSlots; // getRenderBuffers only, kept from call to call
+    std::vector<float> _renderPositions;
+    std::vector<float> _renderSizes;
+    std::vector<float> _renderColors;
+
+    std::vector<CParticleDyn*> _fluidParticles; // handleAntiGravityForces_andFluidFrictionForces only, kept from pass to pass
+    std::vector<float> _fluidVelocityX; // not scaled
+    std::vector<float> _fluidVelocityY;
+    std::vector<float> _fluidVelocityZ;
+    std::vector<float> _fluidHeight; // not scaled
+    std::vector<float> _fluidMass; // not scaled
+    std::vector<float> _fluidForceX; // scaled
+    std::vector<float> _fluidForceY;
+    std::vector<float> _fluidForceZ;
 };
@@ -0,0 +1,334 @@
+#include "ParticleSystem.h"
+#include "ParticleObject.h"
+#include "RigidBodyContainerDyn.h"
+#include "simLib.h"
+#include <cmath>
+
+static unsigned int _gridBucket(int x,int y,int z,unsigned int bucketMask)
+{
+    return(((unsigned int)(x*73856093)^(unsigned int)(y*19349663)^(unsigned int)(z*83492791))&bucketMask);
+}
+
+CParticleSystem::CParticleSystem()
+{
+    _particleCount=0;
+    _gridCellSize=0.0f;
+}
+
+CParticleSystem::~CParticleSystem()
+{
+}
+
+int CParticleSystem::addParticle(CParticleObject* object,const C3Vector& position,const C3Vector& velocity,float size,float massOverVolume)
+{
+    int index;
+    if (_freeIndices.size()!=0)
+    {
+        index=_freeIndices[_freeIndices.size()-1];
+        _freeIndices.pop_back();
+    }
+    else
+    {
+        index=int(_objects.size());
+        _positionX.push_back(0.0f);
+        _positionY.push_back(0.0f);
+        _positionZ.push_back(0.0f);
+        _velocityX.push_back(0.0f);
+        _velocityY.push_back(0.0f);
+        _velocityZ.push_back(0.0f);
+        _radius.push_back(0.0f);
+        _inverseMass.push_back(0.0f);
+        _friction.push_back(0.0f);
+        _restitution.push_back(0.0f);
+        _objectType.push_back(0);
+        _shapeRespondableMask.push_back(0);
+        _objects.push_back(nullptr);
+    }
+    float mass=massOverVolume*((piValue*size*size*size)/6.0f);
+    if (mass<0.000000001f)
+        mass=0.000000001f;
+    _positionX[index]=position(0);
+    _positionY[index]=position(1);
+    _positionZ[index]=position(2);
+    _velocityX[index]=velocity(0);
+    _velocityY[index]=velocity(1);
+    _velocityZ[index]=velocity(2);
+    _radius[index]=size*0.5f;
+    _inverseMass[index]=1.0f/mass;
+    _friction[index]=object->getContactFriction();
+    _restitution[index]=object->getContactRestitution();
+    _objectType[index]=object->getObjectType();
+    _shapeRespondableMask[index]=object->getShapeRespondableMask();
+    _objects[index]=object;
+    _particleCount++;
+    return(index);
+}
+
+void CParticleSystem::removeParticle(int index)
+{
+    if ( (index>=0)&&(index<int(_objects.size()))&&(_objects[index]!=nullptr) )
+    {
+        _objects[index]=nullptr;
+        _freeIndices.push_back(index);
+        _particleCount--;
+    }
+}
+
+void CParticleSystem::removeAllParticles()
+{
+    for (int i=0;i<int(_objects.size());i++)
+        removeParticle(i);
+}
+
+int CParticleSystem::getParticleCount()
+{
+    return(_particleCount);
+}
+
+C3Vector CParticleSystem::getPosition(int index)
+{
+    return(C3Vector(_positionX[index],_positionY[index],_positionZ[index]));
+}
+
+C3Vector CParticleSystem::getVelocity(int index)
+{
+    return(C3Vector(_velocityX[index],_velocityY[index],_velocityZ[index]));
+}
+
+void CParticleSystem::step(CRigidBodyContainerDyn* container,float dt,const C3Vector& gravity)
+{ // one sub-pass, before the engine step: the reaction forces of the particles are applied to the bodies by that engine step
+    if (_particleCount==0)
+        return;
+    _integrate(dt,gravity);
+    _handleParticleContacts();
+    _handleShapeContacts(container,dt);
+}
+
+void CParticleSystem::_integrate(float dt,const C3Vector& gravity)
+{ // gravity, "anti-gravity" and fluid friction like the particles that are engine bodies, then semi-implicit Euler
+    for (int i=0;i<int(_objects.size());i++)
+    {
+        CParticleObject* object=_objects[i];
+        if (object==nullptr)
+            continue;
+        int objectType=_objectType[i];
+        bool ignoreGravity=false;
+        bool isWaterButInAir=false;
+        if ( (objectType&sim_particle_ignoresgravity)||(objectType&sim_particle_water) )
+        {
+            ignoreGravity=true;
+            if ( (objectType&sim_particle_water)&&(_positionZ[i]>=0.0f) )
+            { // We ignore gravity only if we are in the water (z<0)
+                ignoreGravity=false;
+                isWaterButInAir=true;
+            }
+        }
+        if (!ignoreGravity)
+        {
+            _velocityX[i]+=gravity(0)*dt;
+            _velocityY[i]+=gravity(1)*dt;
+            _velocityZ[i]+=gravity(2)*dt;
+        }
+
+        float lfc=object->parameters[5];
+        float qfc=object->parameters[6];
+        if (isWaterButInAir)
+        {
+            lfc=object->parameters[7];
+            qfc=object->parameters[8];
+        }
+        if ((lfc!=0.0f)||(qfc!=0.0f))
+        { // f=-v/|v|*(|v|*lfc+|v|*|v|*qfc)
+            float v=sqrtf(_velocityX[i]*_velocityX[i]+_velocityY[i]*_velocityY[i]+_velocityZ[i]*_velocityZ[i]);
+            float damping=(lfc+v*qfc)*_inverseMass[i]*dt;
+            if (damping>1.0f)
+                damping=1.0f; // friction can stop a particle, not reverse it
+            _velocityX[i]-=_velocityX[i]*damping;
+            _velocityY[i]-=_velocityY[i]*damping;
+            _velocityZ[i]-=_velocityZ[i]*damping;
+        }
+
+        _positionX[i]+=_velocityX[i]*dt;
+        _positionY[i]+=_velocityY[i]*dt;
+        _positionZ[i]+=_velocityZ[i]*dt;
+    }
+}
+
+void CParticleSystem::_handleParticleContacts()
+{ // sim_particle_particlerespondable particles only. The grid cell is the largest diameter, so only neighbouring cells need to be checked
+    _gridParticles.clear();
+    float maxRadius=0.0f;
+    for (int i=0;i<int(_objects.size());i++)
+    {
+        if ( (_objects[i]!=nullptr)&&(_objectType[i]&sim_particle_particlerespondable) )
+        {
+            _gridParticles.push_back(i);
+            if (_radius[i]>maxRadius)
+                maxRadius=_radius[i];
+        }
+    }
+    int cnt=int(_gridParticles.size());
+    if ( (cnt<2)||(maxRadius<=0.0f) )
+        return;
+    _gridCellSize=2.0f*maxRadius;
+    float invCellSize=1.0f/_gridCellSize;
+    unsigned int bucketCount=64;
+    while (bucketCount<2*(unsigned int)cnt)
+        bucketCount*=2;
+    unsigned int bucketMask=bucketCount-1;
+
+    // Counting sort of the particles by bucket:
+    _gridParticleCells.resize(cnt);
+    _gridCellStarts.assign(bucketCount+1,0);
+    _gridCellEntries.resize(cnt);
+    for (int k=0;k<cnt;k++)
+    {
+        int i=_gridParticles[k];
+        unsigned int bucket=_gridBucket(int(floorf(_positionX[i]*invCellSize)),int(floorf(_positionY[i]*invCellSize)),int(floorf(_positionZ[i]*invCellSize)),bucketMask);
+        _gridParticleCells[k]=int(bucket);
+        _gridCellStarts[bucket]++;
+    }
+    for (unsigned int b=1;b<=bucketCount;b++)
+        _gridCellStarts[b]+=_gridCellStarts[b-1]; // bucket ends
+    for (int k=0;k<cnt;k++)
+        _gridCellEntries[--_gridCellStarts[_gridParticleCells[k]]]=_gridParticles[k]; // bucket ends become bucket starts
+
+    for (int k=0;k<cnt;k++)
+    {
+        int i=_gridParticles[k];
+        int cx=int(floorf(_positionX[i]*invCellSize));
+        int cy=int(floorf(_positionY[i]*invCellSize));
+        int cz=int(floorf(_positionZ[i]*invCellSize));
+        unsigned int visited[27];
+        int visitedCnt=0;
+        for (int dx=-1;dx<=1;dx++)
+        {
+            for (int dy=-1;dy<=1;dy++)
+            {
+                for (int dz=-1;dz<=1;dz++)
+                {
+                    unsigned int bucket=_gridBucket(cx+dx,cy+dy,cz+dz,bucketMask);
+                    bool alreadyVisited=false;
+                    for (int v=0;v<visitedCnt;v++)
+                        alreadyVisited|=(visited[v]==bucket);
+                    if (alreadyVisited)
+                        continue; // different cells can share a bucket
+                    visited[visitedCnt++]=bucket;
+                    for (int e=_gridCellStarts[bucket];e<_gridCellStarts[bucket+1];e++)
+                    {
+                        int j=_gridCellEntries[e];
+                        if (j>i) // each pair once
+                            _resolveParticlePair(i,j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CParticleSystem::_resolveParticlePair(int i,int j)
+{
+    float nx=_positionX[i]-_positionX[j];
+    float ny=_positionY[i]-_positionY[j];
+    float nz=_positionZ[i]-_positionZ[j];
+    float minDist=_radius[i]+_radius[j];
+    float d2=nx*nx+ny*ny+nz*nz;
+    if ( (d2>=minDist*minDist)||(d2==0.0f) )
+        return;
+    float d=sqrtf(d2);
+    nx/=d;
+    ny/=d;
+    nz/=d;
+    float wi=_inverseMass[i];
+    float wj=_inverseMass[j];
+    float w=wi+wj;
+
+    // Separate the two particles:
+    float correction=(minDist-d)/w;
+    _positionX[i]+=nx*correction*wi;
+    _positionY[i]+=ny*correction*wi;
+    _positionZ[i]+=nz*correction*wi;
+    _positionX[j]-=nx*correction*wj;
+    _positionY[j]-=ny*correction*wj;
+    _positionZ[j]-=nz*correction*wj;
+
+    // Normal and friction impulses, if approaching:
+    float rvx=_velocityX[i]-_velocityX[j];
+    float rvy=_velocityY[i]-_velocityY[j];
+    float rvz=_velocityZ[i]-_velocityZ[j];
+    float vn=rvx*nx+rvy*ny+rvz*nz;
+    if (vn>=0.0f)
+        return;
+    float jn=-(1.0f+_restitution[i]*_restitution[j])*vn/w;
+    float ix=nx*jn;
+    float iy=ny*jn;
+    float iz=nz*jn;
+    float tx=rvx-nx*vn;
+    float ty=rvy-ny*vn;
+    float tz=rvz-nz*vn;
+    float vt=sqrtf(tx*tx+ty*ty+tz*tz);
+    if (vt>0.0f)
+    {
+        float jt=vt/w;
+        float maxJt=_friction[i]*_friction[j]*jn;
+        if (jt>maxJt)
+            jt=maxJt;
+        ix-=tx*jt/vt;
+        iy-=ty*jt/vt;
+        iz-=tz*jt/vt;
+    }
+    _velocityX[i]+=ix*wi;
+    _velocityY[i]+=iy*wi;
+    _velocityZ[i]+=iz*wi;
+    _velocityX[j]-=ix*wj;
+    _velocityY[j]-=iy*wj;
+    _velocityZ[j]-=iz*wj;
+}
+
+void CParticleSystem::_handleShapeContacts(CRigidBodyContainerDyn* container,float dt)
+{ // the shapes are not moved here: dynamic ones receive the reaction force with the next engine step
+    SParticleShapeContact contacts[4];
+    for (int i=0;i<int(_objects.size());i++)
+    {
+        if ( (_objects[i]==nullptr)||(_shapeRespondableMask[i]==0) )
+            continue;
+        C3Vector position(_positionX[i],_positionY[i],_positionZ[i]);
+        int cnt=container->collideSphereWithShapes(position,_radius[i],_shapeRespondableMask[i],contacts,4);
+        if (cnt==0)
+            continue;
+        C3Vector velocity(_velocityX[i],_velocityY[i],_velocityZ[i]);
+        float mass=1.0f/_inverseMass[i];
+        for (int c=0;c<cnt;c++)
+        {
+            const SParticleShapeContact& contact=contacts[c];
+            position+=contact.normal*contact.depth;
+            CRigidBodyDyn* body=container->getRigidBodyFromShapeID(contact.shapeID);
+            C3Vector relVelocity(velocity);
+            if (body!=nullptr)
+                relVelocity-=body->getVelocityAtPosition(contact.position);
+            float vn=relVelocity*contact.normal;
+            if (vn>=0.0f)
+                continue;
+            float jn=-(1.0f+_restitution[i])*vn;
+            C3Vector dv(contact.normal*jn);
+            C3Vector tangential(relVelocity-contact.normal*vn);
+            float vt=tangential.getLength();
+            if (vt>0.0f)
+            {
+                float jt=vt;
+                if (jt>_friction[i]*jn)
+                    jt=_friction[i]*jn;
+                dv-=tangential*(jt/vt);
+            }
+            velocity+=dv;
+            if ( (body!=nullptr)&&(!body->isBodyKinematic()) )
+                body->addForceAtPosition(dv*(-mass/dt),contact.position);
+        }
+        _positionX[i]=position(0);
+        _positionY[i]=position(1);
+        _positionZ[i]=position(2);
+        _velocityX[i]=velocity(0);
+        _velocityY[i]=velocity(1);
+        _velocityZ[i]=velocity(2);
+    }
+}
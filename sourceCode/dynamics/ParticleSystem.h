@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "3Vector.h"
+
+class CParticleObject;
+class CRigidBodyContainerDyn;
+
+class CParticleSystem
+{ // particles of dyn_particleengine_soa, stored as structure of arrays (not scaled). Indices are stable, freed ones are reused
+public:
+    CParticleSystem();
+    virtual ~CParticleSystem();
+
+    int addParticle(CParticleObject* object,const C3Vector& position,const C3Vector& velocity,float size,float massOverVolume);
+    void removeParticle(int index);
+    void removeAllParticles();
+    int getParticleCount();
+    C3Vector getPosition(int index);
+    C3Vector getVelocity(int index);
+
+    void step(CRigidBodyContainerDyn* container,float dt,const C3Vector& gravity);
+
+protected:
+    void _integrate(float dt,const C3Vector& gravity);
+    void _handleParticleContacts();
+    void _handleShapeContacts(CRigidBodyContainerDyn* container,float dt);
+    void _resolveParticlePair(int i,int j);
+
+    std::vector<float> _positionX;
+    std::vector<float> _positionY;
+    std::vector<float> _positionZ;
+    std::vector<float> _velocityX;
+    std::vector<float> _velocityY;
+    std::vector<float> _velocityZ;
+    std::vector<float> _radius;
+    std::vector<float> _inverseMass;
+    std::vector<float> _friction;
+    std::vector<float> _restitution;
+    std::vector<int> _objectType; // sim_particle_* flags
+    std::vector<int> _shapeRespondableMask;
+    std::vector<CParticleObject*> _objects; // nullptr for free indices
+    std::vector<int> _freeIndices;
+    int _particleCount;
+
+    // Uniform grid (spatial hash) for particle-particle contacts, rebuilt each pass:
+    std::vector<int> _gridParticles; // particle-respondable particles
+    std::vector<int> _gridParticleCells;
+    std::vector<int> _gridCellStarts; // bucket --> first entry in _gridCellEntries
+    std::vector<int> _gridCellEntries;
+    float _gridCellSize;
+};
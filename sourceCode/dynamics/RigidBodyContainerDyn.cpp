@@ -1,5 +1,8 @@
 #include "RigidBodyContainerDyn.h"
+#include "StepProfiler.h"
 #include "simLib.h"
+#include <algorithm>
+#include <cstring>
 
 #ifdef INCLUDE_BULLET_2_78_CODE
 #include "RigidBodyContainerDyn_bullet278.h"
@@ -36,28 +39,108 @@
 #include "ConstraintDyn_vortex.h"
 #endif
 
-CRigidBodyContainerDyn* CRigidBodyContainerDyn::currentRigidBodyContainerDynObject=nullptr; // for ODE's callback (and maybe Vortex too)
-CParticleContainer CRigidBodyContainerDyn::particleCont;
+thread_local CRigidBodyContainerDyn* CRigidBodyContainerDyn::currentRigidBodyContainerDynObject=nullptr; // for engine callbacks that have no other way to find their container
+
+static const int _syncedObjectTypes[4]={sim_object_shape_type,sim_object_joint_type,sim_object_dummy_type,sim_object_forcesensor_type};
+static const int _syncAuditObjectsPerStep=256; // incremental world synchronization: objects whose properties are fully compared in each step, in turn
+
+CRigidBodyContainerDyn::CRigidBodyContainerDyn(const SDynWorldSettings& settings)
+{ // the derived constructors already read the settings through the static getters
+    currentRigidBodyContainerDynObject=this;
+    _positionScalingFactorDyn=settings.positionScalingFactor;
+    _linearVelocityScalingFactorDyn=settings.linearVelocityScalingFactor;
+    _massScalingFactorDyn=settings.massScalingFactor;
+    _masslessInertiaScalingFactorDyn=settings.masslessInertiaScalingFactor;
+    _forceScalingFactorDyn=settings.forceScalingFactor;
+    _torqueScalingFactorDyn=settings.torqueScalingFactor;
+    _gravityScalingFactorDyn=settings.gravityScalingFactor;
+    _dynamicActivityRange=settings.dynamicActivityRange;
+    _dynamicsInternalStepSize=0.0f;
+    _dynamicParticlesIdStart=settings.dynamicParticlesIdStart;
+    _3dObjectIdStart=settings.objectIdStart;
+    _3dObjectIdEnd=settings.objectIdEnd;
+    _worldSyncMode=settings.worldSyncMode;
+    _writeBackMode=settings.writeBackMode;
+    _intermediateWriteBackNeeded=settings.intermediateWriteBackNeeded;
+    _subStepMode=settings.subStepMode;
+    for (int i=0;i<3;i++)
+        _adaptiveSubStepThresholds[i]=settings.adaptiveSubStepThresholds[i];
+    _adaptiveSubStepMaxPassFactor=settings.adaptiveSubStepMaxPassFactor;
+    _visualizationFlagMode=settings.visualizationFlagMode;
+    _sleepMode=settings.sleepMode;
+    for (int i=0;i<3;i++)
+        _sleepParams[i]=settings.sleepParams[i];
+    _particleEngine=settings.particleEngine;
+    _contactBatchCallback=settings.contactBatchCallback;
+
+    _syncGeneration=0;
+    _syncAuditPosition=0;
+    _dynamicTreeDisabled=false;
+    _writeBackOrderIsDirty=true;
+    _nonBodyShapeVelocitiesZeroed=false;
+    _motorScheduleIsDirty=true;
+    _kinematicBodiesAreDirty=true;
+    _collisionFilterGeneration=1;
+    _customContactHandled=false;
+    _customContactHandledInStep=false;
+    _stepPending=false;
+    _stepIsAsynchronous=false;
+    _asyncStepRunning=false;
+    _asyncStepTime=0.0f;
+    _stepMaxPenetration=0.0f;
+    for (int i=0;i<3;i++)
+        _stepMeasures[i]=0.0f;
+    _stepMeasuresExceeded=0;
+    _adaptivePasses=0;
+    _adaptiveCalmSteps=0;
+}
 
-float CRigidBodyContainerDyn::_positionScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_linearVelocityScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_massScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_masslessInertiaScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_forceScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_torqueScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_gravityScalingFactorDyn=0.0;
-float CRigidBodyContainerDyn::_dynamicActivityRange=0.0;
-float CRigidBodyContainerDyn::_dynamicsInternalStepSize=0.0;
-int CRigidBodyContainerDyn::_dynamicParticlesIdStart=0;
-int CRigidBodyContainerDyn::_3dObjectIdStart=0;
-int CRigidBodyContainerDyn::_3dObjectIdEnd=0;
+CRigidBodyContainerDyn::~CRigidBodyContainerDyn()
+{ // finishDynamics should have been called before the engine world got destroyed
+    if (_asyncStepThread.joinable())
+        _asyncStepThread.join();
+    if (currentRigidBodyContainerDynObject==this)
+        currentRigidBodyContainerDynObject=nullptr;
+}
 
-CRigidBodyContainerDyn::CRigidBodyContainerDyn()
-{
+void CRigidBodyContainerDyn::makeCurrent()
+{ // the static getters (scaling factors, ID ranges, modes) will return the settings of this world. Call before using a world from outside of its step
+    currentRigidBodyContainerDynObject=this;
 }
 
-CRigidBodyContainerDyn::~CRigidBodyContainerDyn()
+unsigned int CRigidBodyContainerDyn::getContactAllocationCount()
 {
+    return(_contacts.getAllocationCount()+_contactsSnapshot.getAllocationCount());
+}
+
+void CRigidBodyContainerDyn::getDefaultWorldSettings(SDynWorldSettings& settings)
+{ // the scaling factors and ID ranges still need to be set
+    settings.positionScalingFactor=0.0f;
+    settings.linearVelocityScalingFactor=0.0f;
+    settings.massScalingFactor=0.0f;
+    settings.masslessInertiaScalingFactor=0.0f;
+    settings.forceScalingFactor=0.0f;
+    settings.torqueScalingFactor=0.0f;
+    settings.gravityScalingFactor=0.0f;
+    settings.dynamicActivityRange=0.0f;
+    settings.dynamicParticlesIdStart=0;
+    settings.objectIdStart=0;
+    settings.objectIdEnd=0;
+    settings.worldSyncMode=dyn_worldsync_fullrescan;
+    settings.writeBackMode=dyn_writeback_everypass;
+    settings.intermediateWriteBackNeeded=false;
+    settings.subStepMode=dyn_substep_fixed;
+    settings.adaptiveSubStepThresholds[0]=0.005f;
+    settings.adaptiveSubStepThresholds[1]=0.002f;
+    settings.adaptiveSubStepThresholds[2]=2.0f;
+    settings.adaptiveSubStepMaxPassFactor=2;
+    settings.visualizationFlagMode=dyn_visflags_always;
+    settings.sleepMode=dyn_sleep_off;
+    settings.sleepParams[0]=0.02f;
+    settings.sleepParams[1]=0.05f;
+    settings.sleepParams[2]=0.5f;
+    settings.particleEngine=dyn_particleengine_bodies;
+    settings.contactBatchCallback=nullptr;
 }
 
 int CRigidBodyContainerDyn::getEngineInfo(int& engine,int data1[4],char* data2,char* data3)
@@ -78,132 +161,205 @@ void CRigidBodyContainerDyn::_stepDynamics(float dt,int pass)
 {
 }
 
+bool CRigidBodyContainerDyn::_stepDynamicsCollisions(float dt,int pass)
+{ // first part of _stepDynamics, for asynchronous steps: everything that calls into the simulator (pair filtering, contact materials,
+  // custom contact handling, engine parameters). Returns false if the engine can't split its step, which then stays synchronous
+    return(false);
+}
+
+void CRigidBodyContainerDyn::_stepDynamicsIntegration(float dt,int pass)
+{ // second part of _stepDynamics, after _stepDynamicsCollisions returned true. Must not call into the simulator (runs on _asyncStepThread)
+}
+
 void CRigidBodyContainerDyn::_createDependenciesBetweenJoints()
 {
 }
 
+void CRigidBodyContainerDyn::_resetContactCaches()
+{ // called after restoreState. Cached contacts and solver data refer to the old configuration
+}
+
 void CRigidBodyContainerDyn::_removeDependenciesBetweenJoints(CConstraintDyn* theInvolvedConstraint)
 {
 }
 
-void CRigidBodyContainerDyn::setPositionScalingFactorDyn(float f)
+float CRigidBodyContainerDyn::getPositionScalingFactorDyn()
 {
-    _positionScalingFactorDyn=f;
+    return(currentRigidBodyContainerDynObject->_positionScalingFactorDyn);
 }
 
-float CRigidBodyContainerDyn::getPositionScalingFactorDyn()
+float CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn()
 {
-    return(_positionScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_linearVelocityScalingFactorDyn);
 }
 
-void CRigidBodyContainerDyn::setLinearVelocityScalingFactorDyn(float f)
+float CRigidBodyContainerDyn::getMassScalingFactorDyn()
 {
-    _linearVelocityScalingFactorDyn=f;
+    return(currentRigidBodyContainerDynObject->_massScalingFactorDyn);
 }
 
-float CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn()
+float CRigidBodyContainerDyn::getMasslessInertiaScalingFactorDyn()
 {
-    return(_linearVelocityScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_masslessInertiaScalingFactorDyn);
 }
 
-void CRigidBodyContainerDyn::setMassScalingFactorDyn(float f)
+float CRigidBodyContainerDyn::getForceScalingFactorDyn()
 {
-    _massScalingFactorDyn=f;
+    return(currentRigidBodyContainerDynObject->_forceScalingFactorDyn);
 }
 
-float CRigidBodyContainerDyn::getMassScalingFactorDyn()
+float CRigidBodyContainerDyn::getTorqueScalingFactorDyn()
 {
-    return(_massScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_torqueScalingFactorDyn);
 }
 
-void CRigidBodyContainerDyn::setMasslessInertiaScalingFactorDyn(float f)
+float CRigidBodyContainerDyn::getGravityScalingFactorDyn()
 {
-    _masslessInertiaScalingFactorDyn=f;
+    return(currentRigidBodyContainerDynObject->_gravityScalingFactorDyn);
 }
 
-float CRigidBodyContainerDyn::getMasslessInertiaScalingFactorDyn()
+float CRigidBodyContainerDyn::getDynamicActivityRange()
 {
-    return(_masslessInertiaScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_dynamicActivityRange);
 }
 
-void CRigidBodyContainerDyn::setForceScalingFactorDyn(float f)
+void CRigidBodyContainerDyn::setDynamicsInternalTimeStep(float dt)
 {
-    _forceScalingFactorDyn=f;
+    _dynamicsInternalStepSize=dt;
 }
 
-float CRigidBodyContainerDyn::getForceScalingFactorDyn()
+float CRigidBodyContainerDyn::getDynamicsInternalTimeStep()
 {
-    return(_forceScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_dynamicsInternalStepSize);
 }
 
-void CRigidBodyContainerDyn::setTorqueScalingFactorDyn(float f)
+int CRigidBodyContainerDyn::getDynamicParticlesIdStart()
 {
-    _torqueScalingFactorDyn=f;
+    return(currentRigidBodyContainerDynObject->_dynamicParticlesIdStart);
 }
 
-float CRigidBodyContainerDyn::getTorqueScalingFactorDyn()
+int CRigidBodyContainerDyn::get3dObjectIdStart()
+{
+    return(currentRigidBodyContainerDynObject->_3dObjectIdStart);
+}
+
+int CRigidBodyContainerDyn::get3dObjectIdEnd()
 {
-    return(_torqueScalingFactorDyn);
+    return(currentRigidBodyContainerDynObject->_3dObjectIdEnd);
 }
 
-void CRigidBodyContainerDyn::setGravityScalingFactorDyn(float f)
+void CRigidBodyContainerDyn::setWorldSyncMode(int mode)
 {
-    _gravityScalingFactorDyn=f;
+    _worldSyncMode=mode;
 }
 
-float CRigidBodyContainerDyn::getGravityScalingFactorDyn()
+void CRigidBodyContainerDyn::setContactBatchCallback(dynContactBatchCallback callback)
 {
-    return(_gravityScalingFactorDyn);
+    _contactBatchCallback=callback;
 }
 
-void CRigidBodyContainerDyn::setDynamicActivityRange(float f)
+dynContactBatchCallback CRigidBodyContainerDyn::getContactBatchCallback()
 {
-    _dynamicActivityRange=f;
+    return(currentRigidBodyContainerDynObject->_contactBatchCallback);
 }
 
-float CRigidBodyContainerDyn::getDynamicActivityRange()
+int CRigidBodyContainerDyn::getWorldSyncMode()
 {
-    return(_dynamicActivityRange);
+    return(currentRigidBodyContainerDynObject->_worldSyncMode);
 }
 
-void CRigidBodyContainerDyn::setDynamicsInternalTimeStep(float dt)
+void CRigidBodyContainerDyn::setWriteBackMode(int mode)
 {
-    _dynamicsInternalStepSize=dt;
+    _writeBackMode=mode;
 }
 
-float CRigidBodyContainerDyn::getDynamicsInternalTimeStep()
+int CRigidBodyContainerDyn::getWriteBackMode()
 {
-    return(_dynamicsInternalStepSize);
+    return(currentRigidBodyContainerDynObject->_writeBackMode);
 }
 
-void CRigidBodyContainerDyn::setDynamicParticlesIdStart(int a)
+void CRigidBodyContainerDyn::setIntermediateWriteBackNeeded(bool needed)
+{ // set by the host when a dynamics callback or joint callback that reads the scene is registered
+    _intermediateWriteBackNeeded=needed;
+}
+
+bool CRigidBodyContainerDyn::getIntermediateWriteBackNeeded()
 {
-    _dynamicParticlesIdStart=a;
+    return(currentRigidBodyContainerDynObject->_intermediateWriteBackNeeded);
 }
 
-int CRigidBodyContainerDyn::getDynamicParticlesIdStart()
+void CRigidBodyContainerDyn::setSubStepMode(int mode)
 {
-    return(_dynamicParticlesIdStart);
+    _subStepMode=mode;
 }
 
-void CRigidBodyContainerDyn::set3dObjectIdStart(int a)
+int CRigidBodyContainerDyn::getSubStepMode()
 {
-    _3dObjectIdStart=a;
+    return(currentRigidBodyContainerDynObject->_subStepMode);
 }
 
-int CRigidBodyContainerDyn::get3dObjectIdStart()
+void CRigidBodyContainerDyn::setAdaptiveSubStepParams(const float thresholds[3],int maxPassFactor)
 {
-    return(_3dObjectIdStart);
+    for (int i=0;i<3;i++)
+        _adaptiveSubStepThresholds[i]=thresholds[i];
+    if (maxPassFactor<1)
+        maxPassFactor=1;
+    _adaptiveSubStepMaxPassFactor=maxPassFactor;
 }
 
-void CRigidBodyContainerDyn::set3dObjectIdEnd(int a)
+void CRigidBodyContainerDyn::getAdaptiveSubStepParams(float thresholds[3],int& maxPassFactor)
 {
-    _3dObjectIdEnd=a;
+    for (int i=0;i<3;i++)
+        thresholds[i]=currentRigidBodyContainerDynObject->_adaptiveSubStepThresholds[i];
+    maxPassFactor=currentRigidBodyContainerDynObject->_adaptiveSubStepMaxPassFactor;
 }
 
-int CRigidBodyContainerDyn::get3dObjectIdEnd()
+void CRigidBodyContainerDyn::setVisualizationFlagMode(int mode)
+{
+    _visualizationFlagMode=mode;
+}
+
+int CRigidBodyContainerDyn::getVisualizationFlagMode()
+{
+    return(currentRigidBodyContainerDynObject->_visualizationFlagMode);
+}
+
+void CRigidBodyContainerDyn::setSleepMode(int mode)
+{
+    _sleepMode=mode;
+}
+
+int CRigidBodyContainerDyn::getSleepMode()
+{
+    return(currentRigidBodyContainerDynObject->_sleepMode);
+}
+
+void CRigidBodyContainerDyn::setSleepParams(const float params[3])
+{
+    for (int i=0;i<3;i++)
+        _sleepParams[i]=params[i];
+}
+
+void CRigidBodyContainerDyn::getSleepParams(float params[3])
+{
+    for (int i=0;i<3;i++)
+        params[i]=currentRigidBodyContainerDynObject->_sleepParams[i];
+}
+
+void CRigidBodyContainerDyn::setParticleEngine(int engine)
+{
+    _particleEngine=engine;
+}
+
+int CRigidBodyContainerDyn::getParticleEngine()
 {
-    return(_3dObjectIdEnd);
+#ifdef INCLUDE_BULLET_2_83_CODE
+    return(dyn_particleengine_bodies); // sphere queries not supported
+#endif
+#ifdef INCLUDE_VORTEX_CODE
+    return(dyn_particleengine_bodies); // sphere queries not supported
+#endif
+    return(currentRigidBodyContainerDynObject->_particleEngine);
 }
 
 int CRigidBodyContainerDyn::getDynamicsCalculationPasses()
@@ -211,16 +367,18 @@ int CRigidBodyContainerDyn::getDynamicsCalculationPasses()
     return(_dynamicsCalculationPasses);
 }
 
-void CRigidBodyContainerDyn::removeRigidBodyFromCollisionShapeDependency(int rigidBodyID)
+void CRigidBodyContainerDyn::removeRigidBodyFromCollisionShapeDependency(CRigidBodyDyn* body)
 {
-    for (int i=0;i<int(_allCollisionShapes.size());i++)
-    {
-        if (_allCollisionShapes[i]->removeRigidBodyDependency(rigidBodyID))
-        {
-            delete _allCollisionShapes[i];
-            _allCollisionShapes.erase(_allCollisionShapes.begin()+i);
-            i--; // We need to reprocess this position
-        }
+    CCollShapeDyn* collShape=body->getCollisionShapeDyn();
+    if ( (collShape!=nullptr)&&collShape->removeRigidBodyDependency() )
+    { // no more dependent rigid bodies. Remove the collision shape (swap with the last one, order is not important):
+        int index=collShape->getCollisionShapeListIndex();
+        CCollShapeDyn* last=_allCollisionShapes[_allCollisionShapes.size()-1];
+        _allCollisionShapes[index]=last;
+        last->setCollisionShapeListIndex(index);
+        _allCollisionShapes.pop_back();
+        _allCollisionShapesIndex.erase(collShape->getGeomData_nullForNonRespondable());
+        delete collShape;
     }
 }
 
@@ -292,7 +450,9 @@ void CRigidBodyContainerDyn::_addOrUpdateRigidBody(CDummyShape* shape,bool force
             collShape=new CCollShapeDyn_vortex(shape,geom,((CRigidBodyContainerDyn_vortex*)this)->getWorld());
 #endif // INCLUDE_VORTEX_CODE
 
+            collShape->setCollisionShapeListIndex(int(_allCollisionShapes.size()));
             _allCollisionShapes.push_back(collShape);
+            _allCollisionShapesIndex[geom]=collShape;
             if (geom!=nullptr)
                 _simSetGeomProxyDynamicsFullRefreshFlag(geom,false);
         }
@@ -322,7 +482,7 @@ void CRigidBodyContainerDyn::_addOrUpdateRigidBody(CDummyShape* shape,bool force
 
         // Now add a dependent rigidBodyID to the collshape:
         if (collShape!=nullptr)
-            collShape->addRigidBodyDependency(body->getRigidBodyID());
+            collShape->addRigidBodyDependency();
 
         _simSetDynamicSimulationIconCode(shape,sim_dynamicsimicon_objectisdynamicallysimulated);
     }
@@ -360,12 +520,9 @@ CConstraintDyn* CRigidBodyContainerDyn::getConstraintFromForceSensorID(int force
 
 CCollShapeDyn* CRigidBodyContainerDyn::getCollisionShapeFromGeomObject(CDummyGeomProxy* geomData)
 {
-    for (int i=0;i<int(_allCollisionShapes.size());i++)
-    {
-        CCollShapeDyn* collShape=_allCollisionShapes[i];
-        if (geomData==collShape->getGeomData_nullForNonRespondable())
-            return(collShape);
-    }
+    std::unordered_map<CDummyGeomProxy*,CCollShapeDyn*>::iterator it=_allCollisionShapesIndex.find(geomData);
+    if (it!=_allCollisionShapesIndex.end())
+        return(it->second);
     return(nullptr);
 }
 
@@ -374,6 +531,16 @@ int CRigidBodyContainerDyn::_addRigidBody(CRigidBodyDyn* body)
     body->setRigidBodyID(_nextRigidBodyID);
     _allRigidBodiesList.push_back(body);
     _allRigidBodiesIndex[_simGetObjectID(body->getShape())]=body;
+    _visualizationFlagMightChange(_simGetObjectID(body->getShape()));
+    _writeBackOrderIsDirty=true;
+    _kinematicBodiesAreDirty=true;
+    if (_collisionFilters.size()<_allRigidBodiesIndex.size())
+    {
+        SCollisionFilter filter;
+        filter.generation=0; // never valid
+        _collisionFilters.resize(_allRigidBodiesIndex.size(),filter);
+    }
+    _collisionFilters[_simGetObjectID(body->getShape())].generation=0;
     return(_nextRigidBodyID++);
 }
 
@@ -384,7 +551,7 @@ void CRigidBodyContainerDyn::_removeRigidBody(int rigidBodyID)
         CRigidBodyDyn* body=_allRigidBodiesList[i];
         if (rigidBodyID==body->getRigidBodyID())
         {
-            removeRigidBodyFromCollisionShapeDependency(rigidBodyID);
+            removeRigidBodyFromCollisionShapeDependency(body);
             _announceToConstraintsBodyWillBeDestroyed(rigidBodyID);
 
 #ifdef INCLUDE_BULLET_2_78_CODE
@@ -408,6 +575,33 @@ void CRigidBodyContainerDyn::_removeRigidBody(int rigidBodyID)
 #endif // INCLUDE_VORTEX_CODE
 
             _allRigidBodiesIndex[body->getShapeID()]=nullptr;
+            _visualizationFlagMightChange(body->getShapeID());
+            _writeBackOrderIsDirty=true;
+            _kinematicBodiesAreDirty=true;
+            for (int j=0;j<int(_movedKinematicBodies.size());j++)
+            {
+                if (_movedKinematicBodies[j]==body)
+                {
+                    _movedKinematicBodies.erase(_movedKinematicBodies.begin()+j);
+                    _movedKinematicShapes.erase(_movedKinematicShapes.begin()+j);
+                    break;
+                }
+            }
+            if (_sleepMode==dyn_sleep_on)
+            { // the removed body could have been supporting sleeping bodies. Bodies attached by a constraint were woken when the constraint was removed
+                int shapeID=body->getShapeID();
+                int indexSize=int(_allRigidBodiesIndex.size());
+                for (int j=0;j<int(_previousContactPairs.size())/2;j++)
+                {
+                    int otherID=-1;
+                    if (_previousContactPairs[2*j+0]==shapeID)
+                        otherID=_previousContactPairs[2*j+1];
+                    if (_previousContactPairs[2*j+1]==shapeID)
+                        otherID=_previousContactPairs[2*j+0];
+                    if ( (otherID>=0)&&(otherID<indexSize)&&(_allRigidBodiesIndex[otherID]!=nullptr) ) // particles have larger IDs
+                        _allRigidBodiesIndex[otherID]->wakeUp();
+                }
+            }
             delete body;
             _allRigidBodiesList.erase(_allRigidBodiesList.begin()+i);
             return;
@@ -421,79 +615,80 @@ void CRigidBodyContainerDyn::_updateRigidBodiesFromSceneShapes()
     for (int i=0;i<int(_allRigidBodiesList.size());i++)
     {
         CRigidBodyDyn* body=_allRigidBodiesList[i];
-
-        CDummyShape* shape=(CDummyShape*)_simGetObject(body->getShapeID());
-        if (shape!=nullptr)
-        {
-            CDummyGeomProxy* geomData=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shape);
-            CDummyGeomProxy* geomData2=(CDummyGeomProxy*)_simGetGeomProxyFromShape(body->getShape());
-            if ( (geomData==geomData2)||_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape) ) // we have to check that the attached geomData is still the same!
-            {
-                if ( (body->getCollisionShapeDyn()->getGeomData_nullForNonRespondable()!=nullptr)&&_simGetGeomProxyDynamicsFullRefreshFlag(geomData) ) // added on 2009/10/16
-                    shape=nullptr;
-            }
-            else
-                shape=nullptr;
-        }
-
-        if (shape==nullptr)
+        if (!_isRigidBodyStillValid(body))
         { // we have to remove that body!
             _removeRigidBody(body->getRigidBodyID());
             i--; // we have to reprocess that position
         }
-        else
-        { // we have to check if it is still valid:
-            bool remove=_simGetDynamicsFullRefreshFlag(shape)!=0; // new since 2009/10/16
-            int dp=_simGetTreeDynamicProperty(shape);
-            if ((dp&sim_objdynprop_dynamic)==0)
-            { // All shapes should be static. Should that shape also be non-respondable?
-                if ((dp&sim_objdynprop_respondable)==0)
-                    remove=true; // yes, we remove it
-                else
-                { // Here we have only to remove the shape if it was previously non-static (it will be added again a bit further down)
-                    // Following instruction replaced on 6/5/2011 (was a bug before I think).
-                    if (!body->isBodyKinematic())
-                        remove=true;
-                }
-            }
-            if (dp&sim_objdynprop_dynamic)
-            {
-                if (body->isBodyKinematic())
-                { // static
-                    if ( (_simIsShapeDynamicallyRespondable(shape)==0)&&(_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape)==0) )
-                        remove=true;
-                    if (_simIsShapeDynamicallyStatic(shape)==0) // added on 2010/08/07
-                        remove=true; // That means: this is usually dynamic, but now static: we have overriden the dynamic characteristic!
-                }
-            }
-            if (remove)
-            { // we have to remove that body!
-                _removeRigidBody(body->getRigidBodyID());
-                i--; // we have to reprocess that position
-            }
-        }
     }
 
     // 2. we have to add new shapes
     int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
     for (int i=0;i<shapeListSize;i++)
+        _updateRigidBodyFromSceneShape((CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i));
+}
+
+bool CRigidBodyContainerDyn::_isRigidBodyStillValid(CRigidBodyDyn* body)
+{ // return value false means the body has to be removed (it might be added again a bit further down)
+    CDummyShape* shape=(CDummyShape*)_simGetObject(body->getShapeID());
+    if (shape!=nullptr)
     {
-        CDummyShape* shape=(CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i);
-        if ( _simIsShapeDynamicallyRespondable(shape)||(_simIsShapeDynamicallyStatic(shape)==0)||_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape) )
+        CDummyGeomProxy* geomData=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shape);
+        CDummyGeomProxy* geomData2=(CDummyGeomProxy*)_simGetGeomProxyFromShape(body->getShape());
+        if ( (geomData==geomData2)||_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape) ) // we have to check that the attached geomData is still the same!
         {
-            int dp=_simGetTreeDynamicProperty(shape);
-            if (dp&sim_objdynprop_dynamic) // Make sure the shape is enabled dynamically
-                _addOrUpdateRigidBody(shape,false,(dp&sim_objdynprop_respondable)==0);
+            if ( (body->getCollisionShapeDyn()->getGeomData_nullForNonRespondable()!=nullptr)&&_simGetGeomProxyDynamicsFullRefreshFlag(geomData) ) // added on 2009/10/16
+                shape=nullptr;
+        }
+        else
+            shape=nullptr;
+    }
+    if (shape==nullptr)
+        return(false);
+
+    // we have to check if it is still valid:
+    bool remove=_simGetDynamicsFullRefreshFlag(shape)!=0; // new since 2009/10/16
+    int dp=_simGetTreeDynamicProperty(shape);
+    if ((dp&sim_objdynprop_dynamic)==0)
+    { // All shapes should be static. Should that shape also be non-respondable?
+        if ((dp&sim_objdynprop_respondable)==0)
+            remove=true; // yes, we remove it
+        else
+        { // Here we have only to remove the shape if it was previously non-static (it will be added again a bit further down)
+            // Following instruction replaced on 6/5/2011 (was a bug before I think).
+            if (!body->isBodyKinematic())
+                remove=true;
+        }
+    }
+    if (dp&sim_objdynprop_dynamic)
+    {
+        if (body->isBodyKinematic())
+        { // static
+            if ( (_simIsShapeDynamicallyRespondable(shape)==0)&&(_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape)==0) )
+                remove=true;
+            if (_simIsShapeDynamicallyStatic(shape)==0) // added on 2010/08/07
+                remove=true; // That means: this is usually dynamic, but now static: we have overriden the dynamic characteristic!
+        }
+    }
+    return(!remove);
+}
+
+void CRigidBodyContainerDyn::_updateRigidBodyFromSceneShape(CDummyShape* shape)
+{
+    if ( _simIsShapeDynamicallyRespondable(shape)||(_simIsShapeDynamicallyStatic(shape)==0)||_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape) )
+    {
+        int dp=_simGetTreeDynamicProperty(shape);
+        if (dp&sim_objdynprop_dynamic) // Make sure the shape is enabled dynamically
+            _addOrUpdateRigidBody(shape,false,(dp&sim_objdynprop_respondable)==0);
+        else
+        { // that shape should be static
+            if (dp&sim_objdynprop_respondable)
+                _addOrUpdateRigidBody(shape,true,false); // add the shape, but let it appear static
             else
-            { // that shape should be static
-                if (dp&sim_objdynprop_respondable)
-                    _addOrUpdateRigidBody(shape,true,false); // add the shape, but let it appear static
-                else
-                    _simSetDynamicSimulationIconCode(shape,sim_dynamicsimicon_none);
-            }
+                _simSetDynamicSimulationIconCode(shape,sim_dynamicsimicon_none);
         }
-        _simSetDynamicsFullRefreshFlag(shape,false);
     }
+    _simSetDynamicsFullRefreshFlag(shape,false);
 }
 
 bool CRigidBodyContainerDyn::isDynamicContentAvailable()
@@ -508,10 +703,22 @@ bool CRigidBodyContainerDyn::isDynamicContentAvailable()
 
 void CRigidBodyContainerDyn::handleDynamics(float dt,float simulationTime)
 {
-    currentRigidBodyContainerDynObject=this; // so that ODE's contact callback works! (and maybe Vortex too)
+    startDynamics(dt,simulationTime,false);
+    finishDynamics();
+}
 
+void CRigidBodyContainerDyn::startDynamics(float dt,float simulationTime,bool asynchronous)
+{ // when asynchronous is true, the engine step of the last sub-pass runs on a worker thread (ODE only), and nothing is written to the scene before finishDynamics.
+  // Call finishDynamics to complete the step
+    finishDynamics(); // in case the previous step is still pending
+    currentRigidBodyContainerDynObject=this; // so that ODE's contact callback works! (and maybe Vortex too)
+    DYN_PROFILE_BEGIN_STEP();
+    _stepPending=true;
+    _stepIsAsynchronous=asynchronous;
 
     _timeStepPassedToHandleDynamicsFunction=dt;
+    _stepSimulationTime=simulationTime;
+    _customContactHandledInStep=_customContactHandled.exchange(false); // previous step
     float maxDynStep=0.0f;
 
 #ifdef INCLUDE_BULLET_2_78_CODE
@@ -534,56 +741,160 @@ void CRigidBodyContainerDyn::handleDynamics(float dt,float simulationTime)
     maxDynStep=simGetEngineFloatParameter(sim_vortex_global_stepsize,-1,nullptr,nullptr);
 #endif // INCLUDE_VORTEX_CODE
 
-    _dynamicsCalculationPasses=int((dt/maxDynStep)+0.5f);
-    if (_dynamicsCalculationPasses<1)
-        _dynamicsCalculationPasses=1;
+    int fixedPasses=int((dt/maxDynStep)+0.5f);
+    if (fixedPasses<1)
+        fixedPasses=1;
+    _dynamicsCalculationPasses=_getPassesToUse(fixedPasses);
+    _stepMaxPenetration=0.0f;
     float effStepSize=dt/float(_dynamicsCalculationPasses);
     setDynamicsInternalTimeStep(effStepSize);
 
+    if (_sleepMode==dyn_sleep_on)
+    { // see _wakeBodiesTouchingMovingKinematicBodies
+        _previousContactPairs.clear();
+        _contacts.reserveCounted(_previousContactPairs,size_t(2*_contacts.getCount()));
+        for (int i=0;i<_contacts.getCount();i++)
+        {
+            _previousContactPairs.push_back(_contacts.getObjectID1(i));
+            _previousContactPairs.push_back(_contacts.getObjectID2(i));
+        }
+    }
+
     // Following is not for the visible contacts, but for the contacts callable from the API:
-    _contactInfo.clear();
+    if (asynchronous)
+    { // readers will see the results of the previous step until this one is finished
+        _contactsSnapshot.swap(_contacts);
+        _contactPointsSnapshot.swap(_contactPoints);
+    }
+    _contacts.clear();
 
-    int jointListSize=_simGetObjectListSize(sim_object_joint_type);
-    int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
-    for (int i=0;i<jointListSize;i++)
-        _simSetDynamicJointLocalTransformationPart2IsValid((CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i),false);
-    for (int i=0;i<forceSensorListSize;i++) // this and next line since 2010/02/13
-        _simSetDynamicForceSensorLocalTransformationPart2IsValid((CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i),false);
+    _invalidateJointAndForceSensorPart2s();
 
 
-    bool particlesPresent=_updateDynamicWorld();
-    _createDependenciesBetweenJoints();
+    bool particlesPresent;
+    {
+        DYN_PROFILE_PHASE(dyn_profphase_worldupdate);
+        _invalidateCollisionFilters();
+        particlesPresent=_updateDynamicWorld();
+        _validateWriteBackOrder();
+        _validateMotorSchedule();
+        _createDependenciesBetweenJoints();
+    }
     _contactPoints.clear(); // We have it here too in case we suddenly remove all dynamic content!
 
-    if (isDynamicContentAvailable()||particlesPresent)
+    _stepHasDynamicContent=(isDynamicContentAvailable()||particlesPresent);
+    if (_stepHasDynamicContent)
     {
-        applyGravity();
+        {
+            DYN_PROFILE_PHASE(dyn_profphase_gravity);
+            applyGravity();
+        }
 
-        _calculateBodyToShapeTransformations_forKinematicBodies(dt);
+        {
+            DYN_PROFILE_PHASE(dyn_profphase_kinematicinterpolation);
+            _calculateBodyToShapeTransformations_forKinematicBodies(dt);
+            if (_sleepMode==dyn_sleep_on)
+                _wakeBodiesTouchingMovingKinematicBodies();
+        }
         int passes=getDynamicsCalculationPasses(); // previously calculated
-        for (int i=0;i<passes;i++)
+        for (int i=0;i<passes-1;i++)
+        {
+            _preparePass(i);
+            {
+                DYN_PROFILE_PHASE(dyn_profphase_stepdynamics);
+                _stepDynamics(effStepSize,i);
+            }
+            _finishPass(i);
+        }
+        _preparePass(passes-1);
+        bool collisionsDone=false;
+        if (asynchronous)
+        {
+            DYN_PROFILE_PHASE(dyn_profphase_stepdynamics);
+            collisionsDone=_stepDynamicsCollisions(effStepSize,passes-1);
+        }
+        if (collisionsDone)
+        { // everything that calls into the simulator was done above, only the integration runs in the background
+            _asyncStepRunning=true;
+            _asyncStepThread=std::thread(&CRigidBodyContainerDyn::_asyncStepDynamics,this);
+        }
+        else
+        {
+            DYN_PROFILE_PHASE(dyn_profphase_stepdynamics);
+            _stepDynamics(effStepSize,passes-1);
+        }
+    }
+}
+
+void CRigidBodyContainerDyn::_invalidateJointAndForceSensorPart2s()
+{ // the constraints validate them again when reporting their configuration
+    if ( (_worldSyncMode==dyn_worldsync_fullrescan)||(_objectSyncStates.size()==0) )
+    {
+        int jointListSize=_simGetObjectListSize(sim_object_joint_type);
+        int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
+        for (int i=0;i<jointListSize;i++)
+            _simSetDynamicJointLocalTransformationPart2IsValid((CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i),false);
+        for (int i=0;i<forceSensorListSize;i++) // this and next line since 2010/02/13
+            _simSetDynamicForceSensorLocalTransformationPart2IsValid((CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i),false);
+    }
+    else
+    { // only joints and force sensors with a constraint can be valid: the others were invalidated in the step their constraint got removed, or never validated
+        for (int i=0;i<int(_allConstraintsList.size());i++)
         {
-            int integers[4]={0,i+1,passes,0};
-            float floats[1]={CRigidBodyContainerDyn::getDynamicsInternalTimeStep()};
-            _simDynCallback(integers,floats);
-            reportShapeConfigurations_forKinematicBodies(float(i+1)/float(passes),dt);
-            _handleMotorControls(i+1,passes); // to enable/disable motors, to update target velocities, target positions and position control
-            handleAdditionalForcesAndTorques(); // for shapes but also for "anti-gravity" particles or particels with fluid friction force!
+            CConstraintDyn* constraint=_allConstraintsList[i];
+            if (constraint->getJointID()!=-1)
+            {
+                CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
+                if (joint!=nullptr)
+                    _simSetDynamicJointLocalTransformationPart2IsValid(joint,false);
+            }
+            if (constraint->getForceSensorID()!=-1)
+            {
+                CDummyForceSensor* forceSensor=(CDummyForceSensor*)_simGetObject(constraint->getForceSensorID());
+                if (forceSensor!=nullptr)
+                    _simSetDynamicForceSensorLocalTransformationPart2IsValid(forceSensor,false);
+            }
+        }
+    }
+}
 
-            _contactPoints.clear(); // 2010/10/07
+void CRigidBodyContainerDyn::_asyncStepDynamics()
+{
+    currentRigidBodyContainerDynObject=this;
+    DYN_PROFILE_PHASE_DEFERRED(_asyncStepTime); // the profiler belongs to the main thread
+    _stepDynamicsIntegration(getDynamicsInternalTimeStep(),getDynamicsCalculationPasses()-1);
+}
 
-            _stepDynamics(effStepSize,i);
+void CRigidBodyContainerDyn::finishDynamics()
+{ // completes the step started with startDynamics. Does nothing if no step is pending
+    if (!_stepPending)
+        return;
+    if (_asyncStepRunning)
+    {
+        _asyncStepThread.join();
+        _asyncStepRunning=false;
+        DYN_PROFILE_ADD_PHASE_TIME(dyn_profphase_stepdynamics,_asyncStepTime);
+    }
+    currentRigidBodyContainerDynObject=this;
+    _stepPending=false;
 
-            int totalPassesCount=0;
-            if (i==passes-1)
-                totalPassesCount=passes;
-            // Following moved inside the passes loop on 2009/11/29
-            reportDynamicWorldConfiguration(totalPassesCount,false,simulationTime+float(i+1)*dt/float(passes));
-            integers[3]=1;
-            _simDynCallback(integers,floats);
+    if (_stepHasDynamicContent)
+    {
+        int passes=getDynamicsCalculationPasses();
+        _finishPass(passes-1);
+        {
+            DYN_PROFILE_PHASE(dyn_profphase_kinematicinterpolation);
+            _applyCorrectEndConfig_forKinematicBodies(); // Added on 2010/10/7 to correct for subtle things for ODE (maybe even for Bullet!)
         }
-        _applyCorrectEndConfig_forKinematicBodies(); // Added on 2010/10/7 to correct for subtle things for ODE (maybe even for Bullet!)
+        DYN_PROFILE_SET_COUNTER(dyn_profcounter_subpasses,passes);
+        if (_subStepMode==dyn_substep_adaptive)
+            _measureStepErrors();
+        DYN_PROFILE_SET_COUNTER(dyn_profcounter_substepreasons,_stepMeasuresExceeded);
     }
+    DYN_PROFILE_SET_COUNTER(dyn_profcounter_bodies,int(_allRigidBodiesList.size()));
+    DYN_PROFILE_SET_COUNTER(dyn_profcounter_constraints,int(_allConstraintsList.size()));
+    DYN_PROFILE_SET_COUNTER(dyn_profcounter_collisionshapes,int(_allCollisionShapes.size()));
+    DYN_PROFILE_SET_COUNTER(dyn_profcounter_contacts,_contacts.getCount());
 
 
 #ifdef INCLUDE_VORTEX_CODE
@@ -592,117 +903,676 @@ void CRigidBodyContainerDyn::handleDynamics(float dt,float simulationTime)
 
     clearAdditionalForcesAndTorques();
 
-    // 1=respondable, 2=dynamic, 4=free, 8=motor, 16=pos control,32=force sensor, 64=loop closure dummy
-    // Do following always, also when displaying the normal scene (so that when we switch during a pause, it looks correct)
-    int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
-    for (int i=0;i<shapeListSize;i++)
     {
-        CDummyShape* it=(CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i);
-        CRigidBodyDyn* b=_allRigidBodiesIndex[_simGetObjectID(it)];
-        if (b!=nullptr)
-        {
-            int flag=0;
-            if (!b->isBodyKinematic())
-                flag|=2;
-            if ( _simIsShapeDynamicallyRespondable(it)&&(_simGetDynamicCollisionMask(it)!=0)&&((_simGetTreeDynamicProperty(it)&sim_objdynprop_respondable)!=0) )
-                flag|=1;
-            _simSetDynamicObjectFlagForVisualization(it,flag);
-        }
+        DYN_PROFILE_PHASE(dyn_profphase_visualizationflags);
+        _updateVisualizationFlags();
     }
-    for (int i=0;i<jointListSize;i++)
+    DYN_PROFILE_END_STEP();
+}
+
+bool CRigidBodyContainerDyn::isStepPending()
+{
+    return(_stepPending);
+}
+
+void CRigidBodyContainerDyn::_wakeBodiesTouchingMovingKinematicBodies()
+{ // not all engines wake a sleeping body that a moving kinematic body touches. We use the contacts of the previous step
+    int indexSize=int(_allRigidBodiesIndex.size());
+    for (int i=0;i<int(_previousContactPairs.size())/2;i++)
     {
-        CDummyJoint* it=(CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i);
-        CConstraintDyn* c=_allConstraintsIndex[_simGetObjectID(it)];
-        if (c!=nullptr)
+        int id1=_previousContactPairs[2*i+0];
+        int id2=_previousContactPairs[2*i+1];
+        if ( (id1>=0)&&(id1<indexSize)&&(id2>=0)&&(id2<indexSize) ) // particles have larger IDs
         {
-            int flag=0;
-            if (_simIsDynamicMotorEnabled(it))
+            CRigidBodyDyn* body1=_allRigidBodiesIndex[id1];
+            CRigidBodyDyn* body2=_allRigidBodiesIndex[id2];
+            if ( (body1!=nullptr)&&(body2!=nullptr) )
             {
-                if (_simIsDynamicMotorPositionCtrlEnabled(it))
-                    flag=16;
-                else
-                    flag=8;                    
+                if (body1->isKinematicBodyMoving()&&body2->isSleeping())
+                    body2->wakeUp();
+                if (body2->isKinematicBodyMoving()&&body1->isSleeping())
+                    body1->wakeUp();
             }
-            else
-                flag=4;
-            _simSetDynamicObjectFlagForVisualization(it,flag);
         }
     }
-    for (int i=0;i<forceSensorListSize;i++)
+}
+
+int CRigidBodyContainerDyn::_getPassesToUse(int fixedPasses)
+{ // the passes always divide dt exactly, only their count changes
+    if (_subStepMode!=dyn_substep_adaptive)
+        return(fixedPasses);
+    int maxPasses=fixedPasses*_adaptiveSubStepMaxPassFactor;
+    if (_adaptivePasses==0)
+        _adaptivePasses=fixedPasses; // first step
+    if (_adaptivePasses>maxPasses)
+        _adaptivePasses=maxPasses;
+    return(_adaptivePasses);
+}
+
+void CRigidBodyContainerDyn::_measureStepErrors()
+{ // measures the step that just ended and decides on the passes of the next one:
+  // double them as soon as a threshold is exceeded, halve them after a while well below all thresholds
+    _stepMeasures[0]=_stepMaxPenetration;
+    _stepMeasures[1]=0.0f;
+    for (int i=0;i<int(_allConstraintsList.size());i++)
     {
-        CDummyForceSensor* it=(CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i);
-        CConstraintDyn* c=_allConstraintsIndex[_simGetObjectID(it)];
-        if (c!=nullptr)
-            _simSetDynamicObjectFlagForVisualization(it,32);
+        CConstraintDyn* constraint=_allConstraintsList[i];
+        bool prismatic=false;
+        if (constraint->getJointID()!=-1)
+        {
+            CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
+            prismatic=( (joint!=nullptr)&&(_simGetJointType(joint)==sim_joint_prismatic_subtype) );
+        }
+        float err=constraint->getPositionalError(prismatic);
+        if (err>_stepMeasures[1])
+            _stepMeasures[1]=err;
     }
-    int dummyListSize=_simGetObjectListSize(sim_object_dummy_type);
-    for (int i=0;i<dummyListSize;i++)
+    _stepMeasures[2]=0.0f;
+    float velScaling=getLinearVelocityScalingFactorDyn();
+    for (int i=0;i<int(_allRigidBodiesList.size());i++)
     {
-        CDummyDummy* it=(CDummyDummy*)_simGetObjectFromIndex(sim_object_dummy_type,i);
-        CConstraintDyn* c=_allConstraintsIndex[_simGetObjectID(it)];
-        if (c!=nullptr)
-            _simSetDynamicObjectFlagForVisualization(it,64);
+        SRigidBodyState bodyState;
+        if ( (!_allRigidBodiesList[i]->isBodyKinematic())&&_allRigidBodiesList[i]->getState(bodyState) )
+        {
+            C3Vector v(float(bodyState.linearVelocity[0]),float(bodyState.linearVelocity[1]),float(bodyState.linearVelocity[2]));
+            float vel=v.getLength()/velScaling; // ********** SCALING
+            if (vel>_stepMeasures[2])
+                _stepMeasures[2]=vel;
+        }
+    }
+
+    _stepMeasuresExceeded=0;
+    bool calm=true;
+    for (int i=0;i<3;i++)
+    {
+        if (_stepMeasures[i]>_adaptiveSubStepThresholds[i])
+            _stepMeasuresExceeded|=(1<<i);
+        if (_stepMeasures[i]>0.5f*_adaptiveSubStepThresholds[i])
+            calm=false;
+    }
+    if (_stepMeasuresExceeded!=0)
+    {
+        _adaptivePasses*=2; // clamped in _getPassesToUse
+        _adaptiveCalmSteps=0;
+    }
+    else if (calm)
+    {
+        _adaptiveCalmSteps++;
+        if ( (_adaptiveCalmSteps>=10)&&(_adaptivePasses>1) )
+        {
+            _adaptivePasses/=2;
+            _adaptiveCalmSteps=0;
+        }
     }
+    else
+        _adaptiveCalmSteps=0;
 }
 
-void CRigidBodyContainerDyn::reportDynamicWorldConfiguration(int totalPassesCount,bool doNotApplyJointIntrinsicPositions,float simulationTime)
-{ // can also be called from outside (i.e. LuaScriptObject). In that case totalPassesCount should be -1 and doNotApplyJointIntrinsicPositions true
-    reportConstraintConfigurations(totalPassesCount,doNotApplyJointIntrinsicPositions); // do this before reportRigidBodyConfigurations!!
-    reportRigidBodyConfigurationsAndVelocities();
-    reportConstraintSecondPartConfigurations(); // do this after reportRigidBodyConfigurations!!
-    particleCont.updateParticlesPosition(simulationTime);
+int CRigidBodyContainerDyn::getSubStepMeasures(float measures[3])
+{ // measures of the last step (adaptive sub-stepping only). Returns the dyn_substepreason_* bits that caused more passes
+    for (int i=0;i<3;i++)
+        measures[i]=_stepMeasures[i];
+    return(_stepMeasuresExceeded);
 }
 
-void CRigidBodyContainerDyn::reportRigidBodyConfigurationsAndVelocities()
-{
-    // first set all velocities to zero:
-    int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
-    for (int i=0;i<shapeListSize;i++)
+void CRigidBodyContainerDyn::_preparePass(int pass)
+{ // everything that happens in a sub-pass before the engine step
+    int passes=getDynamicsCalculationPasses();
+    int integers[4]={0,pass+1,passes,0};
+    float floats[1]={CRigidBodyContainerDyn::getDynamicsInternalTimeStep()};
+    _simDynCallback(integers,floats);
     {
-        CDummyShape* it=(CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i);
-        if (it!=nullptr)
-            _simSetShapeDynamicVelocity(it,C3Vector::zeroVector.data,C3Vector::zeroVector.data);
+        DYN_PROFILE_PHASE(dyn_profphase_kinematicinterpolation);
+        reportShapeConfigurations_forKinematicBodies(float(pass+1)/float(passes),_timeStepPassedToHandleDynamicsFunction);
     }
-    // It is important that we update shapes from base to tip, otherwise we get wrong positions!
-    std::vector<CDummy3DObject*> toExplore;
-    int orphanListSize=_simGetObjectListSize(-1);
-    for (int i=0;i<orphanListSize;i++)
     {
-        toExplore.push_back((CDummy3DObject*)_simGetObjectFromIndex(-1,i));
-        for (int j=0;j<int(toExplore.size());j++)
-        {
-            CDummy3DObject* it=toExplore[j];
-            if (_simGetObjectType(it)==sim_object_shape_type)
-            {
-                CDummyShape* shape=(CDummyShape*)it;
-                int shapeID=_simGetObjectID(shape);
+        DYN_PROFILE_PHASE(dyn_profphase_motorcontrol);
+        _handleMotorControls(pass+1,passes); // to enable/disable motors, to update target velocities, target positions and position control
+    }
+    {
+        DYN_PROFILE_PHASE(dyn_profphase_additionalforces);
+        handleAdditionalForcesAndTorques(); // for shapes
+    }
+    C3Vector gravity;
+    _simGetGravity(gravity.data);
+    {
+        DYN_PROFILE_PHASE(dyn_profphase_particles);
+        int fluidParticles=particleCont.handleAntiGravityForces_andFluidFrictionForces(gravity); // for "anti-gravity" particles or particels with fluid friction force!
+        DYN_PROFILE_SET_COUNTER(dyn_profcounter_fluidparticles,fluidParticles);
+    }
 
-                CRigidBodyDyn* rb=getRigidBodyFromShapeID(shapeID);
-                if (rb!=nullptr)
-                {
-                    rb->reportConfigurationToShape(shape);
-                    rb->reportVelocityToShape(shape);
-                }
-            }
-            // Now its own children:
-            int childrenCount;
-            CDummy3DObject** childrenPointer=(CDummy3DObject**)_simGetObjectChildren(it,&childrenCount);
-            if (childrenCount>0)
-                toExplore.insert(toExplore.end(),childrenPointer,childrenPointer+childrenCount);
-        }
-        toExplore.clear();
+    _contactPoints.clear(); // 2010/10/07
+
+    _invalidateCollisionFilters(); // masks, etc. could have been changed by a callback
+    {
+        DYN_PROFILE_PHASE(dyn_profphase_particles);
+        particleCont.stepParticleSystem(this,getDynamicsInternalTimeStep(),gravity); // dyn_particleengine_soa particles. Adds their reaction forces to the bodies
     }
 }
 
-void CRigidBodyContainerDyn::reportConstraintConfigurations(int totalPassesCount,bool doNotApplyJointIntrinsicPositions)
-{
-    for (int i=0;i<int(_allConstraintsList.size());i++)
+void CRigidBodyContainerDyn::_finishPass(int pass)
+{ // everything that happens in a sub-pass after the engine step
+    int passes=getDynamicsCalculationPasses();
+    float dt=_timeStepPassedToHandleDynamicsFunction;
     {
-        CConstraintDyn* constraint=_allConstraintsList[i];
+        DYN_PROFILE_PHASE(dyn_profphase_contactextraction);
+        _contacts.indexLastPass(pass);
+    }
 
-        CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
-        if (joint!=nullptr)
-        {
+    int totalPassesCount=0;
+    if (pass==passes-1)
+        totalPassesCount=passes;
+    // Following moved inside the passes loop on 2009/11/29
+    {
+        DYN_PROFILE_PHASE(dyn_profphase_writeback);
+        if ( (pass==passes-1)||((!_stepIsAsynchronous)&&_isSubPassWriteBackNeeded()) ) // an asynchronous step leaves the scene in the state of the previous step until finishDynamics
+            reportDynamicWorldConfiguration(totalPassesCount,false,_stepSimulationTime+float(pass+1)*dt/float(passes));
+        else
+        { // intermediate state stays in the engine. Forces are averaged over all passes, so we still need to accumulate them:
+            reportConstraintForces(totalPassesCount);
+            particleCont.updateParticlesPosition(_stepSimulationTime+float(pass+1)*dt/float(passes));
+        }
+    }
+    int integers[4]={0,pass+1,passes,1};
+    float floats[1]={CRigidBodyContainerDyn::getDynamicsInternalTimeStep()};
+    _simDynCallback(integers,floats);
+}
+
+static void _appendToState(std::vector<unsigned char>& state,const void* data,int size)
+{
+    const unsigned char* d=(const unsigned char*)data;
+    state.insert(state.end(),d,d+size);
+}
+
+static bool _readFromState(const unsigned char* state,int stateSize,int& pos,void* data,int size)
+{
+    if (pos+size>stateSize)
+        return(false);
+    memcpy(data,state+pos,size);
+    pos+=size;
+    return(true);
+}
+
+bool CRigidBodyContainerDyn::saveState(std::vector<unsigned char>& state)
+{ // the collision shapes, bodies and constraints themselves are not saved: restoreState applies the state to the existing ones
+  // Returns false if the engine doesn't support it
+    state.clear();
+    int engine;
+    int data1[4];
+    char engineVersion[256];
+    getEngineInfo(engine,data1,engineVersion,nullptr);
+    int particleObjectCnt=0;
+    for (int i=0;i<particleCont.getObjectCount();i++)
+    {
+        if (particleCont.getObject(i,false)!=nullptr)
+            particleObjectCnt++;
+    }
+    int header[6]={dyn_state_version,int(sizeof(dynReal)),engine,int(_allRigidBodiesList.size()),int(_allConstraintsList.size()),particleObjectCnt};
+    _appendToState(state,header,sizeof(header));
+    for (int i=0;i<int(_allRigidBodiesList.size());i++)
+    {
+        CRigidBodyDyn* body=_allRigidBodiesList[i];
+        SRigidBodyState bodyState;
+        if (!body->getState(bodyState))
+        {
+            state.clear();
+            return(false);
+        }
+        int shapeID=body->getShapeID();
+        _appendToState(state,&shapeID,sizeof(shapeID));
+        _appendToState(state,&bodyState,sizeof(bodyState));
+    }
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+    {
+        CConstraintDyn* constraint=_allConstraintsList[i];
+        int objectID=constraint->getJointID(); // the index used in _allConstraintsIndex
+        if (constraint->getForceSensorID()!=-1)
+            objectID=constraint->getForceSensorID();
+        if (constraint->getDummyID()!=-1)
+            objectID=constraint->getDummyID();
+        SConstraintState constraintState;
+        constraint->getState(constraintState);
+        _appendToState(state,&objectID,sizeof(objectID));
+        _appendToState(state,&constraintState,sizeof(constraintState));
+    }
+    std::vector<SParticleState> particleStates;
+    for (int i=0;i<particleCont.getObjectCount();i++)
+    {
+        CParticleObject* particleObject=particleCont.getObject(i,false);
+        if (particleObject!=nullptr)
+        {
+            particleStates.clear();
+            particleObject->getParticleStates(particleStates);
+            int objectID=particleObject->getObjectID();
+            unsigned int uniqueID=particleObject->getUniqueID(); // object IDs are reused once an object is removed
+            int cnt=int(particleStates.size());
+            _appendToState(state,&objectID,sizeof(objectID));
+            _appendToState(state,&uniqueID,sizeof(uniqueID));
+            _appendToState(state,&cnt,sizeof(cnt));
+            if (cnt>0)
+                _appendToState(state,&particleStates[0],cnt*sizeof(SParticleState));
+        }
+    }
+    return(true);
+}
+
+bool CRigidBodyContainerDyn::restoreState(const unsigned char* state,int stateSize)
+{ // bodies, constraints and particle objects are matched by object handle. The ones that do not exist anymore are ignored, new ones keep their current state
+  // The scene objects are not moved: call reportDynamicWorldConfiguration for that. Nothing is applied if the data is not valid
+    int pos=0;
+    int header[6];
+    if (!_readFromState(state,stateSize,pos,header,sizeof(header)))
+        return(false);
+    int engine;
+    int data1[4];
+    char engineVersion[256];
+    getEngineInfo(engine,data1,engineVersion,nullptr);
+    if ( (header[0]!=dyn_state_version)||(header[1]!=int(sizeof(dynReal)))||(header[2]!=engine) )
+        return(false);
+    const int bodyRecordSize=int(sizeof(int)+sizeof(SRigidBodyState));
+    const int constraintRecordSize=int(sizeof(int)+sizeof(SConstraintState));
+    const int particleObjectRecordSize=int(sizeof(int)+sizeof(unsigned int)+sizeof(int)); // without the particles
+    if ( (header[3]<0)||(header[3]>(stateSize-pos)/bodyRecordSize) )
+        return(false);
+    if ( (header[4]<0)||(header[4]>(stateSize-pos)/constraintRecordSize) )
+        return(false);
+    if ( (header[5]<0)||(header[5]>(stateSize-pos)/particleObjectRecordSize) )
+        return(false);
+
+    // 1. We read and validate everything:
+    std::vector<int> shapeIDs(header[3]);
+    std::vector<SRigidBodyState> bodyStates(header[3]);
+    for (int i=0;i<header[3];i++)
+    {
+        if ( (!_readFromState(state,stateSize,pos,&shapeIDs[i],sizeof(int)))||(!_readFromState(state,stateSize,pos,&bodyStates[i],sizeof(SRigidBodyState))) )
+            return(false);
+    }
+    std::vector<int> constraintObjectIDs(header[4]);
+    std::vector<SConstraintState> constraintStates(header[4]);
+    for (int i=0;i<header[4];i++)
+    {
+        if ( (!_readFromState(state,stateSize,pos,&constraintObjectIDs[i],sizeof(int)))||(!_readFromState(state,stateSize,pos,&constraintStates[i],sizeof(SConstraintState))) )
+            return(false);
+    }
+    std::vector<int> particleObjectIDs(header[5]);
+    std::vector<unsigned int> particleObjectUniqueIDs(header[5]);
+    std::vector<int> particleStateStarts(header[5]+1,0); // in particleStates
+    std::vector<SParticleState> particleStates;
+    for (int i=0;i<header[5];i++)
+    {
+        int cnt;
+        if ( (!_readFromState(state,stateSize,pos,&particleObjectIDs[i],sizeof(int)))||(!_readFromState(state,stateSize,pos,&particleObjectUniqueIDs[i],sizeof(unsigned int)))||(!_readFromState(state,stateSize,pos,&cnt,sizeof(cnt))) )
+            return(false);
+        if ( (cnt<0)||(cnt>(stateSize-pos)/int(sizeof(SParticleState))) )
+            return(false);
+        particleStates.resize(particleStateStarts[i]+cnt);
+        if ( (cnt>0)&&(!_readFromState(state,stateSize,pos,&particleStates[particleStateStarts[i]],cnt*sizeof(SParticleState))) )
+            return(false);
+        particleStateStarts[i+1]=particleStateStarts[i]+cnt;
+    }
+    if (pos!=stateSize)
+        return(false);
+
+    // 2. We apply it:
+    for (int i=0;i<header[3];i++)
+    {
+        int shapeID=shapeIDs[i];
+        if ( (shapeID>=0)&&(shapeID<int(_allRigidBodiesIndex.size()))&&(_allRigidBodiesIndex[shapeID]!=nullptr) )
+            _allRigidBodiesIndex[shapeID]->setState(bodyStates[i]);
+    }
+    for (int i=0;i<header[4];i++)
+    {
+        int objectID=constraintObjectIDs[i];
+        if ( (objectID>=0)&&(objectID<int(_allConstraintsIndex.size()))&&(_allConstraintsIndex[objectID]!=nullptr) )
+            _allConstraintsIndex[objectID]->setState(constraintStates[i]);
+    }
+    for (int i=0;i<header[5];i++)
+    {
+        CParticleObject* particleObject=particleCont.getObject(particleObjectIDs[i],false);
+        if ( (particleObject!=nullptr)&&(particleObject->getUniqueID()==particleObjectUniqueIDs[i]) )
+            particleObject->restoreParticles(particleStates.data()+particleStateStarts[i],particleStateStarts[i+1]-particleStateStarts[i]);
+    }
+    _resetContactCaches();
+    _contacts.clear();
+    _contactPoints.clear();
+    return(true);
+}
+
+void CRigidBodyContainerDyn::_updateVisualizationFlags()
+{
+    if (_visualizationFlagMode==dyn_visflags_off)
+    {
+        _visualizationFlagsSet.clear();
+        _visualizationFlagChanges.clear();
+        return;
+    }
+    if (_visualizationFlagMode==dyn_visflags_onchange)
+    { // the simulator keeps the flags it was given
+        if (_visualizationFlagsSet.size()!=_allRigidBodiesIndex.size())
+        { // first step in this mode: all flags are set once
+            _visualizationFlagsSet.assign(_allRigidBodiesIndex.size(),-1);
+            _visualizationFlagChanges.clear();
+            _collectVisualizationFlags();
+            for (int i=0;i<int(_visualizationFlagObjects.size());i++)
+            {
+                _simSetDynamicObjectFlagForVisualization(_visualizationFlagObjects[i],_visualizationFlagValues[i]);
+                _visualizationFlagsSet[_visualizationFlagObjectIDs[i]]=_visualizationFlagValues[i];
+            }
+        }
+        else
+        { // then only the objects the plugin reported (body or constraint added/removed, motor of a joint), see _visualizationFlagMightChange
+            for (int i=0;i<int(_visualizationFlagChanges.size());i++)
+            {
+                int objID=_visualizationFlagChanges[i];
+                CDummy3DObject* it=(CDummy3DObject*)_simGetObject(objID);
+                if (it!=nullptr)
+                {
+                    int flag=_getVisualizationFlag(objID,it);
+                    if (_visualizationFlagsSet[objID]!=flag)
+                    {
+                        _simSetDynamicObjectFlagForVisualization(it,flag);
+                        _visualizationFlagsSet[objID]=flag;
+                    }
+                }
+            }
+            _visualizationFlagChanges.clear();
+        }
+    }
+    else
+    {
+        _visualizationFlagsSet.clear(); // the flags set below are not tracked
+        _visualizationFlagChanges.clear();
+        _collectVisualizationFlags();
+        for (int i=0;i<int(_visualizationFlagObjects.size());i++)
+            _simSetDynamicObjectFlagForVisualization(_visualizationFlagObjects[i],_visualizationFlagValues[i]);
+    }
+}
+
+void CRigidBodyContainerDyn::_collectVisualizationFlags()
+{
+    // 1=respondable, 2=dynamic, 4=free, 8=motor, 16=pos control,32=force sensor, 64=loop closure dummy
+    // Do following always, also when displaying the normal scene (so that when we switch during a pause, it looks correct)
+    _visualizationFlagObjects.clear();
+    _visualizationFlagObjectIDs.clear();
+    _visualizationFlagValues.clear();
+    int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
+    for (int i=0;i<shapeListSize;i++)
+    {
+        CDummyShape* it=(CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i);
+        int objID=_simGetObjectID(it);
+        if (_allRigidBodiesIndex[objID]!=nullptr)
+        {
+            _visualizationFlagObjects.push_back(it);
+            _visualizationFlagObjectIDs.push_back(objID);
+            _visualizationFlagValues.push_back(_getVisualizationFlag(objID,it));
+        }
+    }
+    int jointListSize=_simGetObjectListSize(sim_object_joint_type);
+    for (int i=0;i<jointListSize;i++)
+    {
+        CDummyJoint* it=(CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i);
+        int objID=_simGetObjectID(it);
+        if (_allConstraintsIndex[objID]!=nullptr)
+        {
+            _visualizationFlagObjects.push_back(it);
+            _visualizationFlagObjectIDs.push_back(objID);
+            _visualizationFlagValues.push_back(_getVisualizationFlag(objID,it));
+        }
+    }
+    int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
+    for (int i=0;i<forceSensorListSize;i++)
+    {
+        CDummyForceSensor* it=(CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i);
+        int objID=_simGetObjectID(it);
+        CConstraintDyn* c=_allConstraintsIndex[objID];
+        if (c!=nullptr)
+        {
+            _visualizationFlagObjects.push_back(it);
+            _visualizationFlagObjectIDs.push_back(objID);
+            _visualizationFlagValues.push_back(32);
+        }
+    }
+    int dummyListSize=_simGetObjectListSize(sim_object_dummy_type);
+    for (int i=0;i<dummyListSize;i++)
+    {
+        CDummyDummy* it=(CDummyDummy*)_simGetObjectFromIndex(sim_object_dummy_type,i);
+        int objID=_simGetObjectID(it);
+        CConstraintDyn* c=_allConstraintsIndex[objID];
+        if (c!=nullptr)
+        {
+            _visualizationFlagObjects.push_back(it);
+            _visualizationFlagObjectIDs.push_back(objID);
+            _visualizationFlagValues.push_back(64);
+        }
+    }
+}
+
+int CRigidBodyContainerDyn::_getVisualizationFlag(int objectID,void* object)
+{ // the flag of an object (see _collectVisualizationFlags). 0 if it has no body or constraint
+    CRigidBodyDyn* b=_allRigidBodiesIndex[objectID];
+    if (b!=nullptr)
+    {
+        CDummyShape* it=(CDummyShape*)object;
+        int flag=0;
+        if (!b->isBodyKinematic())
+            flag|=2;
+        if ( _simIsShapeDynamicallyRespondable(it)&&(_simGetDynamicCollisionMask(it)!=0)&&((_simGetTreeDynamicProperty(it)&sim_objdynprop_respondable)!=0) )
+            flag|=1;
+        return(flag);
+    }
+    CConstraintDyn* c=_allConstraintsIndex[objectID];
+    if (c!=nullptr)
+    {
+        if (c->getJointID()==objectID)
+        {
+            CDummyJoint* it=(CDummyJoint*)object;
+            if (_simIsDynamicMotorEnabled(it))
+            {
+                if (_simIsDynamicMotorPositionCtrlEnabled(it))
+                    return(16);
+                return(8);
+            }
+            return(4);
+        }
+        if (c->getForceSensorID()==objectID)
+            return(32);
+        return(64); // loop closure dummy
+    }
+    return(0);
+}
+
+void CRigidBodyContainerDyn::_visualizationFlagMightChange(int objectID)
+{ // the flags only depend on the bodies and constraints, on the respondable properties (a change removes and re-adds the body, see
+  // _isRigidBodyStillValid) and on the motor of joints (checked in _handleMotorControls). Sleep and contact state are not shown
+    if ( (_visualizationFlagMode==dyn_visflags_onchange)&&(objectID>=0)&&(objectID<int(_visualizationFlagsSet.size())) )
+        _visualizationFlagChanges.push_back(objectID);
+}
+
+int CRigidBodyContainerDyn::getVisualizationFlags(int maxCount,int* objectHandles,int* flags)
+{ // the current flags of all objects that have a body or constraint. Copies up to maxCount of them, returns the total count
+    _collectVisualizationFlags();
+    int cnt=int(_visualizationFlagObjects.size());
+    for (int i=0;(i<cnt)&&(i<maxCount);i++)
+    {
+        objectHandles[i]=_visualizationFlagObjectIDs[i];
+        flags[i]=_visualizationFlagValues[i];
+    }
+    return(cnt);
+}
+
+void CRigidBodyContainerDyn::reportDynamicWorldConfiguration(int totalPassesCount,bool doNotApplyJointIntrinsicPositions,float simulationTime)
+{ // can also be called from outside (i.e. LuaScriptObject). In that case totalPassesCount should be -1 and doNotApplyJointIntrinsicPositions true
+    if (totalPassesCount<0)
+        _validateWriteBackOrder(); // the scene hierarchy might have changed since the last step
+    reportConstraintConfigurations(totalPassesCount,doNotApplyJointIntrinsicPositions); // do this before reportRigidBodyConfigurations!!
+    reportRigidBodyConfigurationsAndVelocities();
+    reportConstraintSecondPartConfigurations(); // do this after reportRigidBodyConfigurations!!
+    particleCont.updateParticlesPosition(simulationTime);
+}
+
+bool CRigidBodyContainerDyn::_isSubPassWriteBackNeeded()
+{ // contact callbacks can also read the scene during a sub-pass. The simulator can't tell us whether script contact callbacks
+  // are installed, so we write back as soon as it was asked about a colliding pair in this step or in the previous one
+    if (_writeBackMode==dyn_writeback_everypass)
+        return(true);
+    return(_intermediateWriteBackNeeded||_customContactHandledInStep||_customContactHandled);
+}
+
+void CRigidBodyContainerDyn::reportRigidBodyConfigurationsAndVelocities()
+{
+    // It is important that we update shapes from base to tip, otherwise we get wrong positions!
+    // The order is cached and only rebuilt when bodies were added/removed, or when the hierarchy changed
+    if (_writeBackOrderIsDirty)
+        _rebuildWriteBackOrder();
+    for (int i=0;i<int(_writeBackBodies.size());i++)
+    {
+        CRigidBodyDyn* rb=_writeBackBodies[i];
+        CDummyShape* shape=(CDummyShape*)_simGetObject(rb->getShapeID());
+        if (shape!=nullptr)
+        {
+            if ( (_sleepMode==dyn_sleep_on)&&rb->isSleeping()&&(_simGetParentObject(shape)==nullptr) )
+            { // a sleeping body does not move. We only skip it at the root of the hierarchy, since a moving parent would move it too
+                if (!rb->getSleepWrittenBack())
+                {
+                    rb->reportConfigurationToShape(shape);
+                    _simSetShapeDynamicVelocity(shape,C3Vector::zeroVector.data,C3Vector::zeroVector.data);
+                    rb->setSleepWrittenBack(true);
+                }
+                continue;
+            }
+            rb->setSleepWrittenBack(false);
+            // velocities of shapes with a rigid body are always overwritten here, no need to zero them first
+            rb->reportConfigurationToShape(shape);
+            rb->reportVelocityToShape(shape);
+        }
+    }
+}
+
+void CRigidBodyContainerDyn::_validateWriteBackOrder()
+{ // a shape's tree depth changes when itself or one of its ancestors was reparented. Each object of the parent chains is checked once
+    if (!_writeBackOrderIsDirty)
+    {
+        for (int i=0;i<int(_writeBackHierarchy.size())/2;i++)
+        {
+            CDummy3DObject* it=(CDummy3DObject*)_simGetObject(_writeBackHierarchy[2*i+0]);
+            if (it==nullptr)
+            {
+                _writeBackOrderIsDirty=true;
+                break;
+            }
+            CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(it);
+            int parentID=-1;
+            if (parent!=nullptr)
+                parentID=_simGetObjectID(parent);
+            if (parentID!=_writeBackHierarchy[2*i+1])
+            {
+                _writeBackOrderIsDirty=true;
+                break;
+            }
+        }
+    }
+}
+
+void CRigidBodyContainerDyn::_rebuildWriteBackOrder()
+{
+    _writeBackOrderIsDirty=false;
+    _writeBackHierarchy.clear();
+    // Sort the rigid bodies by tree depth of their shape (counting sort). Parents always come before children:
+    std::vector<CRigidBodyDyn*> bodies;
+    std::vector<int> depths;
+    std::vector<int> depthStarts;
+    std::vector<int> objectDepths(_allRigidBodiesIndex.size(),-1); // indexed by object ID
+    for (int i=0;i<int(_allRigidBodiesList.size());i++)
+    {
+        CDummy3DObject* shape=(CDummy3DObject*)_simGetObject(_allRigidBodiesList[i]->getShapeID());
+        if (shape!=nullptr)
+        {
+            int depth=_getObjectTreeDepth(shape,objectDepths);
+            bodies.push_back(_allRigidBodiesList[i]);
+            depths.push_back(depth);
+            if (depth+2>int(depthStarts.size()))
+                depthStarts.resize(depth+2,0);
+            depthStarts[depth+1]++;
+        }
+    }
+    for (int i=1;i<int(depthStarts.size());i++)
+        depthStarts[i]+=depthStarts[i-1];
+    _writeBackBodies.resize(bodies.size());
+    for (int i=0;i<int(bodies.size());i++)
+    {
+        int pos=depthStarts[depths[i]]++;
+        _writeBackBodies[pos]=bodies[i];
+    }
+    _zeroVelocitiesOfShapesWithoutBody();
+}
+
+void CRigidBodyContainerDyn::_zeroVelocitiesOfShapesWithoutBody()
+{ // Shapes without rigid body should report a zero velocity. Their velocity is not written anymore afterwards, so this is only
+    // done once for all shapes, then only for the shapes that lost their rigid body since the last write-back order rebuild
+    int indexSize=int(_allRigidBodiesIndex.size());
+    if (!_nonBodyShapeVelocitiesZeroed)
+    {
+        int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
+        for (int i=0;i<shapeListSize;i++)
+        {
+            CDummyShape* it=(CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i);
+            if (it!=nullptr)
+            {
+                int shapeID=_simGetObjectID(it);
+                if ( (shapeID<0)||(shapeID>=indexSize)||(_allRigidBodiesIndex[shapeID]==nullptr) )
+                    _simSetShapeDynamicVelocity(it,C3Vector::zeroVector.data,C3Vector::zeroVector.data);
+            }
+        }
+        _nonBodyShapeVelocitiesZeroed=true;
+    }
+    else
+    {
+        for (int i=0;i<int(_writeBackShapeIDs.size());i++)
+        {
+            int shapeID=_writeBackShapeIDs[i];
+            if ( (shapeID>=indexSize)||(_allRigidBodiesIndex[shapeID]==nullptr) )
+            { // that shape lost its rigid body
+                CDummyShape* it=(CDummyShape*)_simGetObject(shapeID);
+                if (it!=nullptr)
+                    _simSetShapeDynamicVelocity(it,C3Vector::zeroVector.data,C3Vector::zeroVector.data);
+            }
+        }
+    }
+    _writeBackShapeIDs.resize(_writeBackBodies.size());
+    for (int i=0;i<int(_writeBackBodies.size());i++)
+        _writeBackShapeIDs[i]=_writeBackBodies[i]->getShapeID();
+}
+
+int CRigidBodyContainerDyn::_getObjectTreeDepth(CDummy3DObject* it,std::vector<int>& objectDepths)
+{ // objectDepths (indexed by object ID) memorizes the depths already known. Objects seen for the first time are added to _writeBackHierarchy
+    int objID=_simGetObjectID(it);
+    bool indexed=( (objID>=0)&&(objID<int(objectDepths.size())) );
+    if ( indexed&&(objectDepths[objID]>=0) )
+        return(objectDepths[objID]);
+    int depth=0;
+    int parentID=-1;
+    CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(it);
+    if (parent!=nullptr)
+    {
+        depth=_getObjectTreeDepth(parent,objectDepths)+1;
+        parentID=_simGetObjectID(parent);
+    }
+    _writeBackHierarchy.push_back(objID);
+    _writeBackHierarchy.push_back(parentID);
+    if (indexed)
+        objectDepths[objID]=depth;
+    return(depth);
+}
+
+void CRigidBodyContainerDyn::reportConstraintConfigurations(int totalPassesCount,bool doNotApplyJointIntrinsicPositions)
+{
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+    {
+        CConstraintDyn* constraint=_allConstraintsList[i];
+
+        CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
+        if (joint!=nullptr)
+        {
             int ldummyA=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
             int ldummyB=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
             if ( (ldummyA==-1)||(ldummyB==-1) ) // bug until 16/10/2011, was ==nullptr before (but didn't cause crashes, or maybe very rarely)
@@ -751,6 +1621,38 @@ void CRigidBodyContainerDyn::reportConstraintConfigurations(int totalPassesCount
     }
 }
 
+void CRigidBodyContainerDyn::reportConstraintForces(int totalPassesCount)
+{ // Same as reportConstraintConfigurations + reportConstraintSecondPartConfigurations, but only for what is accumulated over the passes
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+    {
+        CConstraintDyn* constraint=_allConstraintsList[i];
+
+        CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
+        if (joint!=nullptr)
+        {
+            int ldummyA=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
+            int ldummyB=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
+            if ( (ldummyA==-1)||(ldummyB==-1) )
+                constraint->reportForcesToJoint(joint,nullptr,nullptr,totalPassesCount); // regular case
+            else
+                constraint->reportForcesToJoint(joint,(CDummyDummy*)_simGetObject(ldummyA),(CDummyDummy*)_simGetObject(ldummyB),totalPassesCount); // complex case (looped)
+        }
+
+        CDummyForceSensor* forceSensor=(CDummyForceSensor*)_simGetObject(constraint->getForceSensorID());
+        if (forceSensor!=nullptr)
+        {
+            int ldummyA=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
+            int ldummyB=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
+            if ( (ldummyA==-1)||(ldummyB==-1) )
+                constraint->reportConfigurationAndForcesToForceSensor(forceSensor,nullptr,nullptr,totalPassesCount); // regular case
+            else
+                constraint->reportConfigurationAndForcesToForceSensor(forceSensor,(CDummyDummy*)_simGetObject(ldummyA),(CDummyDummy*)_simGetObject(ldummyB),totalPassesCount); // complex case (looped)
+        }
+
+        constraint->incrementDynPassCounter();
+    }
+}
+
 void CRigidBodyContainerDyn::reportConstraintSecondPartConfigurations()
 { // This is for joints and force sensors only
     for (int i=0;i<int(_allConstraintsList.size());i++)
@@ -770,42 +1672,50 @@ void CRigidBodyContainerDyn::reportConstraintSecondPartConfigurations()
 }
 
 void CRigidBodyContainerDyn::reportShapeConfigurations_forKinematicBodies(float t,float cumulatedTimeStep)
-{
-    for (int i=0;i<int(_allRigidBodiesList.size());i++)
+{ // kinematic bodies that don't move this step have nothing to interpolate
+    for (int i=0;i<int(_movedKinematicBodies.size());i++)
+        _movedKinematicBodies[i]->reportShapeConfigurationToRigidBody_forKinematicBody(_movedKinematicShapes[i],t,cumulatedTimeStep);
+}
+
+void CRigidBodyContainerDyn::_calculateBodyToShapeTransformations_forKinematicBodies(float dt)
+{ // once per step. The simulator doesn't report moved objects, so we check the pose of each kinematic shape here.
+  // The sub-passes then only interpolate the bodies that move
+    if (_kinematicBodiesAreDirty)
+        _rebuildKinematicBodyList();
+    _movedKinematicBodies.clear();
+    _movedKinematicShapes.clear();
+    for (int i=0;i<int(_kinematicBodies.size());i++)
     {
-        CRigidBodyDyn* body=_allRigidBodiesList[i];
-        if (body->isBodyKinematic())
+        CRigidBodyDyn* body=_kinematicBodies[i];
+        CDummyShape* shape=(CDummyShape*)_simGetObject(body->getShapeID());
+        if (shape!=nullptr)
         {
-            CDummyShape* shape=(CDummyShape*)_simGetObject(body->getShapeID());
-            if (shape!=nullptr)
-                body->reportShapeConfigurationToRigidBody_forKinematicBody(shape,t,cumulatedTimeStep);
+            body->calculateBodyToShapeTransformation_forKinematicBody(shape,dt);
+            if (body->isKinematicBodyMoving())
+            {
+                _movedKinematicBodies.push_back(body);
+                _movedKinematicShapes.push_back(shape);
+            }
         }
     }
 }
 
-void CRigidBodyContainerDyn::_calculateBodyToShapeTransformations_forKinematicBodies(float dt)
+void CRigidBodyContainerDyn::_rebuildKinematicBodyList()
 {
+    _kinematicBodiesAreDirty=false;
+    _kinematicBodies.clear();
     for (int i=0;i<int(_allRigidBodiesList.size());i++)
     {
-        CRigidBodyDyn* body=_allRigidBodiesList[i];
-        if (body->isBodyKinematic())
-        {
-            CDummyShape* shape=(CDummyShape*)_simGetObject(body->getShapeID());
-            if (shape!=nullptr)
-                body->calculateBodyToShapeTransformation_forKinematicBody(shape,dt);
-        }
+        if (_allRigidBodiesList[i]->isBodyKinematic())
+            _kinematicBodies.push_back(_allRigidBodiesList[i]);
     }
 }
 
 
 void CRigidBodyContainerDyn::_applyCorrectEndConfig_forKinematicBodies()
 {
-    for (int i=0;i<int(_allRigidBodiesList.size());i++)
-    {
-        CRigidBodyDyn* body=_allRigidBodiesList[i];
-        if (body->isBodyKinematic())
-            body->applyCorrectEndConfig_forKinematicBody();
-    }
+    for (int i=0;i<int(_movedKinematicBodies.size());i++)
+        _movedKinematicBodies[i]->applyCorrectEndConfig_forKinematicBody();
 }
 
 void CRigidBodyContainerDyn::_announceToConstraintsBodyWillBeDestroyed(int rigidBodyID)
@@ -856,12 +1766,18 @@ void CRigidBodyContainerDyn::_removeConstraintFromIndex(int indexPos)
             }
         }
         if (shapeId!=-1)
+        {
             _allConstraintsIndex[shapeId]=nullptr;
+            _visualizationFlagMightChange(shapeId);
+        }
 
         _removeDependenciesBetweenJoints(_allConstraintsList[indexPos]);
 
+        if (_sleepMode==dyn_sleep_on)
+            _allConstraintsList[indexPos]->wakeUpBodies(); // e.g. a removed joint that was holding a sleeping body
         delete _allConstraintsList[indexPos];
         _allConstraintsList.erase(_allConstraintsList.begin()+indexPos);
+        _motorScheduleIsDirty=true;
     }
 }
 
@@ -871,178 +1787,174 @@ void CRigidBodyContainerDyn::_updateConstraintsFromSceneJoints()
     for (int i=0;i<int(_allConstraintsList.size());i++)
     {
         CConstraintDyn* constraint=_allConstraintsList[i];
-        int jointID=constraint->getJointID();
-        if (jointID!=-1) // we could have a dummy-dummy or force sensor constraint!
-        { // not a dummy-dummy constraint, nor a force sensor constraint
-
-            CDummyJoint* joint=(CDummyJoint*)_simGetObject(jointID);
-            if (joint==nullptr)
-            { // we have to remove that constraint, the joint has disappeared!
-                _removeConstraintFromIndex(i);
-                i--; // we have to reprocess that position
-            }
-            else
-            { // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
-                bool remove=true;
-                CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(joint);
-                if (parent!=nullptr)
-                {
-                    int childrenCount;
-                    CDummy3DObject** childrenPointer=(CDummy3DObject**)_simGetObjectChildren(joint,&childrenCount); 
-                    if (childrenCount==1)
-                    {
-                        CDummy3DObject* child=childrenPointer[0];
-                        // Following new since 2010/03/16 (to be compatible with shape-joint-dummy-dummy-shape constraints)
-                        if (_simGetObjectID(parent)==constraint->getParentShapeID())
-                        { // ok, the parent is still there (and has obviously to be a shape, otherwise its unique id wouldn't be the same)
-                            CDummyShape* shapeA=(CDummyShape*)parent;
-                            // Now we have 2 possibilities: child is a shape (regular case), or it is a dummy
-                            int childDummyID=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
-                            if (childDummyID==-1)
-                            { // we have the regular case here: child should be a shape
-                                if (_simGetObjectID(child)==constraint->getChildShapeID())
-                                { // check now if at least one of the attached bodies is dynamic (a joint between two static shapes is NOT legal):
-                                    CDummyShape* shapeB=(CDummyShape*)child; // is obviously a shape (it has the same unique ID)
-                                    if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
-                                        remove=_simGetDynamicsFullRefreshFlag(joint)!=0; // added on 2009/10/16 (was false before)
-                                }
-                            }
-                            else
-                            { // here we have the more complex case: child is a dummy linked to another dummy whose parent is a shape
-                                int childChildListSize;
-                                _simGetObjectChildren(child,&childChildListSize);
-                                if ((_simGetObjectID(child)==childDummyID)&&(childChildListSize==0))
-                                { 
-                                    CDummyDummy* dummyA=(CDummyDummy*)child; // is obviously a dummy (it has the same unique ID)
-                                    int dummyALinkedDummyID;
-                                    int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
-                                    CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
-                                    if (dummyB!=nullptr)
-                                    {
-                                        int dummyBChildListSize;
-                                        _simGetObjectChildren(dummyB,&dummyBChildListSize);
-                                        if ((dummyALinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyBChildListSize==0))
-                                        { // ok, the two dummies are linked correctly. is the second dummy the same?
-                                            int childDummyBID=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
-                                            if (childDummyBID==_simGetObjectID(dummyB))
-                                            { // yes, the second dummy is the same!
-                                                CDummy3DObject* dummyBParent=(CDummy3DObject*)_simGetParentObject(dummyB);
-                                                if (dummyBParent!=nullptr)
-                                                {
-                                                    if (_simGetObjectID(dummyBParent)==constraint->getChildShapeID())
-                                                    { // almost everything looks ok
-                                                        // check now if at least one of the attached bodies is dynamic (a joint between two static shapes is not YET supported):
-                                                        CDummyShape* shapeB=(CDummyShape*)dummyBParent; // is obviously a shape (it has the same unique ID)
-                                                        if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
-                                                            remove=_simGetDynamicsFullRefreshFlag(joint)!=0; // added on 2009/10/16 (was false before)
-                                                    }
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-                if (!remove)
-                { // now make sure the joint is dynamic (or static) and not disabled
-                    if ((_simGetTreeDynamicProperty(joint)&sim_objdynprop_dynamic)==0)
-                        remove=true;
-                }
-                if (remove)
-                { // we have to remove that constraint!
-                    _removeConstraintFromIndex(i);
-                    i--; // we have to reprocess that position
-                }
-            }
+        if ( (constraint->getJointID()!=-1)&&(!_isJointConstraintStillValid(constraint)) ) // we could have a dummy-dummy or force sensor constraint!
+        { // we have to remove that constraint!
+            _removeConstraintFromIndex(i);
+            i--; // we have to reprocess that position
         }
     }
 
     // 2. we have to add new joints
     int jointListSize=_simGetObjectListSize(sim_object_joint_type);
     for (int i=0;i<jointListSize;i++)
-    {
-        CDummyJoint* joint=(CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i);
-        // Make sure the joint is dynamically enabled:
-        if ( ((_simGetJointMode(joint)==sim_jointmode_force)||_simIsJointInHybridOperation(joint))&&(_simGetTreeDynamicProperty(joint)&sim_objdynprop_dynamic) )
-            _addOrUpdateJointConstraint(joint);
-        else
-            _simSetDynamicSimulationIconCode(joint,sim_dynamicsimicon_none);
-        _simSetDynamicsFullRefreshFlag(joint,false);
-    }
+        _updateConstraintFromSceneJoint((CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i));
 }
 
-void CRigidBodyContainerDyn::_updateConstraintsFromSceneDummies()
-{
-    // 1. We have to remove all constraints that have invalid uniqueDummyIDs
-    for (int i=0;i<int(_allConstraintsList.size());i++)
-    {
-        CConstraintDyn* constraint=_allConstraintsList[i];
+bool CRigidBodyContainerDyn::_isJointConstraintStillValid(CConstraintDyn* constraint)
+{ // return value false means the constraint has to be removed
+    CDummyJoint* joint=(CDummyJoint*)_simGetObject(constraint->getJointID());
+    if (joint==nullptr)
+        return(false); // the joint has disappeared!
 
-        int dummyID=constraint->getDummyID();
-        if (dummyID!=-1) // we could have a joint or force sensor constraint!
+    // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
+    bool remove=true;
+    CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(joint);
+    if (parent!=nullptr)
+    {
+        int childrenCount;
+        CDummy3DObject** childrenPointer=(CDummy3DObject**)_simGetObjectChildren(joint,&childrenCount); 
+        if (childrenCount==1)
         {
-            CDummyDummy* dummy=(CDummyDummy*)_simGetObject(dummyID);
-            if (dummy==nullptr)
-            { // we have to remove that constraint!
-                _removeConstraintFromIndex(i);
-                i--; // we have to reprocess that position
-            }
-            else
-            { // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
-                bool remove=true;
-                CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(dummy);
-                int linkedDummyID;
-                int dummyLinkType=_simGetDummyLinkType(dummy,&linkedDummyID);
-                CDummyDummy* linkedDummy=(CDummyDummy*)_simGetObject(linkedDummyID);
-                if ((parent!=nullptr)&&(linkedDummy!=nullptr))
-                {
-                    int dummyChildListSize;
-                    _simGetObjectChildren(dummy,&dummyChildListSize);
-                    int linkedDummyChildListSize;
-                    _simGetObjectChildren(linkedDummy,&linkedDummyChildListSize);
-                    if ((dummyLinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyChildListSize==0)&&(linkedDummyChildListSize==0) ) // added the two ==0 on 2010/03/16
-                    {
-                        CDummy3DObject* child=(CDummy3DObject*)_simGetParentObject(linkedDummy);
-                        if (child!=nullptr)
+            CDummy3DObject* child=childrenPointer[0];
+            // Following new since 2010/03/16 (to be compatible with shape-joint-dummy-dummy-shape constraints)
+            if (_simGetObjectID(parent)==constraint->getParentShapeID())
+            { // ok, the parent is still there (and has obviously to be a shape, otherwise its unique id wouldn't be the same)
+                CDummyShape* shapeA=(CDummyShape*)parent;
+                // Now we have 2 possibilities: child is a shape (regular case), or it is a dummy
+                int childDummyID=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
+                if (childDummyID==-1)
+                { // we have the regular case here: child should be a shape
+                    if (_simGetObjectID(child)==constraint->getChildShapeID())
+                    { // check now if at least one of the attached bodies is dynamic (a joint between two static shapes is NOT legal):
+                        CDummyShape* shapeB=(CDummyShape*)child; // is obviously a shape (it has the same unique ID)
+                        if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
+                            remove=_simGetDynamicsFullRefreshFlag(joint)!=0; // added on 2009/10/16 (was false before)
+                    }
+                }
+                else
+                { // here we have the more complex case: child is a dummy linked to another dummy whose parent is a shape
+                    int childChildListSize;
+                    _simGetObjectChildren(child,&childChildListSize);
+                    if ((_simGetObjectID(child)==childDummyID)&&(childChildListSize==0))
+                    { 
+                        CDummyDummy* dummyA=(CDummyDummy*)child; // is obviously a dummy (it has the same unique ID)
+                        int dummyALinkedDummyID;
+                        int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
+                        CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
+                        if (dummyB!=nullptr)
                         {
-                            if ((_simGetObjectID(parent)==constraint->getParentShapeID())&&(_simGetObjectID(child)==constraint->getChildShapeID()))
-                            { // now make sure that at least one of the parent is dynamic (a rigid joint between two static shapes is not YET supported)
-                                CDummyShape* shapeA=(CDummyShape*)parent;
-                                CDummyShape* shapeB=(CDummyShape*)child;
-                                if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
-                                    remove=_simGetDynamicsFullRefreshFlag(dummy)!=0; // added on 2009/10/16 (was false before)
+                            int dummyBChildListSize;
+                            _simGetObjectChildren(dummyB,&dummyBChildListSize);
+                            if ((dummyALinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyBChildListSize==0))
+                            { // ok, the two dummies are linked correctly. is the second dummy the same?
+                                int childDummyBID=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
+                                if (childDummyBID==_simGetObjectID(dummyB))
+                                { // yes, the second dummy is the same!
+                                    CDummy3DObject* dummyBParent=(CDummy3DObject*)_simGetParentObject(dummyB);
+                                    if (dummyBParent!=nullptr)
+                                    {
+                                        if (_simGetObjectID(dummyBParent)==constraint->getChildShapeID())
+                                        { // almost everything looks ok
+                                            // check now if at least one of the attached bodies is dynamic (a joint between two static shapes is not YET supported):
+                                            CDummyShape* shapeB=(CDummyShape*)dummyBParent; // is obviously a shape (it has the same unique ID)
+                                            if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
+                                                remove=_simGetDynamicsFullRefreshFlag(joint)!=0; // added on 2009/10/16 (was false before)
+                                        }
+                                    }
+                                }
                             }
                         }
                     }
                 }
-                if (!remove)
-                { // now make sure the two dummies are not disabled
-                    if (((_simGetTreeDynamicProperty(dummy)&sim_objdynprop_dynamic)==0)||((_simGetTreeDynamicProperty(linkedDummy)&sim_objdynprop_dynamic)==0) )
-                        remove=true;
-                }
-                if (remove)
-                { // we have to remove that constraint!
-                    _removeConstraintFromIndex(i);
-                    i--; // we have to reprocess that position
-                }
             }
         }
     }
+    if (!remove)
+    { // now make sure the joint is dynamic (or static) and not disabled
+        if ((_simGetTreeDynamicProperty(joint)&sim_objdynprop_dynamic)==0)
+            remove=true;
+    }
+    return(!remove);
+}
+
+void CRigidBodyContainerDyn::_updateConstraintFromSceneJoint(CDummyJoint* joint)
+{
+    // Make sure the joint is dynamically enabled:
+    if ( ((_simGetJointMode(joint)==sim_jointmode_force)||_simIsJointInHybridOperation(joint))&&(_simGetTreeDynamicProperty(joint)&sim_objdynprop_dynamic) )
+        _addOrUpdateJointConstraint(joint);
+    else
+        _simSetDynamicSimulationIconCode(joint,sim_dynamicsimicon_none);
+    _simSetDynamicsFullRefreshFlag(joint,false);
+}
+
+void CRigidBodyContainerDyn::_updateConstraintsFromSceneDummies()
+{
+    // 1. We have to remove all constraints that have invalid uniqueDummyIDs
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+    {
+        CConstraintDyn* constraint=_allConstraintsList[i];
+        if ( (constraint->getDummyID()!=-1)&&(!_isDummyConstraintStillValid(constraint)) ) // we could have a joint or force sensor constraint!
+        { // we have to remove that constraint!
+            _removeConstraintFromIndex(i);
+            i--; // we have to reprocess that position
+        }
+    }
 
     // 2. we have to add new linked dummies
     int dummyListSize=_simGetObjectListSize(sim_object_dummy_type);
     for (int i=0;i<dummyListSize;i++)
+        _updateConstraintFromSceneDummy((CDummyDummy*)_simGetObjectFromIndex(sim_object_dummy_type,i));
+}
+
+bool CRigidBodyContainerDyn::_isDummyConstraintStillValid(CConstraintDyn* constraint)
+{ // return value false means the constraint has to be removed
+    CDummyDummy* dummy=(CDummyDummy*)_simGetObject(constraint->getDummyID());
+    if (dummy==nullptr)
+        return(false); // the dummy has disappeared!
+
+    // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
+    bool remove=true;
+    CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(dummy);
+    int linkedDummyID;
+    int dummyLinkType=_simGetDummyLinkType(dummy,&linkedDummyID);
+    CDummyDummy* linkedDummy=(CDummyDummy*)_simGetObject(linkedDummyID);
+    if ((parent!=nullptr)&&(linkedDummy!=nullptr))
     {
-        CDummyDummy* dummy=(CDummyDummy*)_simGetObjectFromIndex(sim_object_dummy_type,i);
-        // Make sure the dummy is dynamic
-        int linkedDummyID;
-        int linkType=_simGetDummyLinkType(dummy,&linkedDummyID);
-        if ( (linkedDummyID!=-1)&&(linkType==sim_dummy_linktype_dynamics_loop_closure)&&(_simGetTreeDynamicProperty(dummy)&sim_objdynprop_dynamic) )
-            _addOrUpdateDummyConstraint(dummy);
-        _simSetDynamicsFullRefreshFlag(dummy,false);
+        int dummyChildListSize;
+        _simGetObjectChildren(dummy,&dummyChildListSize);
+        int linkedDummyChildListSize;
+        _simGetObjectChildren(linkedDummy,&linkedDummyChildListSize);
+        if ((dummyLinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyChildListSize==0)&&(linkedDummyChildListSize==0) ) // added the two ==0 on 2010/03/16
+        {
+            CDummy3DObject* child=(CDummy3DObject*)_simGetParentObject(linkedDummy);
+            if (child!=nullptr)
+            {
+                if ((_simGetObjectID(parent)==constraint->getParentShapeID())&&(_simGetObjectID(child)==constraint->getChildShapeID()))
+                { // now make sure that at least one of the parent is dynamic (a rigid joint between two static shapes is not YET supported)
+                    CDummyShape* shapeA=(CDummyShape*)parent;
+                    CDummyShape* shapeB=(CDummyShape*)child;
+                    if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
+                        remove=_simGetDynamicsFullRefreshFlag(dummy)!=0; // added on 2009/10/16 (was false before)
+                }
+            }
+        }
+    }
+    if (!remove)
+    { // now make sure the two dummies are not disabled
+        if (((_simGetTreeDynamicProperty(dummy)&sim_objdynprop_dynamic)==0)||((_simGetTreeDynamicProperty(linkedDummy)&sim_objdynprop_dynamic)==0) )
+            remove=true;
     }
+    return(!remove);
+}
+
+void CRigidBodyContainerDyn::_updateConstraintFromSceneDummy(CDummyDummy* dummy)
+{
+    // Make sure the dummy is dynamic
+    int linkedDummyID;
+    int linkType=_simGetDummyLinkType(dummy,&linkedDummyID);
+    if ( (linkedDummyID!=-1)&&(linkType==sim_dummy_linktype_dynamics_loop_closure)&&(_simGetTreeDynamicProperty(dummy)&sim_objdynprop_dynamic) )
+        _addOrUpdateDummyConstraint(dummy);
+    _simSetDynamicsFullRefreshFlag(dummy,false);
 }
 
 void CRigidBodyContainerDyn::_updateConstraintsFromSceneForceSensors()
@@ -1051,99 +1963,98 @@ void CRigidBodyContainerDyn::_updateConstraintsFromSceneForceSensors()
     for (int i=0;i<int(_allConstraintsList.size());i++)
     {
         CConstraintDyn* constraint=_allConstraintsList[i];
-        int forceSensID=constraint->getForceSensorID();
-        if (forceSensID!=-1) // we could have a dummy or joint constraint!
-        {
-            CDummyForceSensor* forceSensor=(CDummyForceSensor*)_simGetObject(forceSensID);
-            if (forceSensor==nullptr)
-            { // we have to remove that constraint, the force sensor has disappeared!
-                _removeConstraintFromIndex(i);
-                i--; // we have to reprocess that position
+        if ( (constraint->getForceSensorID()!=-1)&&(!_isForceSensorConstraintStillValid(constraint)) ) // we could have a dummy or joint constraint!
+        { // we have to remove that constraint!
+            _removeConstraintFromIndex(i);
+            i--; // we have to reprocess that position
+        }
+    }
+
+    // 2. we have to add new force sensors
+    int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
+    for (int i=0;i<forceSensorListSize;i++)
+        _updateConstraintFromSceneForceSensor((CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i));
+}
+
+bool CRigidBodyContainerDyn::_isForceSensorConstraintStillValid(CConstraintDyn* constraint)
+{ // return value false means the constraint has to be removed
+    CDummyForceSensor* forceSensor=(CDummyForceSensor*)_simGetObject(constraint->getForceSensorID());
+    if (forceSensor==nullptr)
+        return(false); // the force sensor has disappeared!
+
+    // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
+    bool remove=true;
+    CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(forceSensor);
+    int forceSensorChildrenCount;
+    CDummy3DObject** forceSensorChildrenPointer=(CDummy3DObject**)_simGetObjectChildren(forceSensor,&forceSensorChildrenCount);
+    if ( (parent!=nullptr)&&(forceSensorChildrenCount==1) )
+    {
+        CDummy3DObject* child=forceSensorChildrenPointer[0];
+        // Following new since 2010-03-16 (to be compatible with shape-sensor-dummy-dummy-shape constraints)
+        if (_simGetObjectID(parent)==constraint->getParentShapeID())
+        { // ok, the parent is still there (and has obviously to be a shape, otherwise its unique id wouldn't be the same)
+            CDummyShape* shapeA=(CDummyShape*)parent;
+            // Now we have 2 possibilities: child is a shape (regular case), or it is a dummy
+            int childDummyID=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
+            if (childDummyID==-1)
+            { // we have the regular case here: child should be a shape
+                if (_simGetObjectID(child)==constraint->getChildShapeID())
+                { // check now if at least one of the attached bodies is dynamic (a dynamic joint between two static shapes is NOT LEGAL):
+                    CDummyShape* shapeB=(CDummyShape*)child; // is obviously a shape (it has the same unique ID)
+                    if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
+                        remove=_simGetDynamicsFullRefreshFlag(forceSensor)!=0; // added on 2009/10/16 (was false before)
+                }
             }
             else
-            { // We have to make sure the bodies are still there! (also with the same hierarchy relationship!)
-                bool remove=true;
-                CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(forceSensor);
-                int forceSensorChildrenCount;
-                CDummy3DObject** forceSensorChildrenPointer=(CDummy3DObject**)_simGetObjectChildren(forceSensor,&forceSensorChildrenCount);
-                if ( (parent!=nullptr)&&(forceSensorChildrenCount==1) )
-                {
-                    CDummy3DObject* child=forceSensorChildrenPointer[0];
-                    // Following new since 2010-03-16 (to be compatible with shape-sensor-dummy-dummy-shape constraints)
-                    if (_simGetObjectID(parent)==constraint->getParentShapeID())
-                    { // ok, the parent is still there (and has obviously to be a shape, otherwise its unique id wouldn't be the same)
-                        CDummyShape* shapeA=(CDummyShape*)parent;
-                        // Now we have 2 possibilities: child is a shape (regular case), or it is a dummy
-                        int childDummyID=constraint->getJointOrForceSensorLoopClosureLinkedDummyAChildID();
-                        if (childDummyID==-1)
-                        { // we have the regular case here: child should be a shape
-                            if (_simGetObjectID(child)==constraint->getChildShapeID())
-                            { // check now if at least one of the attached bodies is dynamic (a dynamic joint between two static shapes is NOT LEGAL):
-                                CDummyShape* shapeB=(CDummyShape*)child; // is obviously a shape (it has the same unique ID)
-                                if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
-                                    remove=_simGetDynamicsFullRefreshFlag(forceSensor)!=0; // added on 2009/10/16 (was false before)
-                            }
-                        }
-                        else
-                        { // here we have the more complex case: child is a dummy linked to another dummy whose parent is a shape
-                            int childChrildrenListSize;
-                            _simGetObjectChildren(child,&childChrildrenListSize);
-                            if ((_simGetObjectID(child)==childDummyID)&&(childChrildrenListSize==0))
-                            { 
-                                CDummyDummy* dummyA=(CDummyDummy*)child; // is obviously a dummy (it has the same unique ID)
-                                int dummyALinkedDummyID;
-                                int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
-                                CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
-                                if (dummyB!=nullptr)
-                                {
-                                    int dummyBChrildrenListSize;
-                                    _simGetObjectChildren(dummyB,&dummyBChrildrenListSize);
-                                    if ((dummyALinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyBChrildrenListSize==0))
-                                    { // ok, the two dummies are linked correctly. is the second dummy the same?
-                                        int childDummyBID=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
-                                        if (childDummyBID==_simGetObjectID(dummyB))
-                                        { // yes, the second dummy is the same!
-                                            CDummy3DObject* dummyBParent=(CDummy3DObject*)_simGetParentObject(dummyB);
-                                            if ((dummyBParent!=nullptr)&&(_simGetObjectID(dummyBParent)==constraint->getChildShapeID()))
-                                            { // almost everything looks ok
-                                                // check now if at least one of the attached bodies is dynamic (a force sensor between two static shapes is not YET supported):
-                                                CDummyShape* shapeB=(CDummyShape*)dummyBParent; // is obviously a shape (it has the same unique ID)
-                                                if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
-                                                    remove=_simGetDynamicsFullRefreshFlag(forceSensor)!=0; // added on 2009/10/16 (was false before)
-                                            }
-                                        }
-                                    }
+            { // here we have the more complex case: child is a dummy linked to another dummy whose parent is a shape
+                int childChrildrenListSize;
+                _simGetObjectChildren(child,&childChrildrenListSize);
+                if ((_simGetObjectID(child)==childDummyID)&&(childChrildrenListSize==0))
+                { 
+                    CDummyDummy* dummyA=(CDummyDummy*)child; // is obviously a dummy (it has the same unique ID)
+                    int dummyALinkedDummyID;
+                    int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
+                    CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
+                    if (dummyB!=nullptr)
+                    {
+                        int dummyBChrildrenListSize;
+                        _simGetObjectChildren(dummyB,&dummyBChrildrenListSize);
+                        if ((dummyALinkType==sim_dummy_linktype_dynamics_loop_closure)&&(dummyBChrildrenListSize==0))
+                        { // ok, the two dummies are linked correctly. is the second dummy the same?
+                            int childDummyBID=constraint->getJointOrForceSensorLoopClosureLinkedDummyBChildID();
+                            if (childDummyBID==_simGetObjectID(dummyB))
+                            { // yes, the second dummy is the same!
+                                CDummy3DObject* dummyBParent=(CDummy3DObject*)_simGetParentObject(dummyB);
+                                if ((dummyBParent!=nullptr)&&(_simGetObjectID(dummyBParent)==constraint->getChildShapeID()))
+                                { // almost everything looks ok
+                                    // check now if at least one of the attached bodies is dynamic (a force sensor between two static shapes is not YET supported):
+                                    CDummyShape* shapeB=(CDummyShape*)dummyBParent; // is obviously a shape (it has the same unique ID)
+                                    if ( (_simIsShapeDynamicallyStatic(shapeA)==0)||(_simIsShapeDynamicallyStatic(shapeB)==0) )
+                                        remove=_simGetDynamicsFullRefreshFlag(forceSensor)!=0; // added on 2009/10/16 (was false before)
                                 }
                             }
                         }
                     }
                 }
-                if (!remove)
-                { // now make sure the force sensor is dynamic (or static) and not disabled
-                    if ((_simGetTreeDynamicProperty(forceSensor)&sim_objdynprop_dynamic)==0)
-                        remove=true;
-                }
-                if (remove)
-                { // we have to remove that constraint!
-                    _removeConstraintFromIndex(i);
-                    i--; // we have to reprocess that position
-                }
             }
         }
     }
-
-    // 2. we have to add new force sensors
-    int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
-    for (int i=0;i<forceSensorListSize;i++)
-    {
-        CDummyForceSensor* forceSensor=(CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i);
-        // Make sure the forceSensor is dynamically enabled:
-        if ( _simGetTreeDynamicProperty(forceSensor)&sim_objdynprop_dynamic )
-            _addOrUpdateForceSensorConstraint(forceSensor);
-        else
-            _simSetDynamicSimulationIconCode(forceSensor,sim_dynamicsimicon_none);
-        _simSetDynamicsFullRefreshFlag(forceSensor,false);
+    if (!remove)
+    { // now make sure the force sensor is dynamic (or static) and not disabled
+        if ((_simGetTreeDynamicProperty(forceSensor)&sim_objdynprop_dynamic)==0)
+            remove=true;
     }
+    return(!remove);
+}
+
+void CRigidBodyContainerDyn::_updateConstraintFromSceneForceSensor(CDummyForceSensor* forceSensor)
+{
+    // Make sure the forceSensor is dynamically enabled:
+    if ( _simGetTreeDynamicProperty(forceSensor)&sim_objdynprop_dynamic )
+        _addOrUpdateForceSensorConstraint(forceSensor);
+    else
+        _simSetDynamicSimulationIconCode(forceSensor,sim_dynamicsimicon_none);
+    _simSetDynamicsFullRefreshFlag(forceSensor,false);
 }
 
 void CRigidBodyContainerDyn::_addOrUpdateJointConstraint(CDummyJoint* joint)
@@ -1189,7 +2100,9 @@ void CRigidBodyContainerDyn::_addOrUpdateJointConstraint(CDummyJoint* joint)
 #endif // INCLUDE_VORTEX_CODE
 
                         _allConstraintsList.push_back(constraint);
+                        _motorScheduleIsDirty=true;
                         _allConstraintsIndex[_simGetObjectID(joint)]=constraint;
+                        _visualizationFlagMightChange(_simGetObjectID(joint));
                         successful=true;
                     }
 
@@ -1242,7 +2155,9 @@ void CRigidBodyContainerDyn::_addOrUpdateJointConstraint(CDummyJoint* joint)
 #endif // INCLUDE_VORTEX_CODE
 
                                         _allConstraintsList.push_back(constraint);
+                                        _motorScheduleIsDirty=true;
                                         _allConstraintsIndex[_simGetObjectID(joint)]=constraint;
+                                        _visualizationFlagMightChange(_simGetObjectID(joint));
                                         successful=true;
                                     }
                                 }
@@ -1308,7 +2223,9 @@ void CRigidBodyContainerDyn::_addOrUpdateDummyConstraint(CDummyDummy* dummy)
 #endif // INCLUDE_VORTEX_CODE
 
                                 _allConstraintsList.push_back(constraint);
+                                _motorScheduleIsDirty=true;
                                 _allConstraintsIndex[_simGetObjectID(dummy)]=constraint;
+                                _visualizationFlagMightChange(_simGetObjectID(dummy));
                             }
                         }
                     }
@@ -1361,7 +2278,9 @@ void CRigidBodyContainerDyn::_addOrUpdateForceSensorConstraint(CDummyForceSensor
 #endif // INCLUDE_VORTEX_CODE
 
                         _allConstraintsList.push_back(constraint);
+                        _motorScheduleIsDirty=true;
                         _allConstraintsIndex[_simGetObjectID(forceSensor)]=constraint;
+                        _visualizationFlagMightChange(_simGetObjectID(forceSensor));
                         successful=true;
                     }
                 }
@@ -1412,7 +2331,9 @@ void CRigidBodyContainerDyn::_addOrUpdateForceSensorConstraint(CDummyForceSensor
 #endif // INCLUDE_VORTEX_CODE
 
                                         _allConstraintsList.push_back(constraint);
+                                        _motorScheduleIsDirty=true;
                                         _allConstraintsIndex[_simGetObjectID(forceSensor)]=constraint;
+                                        _visualizationFlagMightChange(_simGetObjectID(forceSensor));
                                         successful=true;
                                     }
                                 }
@@ -1433,11 +2354,21 @@ bool CRigidBodyContainerDyn::_updateDynamicWorld()
 { // return value indicates whether particles are present and need to be simulated
     bool particlesPresent=false;
     _temporarilyDisableShapesOutOfDynamicActivityRange(); // e.g. when shapes are falling too deep or flying too high, they are disabled
-    _tagStaticAndNotCollidableButDynamicShapes(); // special: when a dynamic joint (or sensor!) connects a static non-collidable shape and a dynamic shape
-    _updateRigidBodiesFromSceneShapes();
-    _updateConstraintsFromSceneJoints();
-    _updateConstraintsFromSceneDummies();
-    _updateConstraintsFromSceneForceSensors();
+    if ( (_worldSyncMode==dyn_worldsync_fullrescan)||(!_updateDynamicWorldIncrementally()) )
+    { // we rescan the whole scene:
+        _tagStaticAndNotCollidableButDynamicShapes(); // special: when a dynamic joint (or sensor!) connects a static non-collidable shape and a dynamic shape
+        _updateRigidBodiesFromSceneShapes();
+        _updateConstraintsFromSceneJoints();
+        _updateConstraintsFromSceneDummies();
+        _updateConstraintsFromSceneForceSensors();
+        if (_worldSyncMode!=dyn_worldsync_fullrescan)
+            _resetObjectSyncStates();
+    }
+    else
+    {
+        if (_worldSyncMode==dyn_worldsync_incremental_crosscheck)
+            _crossCheckIncrementalWorldUpdate();
+    }
     _updateHybridJointTargetPositions();
 
     particlesPresent|=particleCont.addParticlesIfNeeded();
@@ -1451,18 +2382,365 @@ bool CRigidBodyContainerDyn::_updateDynamicWorld()
     return(particlesPresent);
 }
 
+bool CRigidBodyContainerDyn::_updateDynamicWorldIncrementally()
+{ // return value false means that the scene structure changed (objects added, removed or reordered) and that a full rescan is needed
+    if ( (_objectSyncStates.size()==0)||_dynamicTreeDisabled )
+        return(false); // not yet synchronized, or a whole tree was disabled (rare)
+    _syncGeneration++;
+
+    // 1. The object lists must be the same as last time. Objects are appended to them, and object IDs are not reused, so the size and the last ID tell:
+    int objectCnt=0;
+    for (int t=0;t<4;t++)
+    {
+        int objType=_syncedObjectTypes[t];
+        int listSize=_simGetObjectListSize(objType);
+        if (listSize!=int(_syncedObjects[t].size()))
+            return(false);
+        if ( (listSize>0)&&(_simGetObjectID(_simGetObjectFromIndex(objType,listSize-1))!=_syncedObjectIDs[t][listSize-1]) )
+            return(false);
+        objectCnt+=listSize;
+    }
+
+    // 2. We collect the objects that changed since last time (the dirty set). The simulator flags the objects that need a refresh, only those are probed further.
+    // A few objects are fully compared in each step, in turn, for the changes that the simulator does not flag:
+    std::vector<CDummy3DObject*> syncSet;
+    if (_syncAuditPosition>=objectCnt)
+        _syncAuditPosition=0;
+    int auditEnd=_syncAuditPosition+_syncAuditObjectsPerStep; // can wrap around
+    int index=0;
+    for (int t=0;t<4;t++)
+    {
+        int objType=_syncedObjectTypes[t];
+        for (int i=0;i<int(_syncedObjects[t].size());i++)
+        {
+            CDummy3DObject* it=(CDummy3DObject*)_syncedObjects[t][i];
+            bool audited=( (index>=_syncAuditPosition)&&(index<auditEnd) )||(index<auditEnd-objectCnt);
+            if ( (audited||_isObjectFlaggedForRefresh(it,_syncedObjectIDs[t][i],objType))&&_refreshObjectSyncState(it,objType) )
+                _addToSyncSet(it,syncSet);
+            index++;
+        }
+    }
+    _syncAuditPosition=auditEnd;
+    if (_syncAuditPosition>=objectCnt)
+        _syncAuditPosition-=objectCnt;
+    if (syncSet.size()==0)
+        return(true); // nothing changed
+
+    // 3. Objects connected to a changed object (through a parent/child relationship or a dummy link) need to be revalidated too:
+    int changedCnt=int(syncSet.size());
+    for (int i=0;i<changedCnt;i++)
+        _addConnectedObjectsToSyncSet(syncSet[i],syncSet);
+
+    // 4. The static-non-respondable-but-dynamic tags contributed by joints, force sensors and dummies (shapes whose tag changes are added to the set):
+    for (int i=0;i<int(syncSet.size());i++)
+    {
+        int objType=_simGetObjectType(syncSet[i]);
+        if (objType!=sim_object_shape_type)
+            _updateShapeTagsFromObject(syncSet[i],objType,&syncSet);
+    }
+
+    // 5. We remove the rigid bodies that became invalid, then add new ones:
+    for (int i=0;i<int(syncSet.size());i++)
+    {
+        if (_simGetObjectType(syncSet[i])==sim_object_shape_type)
+        {
+            CRigidBodyDyn* body=_allRigidBodiesIndex[_simGetObjectID(syncSet[i])];
+            if ( (body!=nullptr)&&(!_isRigidBodyStillValid(body)) )
+            {
+                _removeRigidBody(body->getRigidBodyID());
+                _addConnectedObjectsToSyncSet(syncSet[i],syncSet); // constraints attached to that body were removed too
+            }
+        }
+    }
+    for (int i=0;i<int(syncSet.size());i++)
+    {
+        if (_simGetObjectType(syncSet[i])==sim_object_shape_type)
+            _updateRigidBodyFromSceneShape((CDummyShape*)syncSet[i]);
+    }
+
+    // 6. We remove the constraints that became invalid, then add new ones:
+    for (int i=0;i<int(syncSet.size());i++)
+    {
+        int objType=_simGetObjectType(syncSet[i]);
+        int objID=_simGetObjectID(syncSet[i]);
+        CConstraintDyn* constraint=_allConstraintsIndex[objID];
+        if (constraint!=nullptr)
+        {
+            bool valid=true;
+            if ( (objType==sim_object_joint_type)&&(constraint->getJointID()==objID) )
+                valid=_isJointConstraintStillValid(constraint);
+            if ( (objType==sim_object_dummy_type)&&(constraint->getDummyID()==objID) )
+                valid=_isDummyConstraintStillValid(constraint);
+            if ( (objType==sim_object_forcesensor_type)&&(constraint->getForceSensorID()==objID) )
+                valid=_isForceSensorConstraintStillValid(constraint);
+            if (!valid)
+                _removeConstraint(constraint);
+        }
+    }
+    for (int i=0;i<int(syncSet.size());i++)
+    {
+        int objType=_simGetObjectType(syncSet[i]);
+        if (objType==sim_object_joint_type)
+            _updateConstraintFromSceneJoint((CDummyJoint*)syncSet[i]);
+        if (objType==sim_object_dummy_type)
+            _updateConstraintFromSceneDummy((CDummyDummy*)syncSet[i]);
+        if (objType==sim_object_forcesensor_type)
+            _updateConstraintFromSceneForceSensor((CDummyForceSensor*)syncSet[i]);
+    }
+    return(true);
+}
+
+void CRigidBodyContainerDyn::_crossCheckIncrementalWorldUpdate()
+{ // A full rescan right after an incremental update should not find anything left to do. We compare object by object
+    int listDifferenceCnt=0; // the incremental update only compares the size and last object of each object list
+    for (int t=0;t<4;t++)
+    {
+        int objType=_syncedObjectTypes[t];
+        for (int i=0;i<int(_syncedObjects[t].size());i++)
+        {
+            if (_simGetObjectFromIndex(objType,i)!=_syncedObjects[t][i])
+                listDifferenceCnt++;
+        }
+    }
+    if (listDifferenceCnt>0)
+    {
+        std::string tmp("incremental world synchronization missed a change of the object lists, at ");
+        tmp+=std::to_string(listDifferenceCnt);
+        tmp+=" position(s)";
+        simAddLog(LIBRARY_NAME,sim_verbosity_warnings,tmp.c_str());
+    }
+    std::vector<CRigidBodyDyn*> bodies(_allRigidBodiesIndex);
+    std::vector<int> bodyIDs(bodies.size(),-1); // rigid body IDs are never reused, pointers can be
+    for (int i=0;i<int(bodies.size());i++)
+    {
+        if (bodies[i]!=nullptr)
+            bodyIDs[i]=bodies[i]->getRigidBodyID();
+    }
+    std::vector<CConstraintDyn*> constraints(_allConstraintsIndex);
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+        _allConstraintsList[i]->setConstraintID(i); // constraints created by the rescan keep -1
+    std::vector<int> shapeTagCounts(_shapeTagCounts);
+    _tagStaticAndNotCollidableButDynamicShapes();
+    _updateRigidBodiesFromSceneShapes();
+    _updateConstraintsFromSceneJoints();
+    _updateConstraintsFromSceneDummies();
+    _updateConstraintsFromSceneForceSensors();
+    int differenceCnt=0;
+    int firstDifferenceID=-1;
+    for (int i=0;i<int(bodies.size());i++)
+    {
+        CRigidBodyDyn* body=_allRigidBodiesIndex[i];
+        CConstraintDyn* constraint=_allConstraintsIndex[i];
+        bool same=(body==bodies[i])&&( (body==nullptr)||(body->getRigidBodyID()==bodyIDs[i]) );
+        same=same&&(constraint==constraints[i])&&( (constraint==nullptr)||(constraint->getConstraintID()!=-1) );
+        if ( (i<int(shapeTagCounts.size()))&&(i<int(_shapeTagCounts.size())) )
+            same=same&&( (shapeTagCounts[i]>0)==(_shapeTagCounts[i]>0) );
+        if (!same)
+        {
+            if (differenceCnt==0)
+                firstDifferenceID=i;
+            differenceCnt++;
+        }
+    }
+    if (differenceCnt>0)
+    {
+        std::string tmp("incremental world synchronization differs from a full scene rescan for ");
+        tmp+=std::to_string(differenceCnt);
+        tmp+=" object(s), first object ID: ";
+        tmp+=std::to_string(firstDifferenceID);
+        simAddLog(LIBRARY_NAME,sim_verbosity_warnings,tmp.c_str());
+    }
+    _crossCheckCollisionShapes(); // the rescan above removed and re-added bodies
+    _resetObjectSyncStates();
+}
+
+void CRigidBodyContainerDyn::_crossCheckCollisionShapes()
+{ // collision shapes are swap-removed (see removeRigidBodyFromCollisionShapeDependency): each one must know its current list index,
+  // be found again through its geom proxy, and count exactly the rigid bodies that use it
+    int differenceCnt=0;
+    std::vector<int> dependencyCounts(_allCollisionShapes.size(),0);
+    for (int i=0;i<int(_allRigidBodiesList.size());i++)
+    {
+        CCollShapeDyn* collShape=_allRigidBodiesList[i]->getCollisionShapeDyn();
+        if (collShape==nullptr)
+            continue;
+        int index=collShape->getCollisionShapeListIndex();
+        if ( (index>=0)&&(index<int(_allCollisionShapes.size()))&&(_allCollisionShapes[index]==collShape) )
+            dependencyCounts[index]++;
+        else
+            differenceCnt++; // the body's collision shape is not at its stored list index
+    }
+    for (int i=0;i<int(_allCollisionShapes.size());i++)
+    {
+        CCollShapeDyn* collShape=_allCollisionShapes[i];
+        bool same=(collShape->getCollisionShapeListIndex()==i)&&(collShape->getRigidBodyDependencyCount()==dependencyCounts[i]);
+        CDummyGeomProxy* geom=collShape->getGeomData_nullForNonRespondable();
+        if (geom!=nullptr)
+            same=same&&(getCollisionShapeFromGeomObject(geom)==collShape);
+        if (!same)
+            differenceCnt++;
+    }
+    if (differenceCnt>0)
+    {
+        std::string tmp("collision shape list is inconsistent (list index, geom proxy index or rigid body dependency count), for ");
+        tmp+=std::to_string(differenceCnt);
+        tmp+=" entry(ies)";
+        simAddLog(LIBRARY_NAME,sim_verbosity_warnings,tmp.c_str());
+    }
+}
+
+void CRigidBodyContainerDyn::_resetObjectSyncStates()
+{ // Called after a full rescan: we remember the scene as it is now
+    _objectSyncStates.resize(_allRigidBodiesIndex.size());
+    for (int t=0;t<4;t++)
+    {
+        int objType=_syncedObjectTypes[t];
+        int listSize=_simGetObjectListSize(objType);
+        _syncedObjects[t].resize(listSize);
+        _syncedObjectIDs[t].resize(listSize);
+        for (int i=0;i<listSize;i++)
+        {
+            CDummy3DObject* it=(CDummy3DObject*)_simGetObjectFromIndex(objType,i);
+            _syncedObjects[t][i]=it;
+            _syncedObjectIDs[t][i]=_simGetObjectID(it);
+            _refreshObjectSyncState(it,objType);
+        }
+    }
+}
+
+bool CRigidBodyContainerDyn::_refreshObjectSyncState(CDummy3DObject* it,int objectType)
+{ // return value true means that the object changed since the last synchronization
+    int objID=_simGetObjectID(it);
+    SObjectSyncState& state=_objectSyncStates[objID];
+    bool changed=(_simGetDynamicsFullRefreshFlag(it)!=0);
+    void* parent=(void*)_simGetParentObject(it);
+    int treeDynProp=_simGetTreeDynamicProperty(it);
+    void* geomProxy=nullptr;
+    int auxState[2]={0,0};
+    if (objectType==sim_object_shape_type)
+    {
+        geomProxy=(void*)_simGetGeomProxyFromShape(it);
+        if (_allRigidBodiesIndex[objID]!=nullptr) // the geom refresh flag is only cleared when a collision shape is built
+            changed=changed||(_simGetGeomProxyDynamicsFullRefreshFlag(geomProxy)!=0);
+        auxState[0]=int(_simIsShapeDynamicallyStatic(it)!=0);
+        auxState[1]=int(_simIsShapeDynamicallyRespondable(it)!=0);
+    }
+    if (objectType==sim_object_joint_type)
+    {
+        auxState[0]=_simGetJointMode(it);
+        auxState[1]=int(_simIsJointInHybridOperation(it)!=0);
+    }
+    if (objectType==sim_object_dummy_type)
+        auxState[0]=_simGetDummyLinkType(it,auxState+1);
+    changed=changed||(parent!=state.parent)||(geomProxy!=state.geomProxy)||(treeDynProp!=state.treeDynamicProperty)||(auxState[0]!=state.auxState[0])||(auxState[1]!=state.auxState[1]);
+    if (changed)
+    {
+        state.parent=parent;
+        state.geomProxy=geomProxy;
+        state.treeDynamicProperty=treeDynProp;
+        state.auxState[0]=auxState[0];
+        state.auxState[1]=auxState[1];
+    }
+    return(changed);
+}
+
+bool CRigidBodyContainerDyn::_isObjectFlaggedForRefresh(CDummy3DObject* it,int objectID,int objectType)
+{ // the simulator's own change notification. Cheaper than _refreshObjectSyncState
+    if (_simGetDynamicsFullRefreshFlag(it)!=0)
+        return(true);
+    if ( (objectType==sim_object_shape_type)&&(_allRigidBodiesIndex[objectID]!=nullptr) ) // the geom refresh flag is only cleared when a collision shape is built
+        return(_simGetGeomProxyDynamicsFullRefreshFlag(_objectSyncStates[objectID].geomProxy)!=0);
+    return(false);
+}
+
+void CRigidBodyContainerDyn::_addToSyncSet(CDummy3DObject* it,std::vector<CDummy3DObject*>& syncSet)
+{
+    if (it==nullptr)
+        return;
+    int objType=_simGetObjectType(it);
+    if ( (objType!=sim_object_shape_type)&&(objType!=sim_object_joint_type)&&(objType!=sim_object_dummy_type)&&(objType!=sim_object_forcesensor_type) )
+        return;
+    SObjectSyncState& state=_objectSyncStates[_simGetObjectID(it)];
+    if (state.visitGeneration!=_syncGeneration)
+    { // not yet in the set
+        state.visitGeneration=_syncGeneration;
+        syncSet.push_back(it);
+    }
+}
+
+void CRigidBodyContainerDyn::_addConnectedObjectsToSyncSet(CDummy3DObject* it,std::vector<CDummy3DObject*>& syncSet)
+{ // bodies and constraints are made of shape-joint-shape, shape-sensor-shape, shape-dummy-dummy-shape and shape-joint/sensor-dummy-dummy-shape chains
+    _addToSyncSet((CDummy3DObject*)_simGetParentObject(it),syncSet);
+    int childrenCount;
+    CDummy3DObject** childrenPointer=(CDummy3DObject**)_simGetObjectChildren(it,&childrenCount);
+    for (int i=0;i<childrenCount;i++)
+    {
+        _addToSyncSet(childrenPointer[i],syncSet);
+        if (_simGetObjectType(childrenPointer[i])==sim_object_dummy_type)
+            _addLinkedDummyToSyncSet((CDummyDummy*)childrenPointer[i],syncSet);
+    }
+    if (_simGetObjectType(it)==sim_object_dummy_type)
+        _addLinkedDummyToSyncSet((CDummyDummy*)it,syncSet);
+}
+
+void CRigidBodyContainerDyn::_addLinkedDummyToSyncSet(CDummyDummy* dummy,std::vector<CDummy3DObject*>& syncSet)
+{
+    int linkedDummyID;
+    _simGetDummyLinkType(dummy,&linkedDummyID);
+    CDummy3DObject* linkedDummy=(CDummy3DObject*)_simGetObject(linkedDummyID);
+    if (linkedDummy!=nullptr)
+    {
+        _addToSyncSet(linkedDummy,syncSet);
+        _addToSyncSet((CDummy3DObject*)_simGetParentObject(linkedDummy),syncSet);
+    }
+}
+
+void CRigidBodyContainerDyn::_removeConstraint(CConstraintDyn* constraint)
+{
+    for (int i=0;i<int(_allConstraintsList.size());i++)
+    {
+        if (_allConstraintsList[i]==constraint)
+        {
+            _removeConstraintFromIndex(i);
+            return;
+        }
+    }
+}
+
 void CRigidBodyContainerDyn::_temporarilyDisableShapesOutOfDynamicActivityRange()
 { // So that falling objects stop falling eventually! On 04/02/2011 extended the functionality to all dimensions and directions!
-    int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
-    for (int i=0;i<shapeListSize;i++)
+  // With incremental world synchronization, only the shapes of rigid bodies are checked: the other shapes are not moved by the engine
+    _dynamicTreeDisabled=false;
+    if (_worldSyncMode==dyn_worldsync_fullrescan)
     {
-        CDummy3DObject* it=(CDummy3DObject*)_simGetObjectFromIndex(sim_object_shape_type,i);
-        if (_simGetParentObject(it)==nullptr) // condition since the end of the world: 21/12/2012
+        int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
+        for (int i=0;i<shapeListSize;i++)
         {
-            C7Vector tr;
-            _simGetObjectCumulativeTransformation(it,tr.X.data,tr.Q.data,true);
-            if (tr.X.getLength()>getDynamicActivityRange())
-                _simDisableDynamicTreeForManipulation(it,true);
+            CDummy3DObject* it=(CDummy3DObject*)_simGetObjectFromIndex(sim_object_shape_type,i);
+            if (_simGetParentObject(it)==nullptr) // condition since the end of the world: 21/12/2012
+            {
+                C7Vector tr;
+                _simGetObjectCumulativeTransformation(it,tr.X.data,tr.Q.data,true);
+                if (tr.X.getLength()>getDynamicActivityRange())
+                    _simDisableDynamicTreeForManipulation(it,true);
+            }
+        }
+    }
+    else
+    {
+        for (int i=0;i<int(_allRigidBodiesList.size());i++)
+        {
+            CDummy3DObject* it=(CDummy3DObject*)_simGetObject(_allRigidBodiesList[i]->getShapeID()); // the shape might have been removed since the last step
+            if ( (it!=nullptr)&&(_simGetParentObject(it)==nullptr) )
+            {
+                C7Vector tr;
+                _simGetObjectCumulativeTransformation(it,tr.X.data,tr.Q.data,true);
+                if (tr.X.getLength()>getDynamicActivityRange())
+                {
+                    _simDisableDynamicTreeForManipulation(it,true);
+                    _dynamicTreeDisabled=true; // the next synchronization will be a full rescan
+                }
+            }
         }
     }
 }
@@ -1473,126 +2751,57 @@ void CRigidBodyContainerDyn::_tagStaticAndNotCollidableButDynamicShapes()
     int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
     for (int i=0;i<shapeListSize;i++)
         _simSetShapeIsStaticAndNotRespondableButDynamicTag((CDummyShape*)_simGetObjectFromIndex(sim_object_shape_type,i),false);
-    // 2. We check all dynamic joints and look if they connect a static non-collidable shape (parent) and a dynamic shape (child) (or the looped variant):
+    _shapeTagCounts.assign(_allRigidBodiesIndex.size(),0);
+    _shapesTaggedByObject.resize(_allRigidBodiesIndex.size());
+    for (int i=0;i<int(_shapesTaggedByObject.size());i++)
+        _shapesTaggedByObject[i].clear();
+    // 2. We check all dynamic joints, force sensors and linked dummies and look if they connect a static non-collidable shape and a dynamic shape:
     int jointListSize=_simGetObjectListSize(sim_object_joint_type);
     for (int i=0;i<jointListSize;i++)
-    {
-        CDummyJoint* it=(CDummyJoint*)_simGetObjectFromIndex(sim_object_joint_type,i);
-        if ((_simGetJointMode(it)==sim_jointmode_force)||_simIsJointInHybridOperation(it))
-        { // we have a dynamic joint here.
-            int itChildListSize;
-            CDummy3DObject** itChildrenPointer=(CDummy3DObject**)_simGetObjectChildren(it,&itChildListSize);
-            if (itChildListSize==1)
-            {
-                CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(it);
-                if ( (parent!=nullptr)&&(_simGetObjectType(parent)==sim_object_shape_type) )
-                {
-                    CDummyShape* parentShape=(CDummyShape*)parent;
-                    if (_simGetObjectType(itChildrenPointer[0])==sim_object_shape_type)
-                    { // we might have a regular case (non-looped)
-                        CDummyShape* childShape=(CDummyShape*)itChildrenPointer[0];
-                        if (_simIsShapeDynamicallyStatic(childShape)==0)
-                        {
-                            if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
-                                _simSetShapeIsStaticAndNotRespondableButDynamicTag(parentShape,true);
-                        }
-                    }
-                    else
-                    { 
-                        if (_simGetObjectType(itChildrenPointer[0])==sim_object_dummy_type)
-                        { // we might have a complex case (looped)
-                            CDummyDummy* dummyA=(CDummyDummy*)itChildrenPointer[0];
-                            int dummyALinkedDummyID;
-                            int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
-                            CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
-                            if ((dummyB!=nullptr)&&(dummyALinkType==sim_dummy_linktype_dynamics_loop_closure))
-                            {
-                                int dummyAChildListSize,dummyBChildListSize;
-                                _simGetObjectChildren(dummyA,&dummyAChildListSize);
-                                _simGetObjectChildren(dummyB,&dummyBChildListSize);
-                                if ((dummyAChildListSize==0)&&(dummyBChildListSize==0))
-                                {
-                                    CDummy3DObject* par=(CDummy3DObject*)_simGetParentObject(dummyB);
-                                    if ((par!=nullptr)&&(_simGetObjectType(par)==sim_object_shape_type))
-                                    {
-                                        CDummyShape* childShape=(CDummyShape*)par;
-                                        if ((_simIsShapeDynamicallyStatic(childShape)==0)||(_simIsShapeDynamicallyStatic(parentShape)==0))
-                                        {
-                                            if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
-                                                _simSetShapeIsStaticAndNotRespondableButDynamicTag(parentShape,true);
-                                            if ( _simIsShapeDynamicallyStatic(childShape)&&(_simIsShapeDynamicallyRespondable(childShape)==0) )
-                                                _simSetShapeIsStaticAndNotRespondableButDynamicTag(childShape,true);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    // 2. We check all force sensors and look if they connect a static non-collidable shape (parent) and a dynamic shape (child) (or the looped variant):
+        _updateShapeTagsFromObject((CDummy3DObject*)_simGetObjectFromIndex(sim_object_joint_type,i),sim_object_joint_type,nullptr);
     int forceSensorListSize=_simGetObjectListSize(sim_object_forcesensor_type);
     for (int i=0;i<forceSensorListSize;i++)
+        _updateShapeTagsFromObject((CDummy3DObject*)_simGetObjectFromIndex(sim_object_forcesensor_type,i),sim_object_forcesensor_type,nullptr);
+    int dummyListSize=_simGetObjectListSize(sim_object_dummy_type);
+    for (int i=0;i<dummyListSize;i++)
+        _updateShapeTagsFromObject((CDummy3DObject*)_simGetObjectFromIndex(sim_object_dummy_type,i),sim_object_dummy_type,nullptr);
+}
+
+void CRigidBodyContainerDyn::_updateShapeTagsFromObject(CDummy3DObject* it,int objectType,std::vector<CDummy3DObject*>* syncSet)
+{ // A shape stays tagged as long as at least one joint, force sensor or dummy tags it. Shapes whose tag changes are added to syncSet (if not nullptr)
+    std::vector<int> shapeIDs;
+    _getShapesToTagAsStaticAndNotRespondableButDynamic(it,objectType,shapeIDs);
+    std::vector<int>& previousShapeIDs=_shapesTaggedByObject[_simGetObjectID(it)];
+    std::vector<int> touchedShapeIDs;
+    for (int i=0;i<int(previousShapeIDs.size());i++)
     {
-        CDummyForceSensor* it=(CDummyForceSensor*)_simGetObjectFromIndex(sim_object_forcesensor_type,i);
-        int itChildListSize;
-        CDummy3DObject** itChildrenPointer=(CDummy3DObject**)_simGetObjectChildren(it,&itChildListSize);
-        if (itChildListSize==1)
+        if (--_shapeTagCounts[previousShapeIDs[i]]==0)
+            touchedShapeIDs.push_back(previousShapeIDs[i]);
+    }
+    for (int i=0;i<int(shapeIDs.size());i++)
+    {
+        if (_shapeTagCounts[shapeIDs[i]]++==0)
+            touchedShapeIDs.push_back(shapeIDs[i]);
+    }
+    for (int i=0;i<int(touchedShapeIDs.size());i++)
+    {
+        CDummyShape* shape=(CDummyShape*)_simGetObject(touchedShapeIDs[i]);
+        bool tag=(_shapeTagCounts[touchedShapeIDs[i]]>0);
+        if ( (shape!=nullptr)&&(tag!=(_simGetShapeIsStaticAndNotRespondableButDynamicTag(shape)!=0)) )
         {
-            CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(it);
-            if ( (parent!=nullptr)&&(_simGetObjectType(parent)==sim_object_shape_type) )
-            {
-                CDummyShape* parentShape=(CDummyShape*)parent;
-                if (_simGetObjectType(itChildrenPointer[0])==sim_object_shape_type)
-                { // we might have a regular case (non-looped)
-                    CDummyShape* childShape=(CDummyShape*)itChildrenPointer[0];
-                    if (_simIsShapeDynamicallyStatic(childShape)==0)
-                    {
-                        if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
-                            _simSetShapeIsStaticAndNotRespondableButDynamicTag(parentShape,true);
-                    }
-                }
-                else
-                { 
-                    if (_simGetObjectType(itChildrenPointer[0])==sim_object_dummy_type)
-                    { // we might have a complex case (looped)
-                        CDummyDummy* dummyA=(CDummyDummy*)itChildrenPointer[0];
-                        int dummyALinkedDummyID;
-                        int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
-                        CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
-                        if ((dummyB!=nullptr)&&(dummyALinkType==sim_dummy_linktype_dynamics_loop_closure))
-                        {
-                            int dummyAChildListSize,dummyBChildListSize;
-                            _simGetObjectChildren(dummyA,&dummyAChildListSize);
-                            _simGetObjectChildren(dummyB,&dummyBChildListSize);
-                            if ((dummyAChildListSize==0)&&(dummyBChildListSize==0))
-                            {
-                                CDummy3DObject* par=(CDummy3DObject*)_simGetParentObject(dummyB);
-                                if ((par!=nullptr)&&(_simGetObjectType(par)==sim_object_shape_type))
-                                {
-                                    CDummyShape* childShape=(CDummyShape*)par;
-                                    if ((_simIsShapeDynamicallyStatic(childShape)==0)||(_simIsShapeDynamicallyStatic(parentShape)==0))
-                                    {
-                                        if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
-                                            _simSetShapeIsStaticAndNotRespondableButDynamicTag(parentShape,true);
-                                        if ( _simIsShapeDynamicallyStatic(childShape)&&(_simIsShapeDynamicallyRespondable(childShape)==0) )
-                                            _simSetShapeIsStaticAndNotRespondableButDynamicTag(childShape,true);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            _simSetShapeIsStaticAndNotRespondableButDynamicTag(shape,tag);
+            if (syncSet!=nullptr)
+                _addToSyncSet((CDummy3DObject*)shape,syncSet[0]);
         }
     }
-    // 2. We check all linked dummies and look if they connect a static non-collidable shape and a dynamic shape (this section was forgotten, added it on 2010/03/18):
-    int dummyListSize=_simGetObjectListSize(sim_object_dummy_type);
-    for (int i=0;i<dummyListSize;i++)
-    {
-        CDummyDummy* dummyA=(CDummyDummy*)_simGetObjectFromIndex(sim_object_dummy_type,i);
+    previousShapeIDs.swap(shapeIDs);
+}
+
+void CRigidBodyContainerDyn::_getShapesToTagAsStaticAndNotRespondableButDynamic(CDummy3DObject* it,int objectType,std::vector<int>& shapeIDs)
+{ // it is a joint, a force sensor or a dummy. We look if it connects a static non-collidable shape (parent) and a dynamic shape (child) (or the looped variant)
+    if (objectType==sim_object_dummy_type)
+    { // linked dummies (this section was forgotten, added it on 2010/03/18):
+        CDummyDummy* dummyA=(CDummyDummy*)it;
         int dummyALinkedDummyId;
         int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyId);
         CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyId);
@@ -1612,9 +2821,64 @@ void CRigidBodyContainerDyn::_tagStaticAndNotCollidableButDynamicShapes()
                     if ((_simIsShapeDynamicallyStatic(childShape)==0)||(_simIsShapeDynamicallyStatic(parentShape)==0))
                     {
                         if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
-                            _simSetShapeIsStaticAndNotRespondableButDynamicTag(parentShape,true);
+                            shapeIDs.push_back(_simGetObjectID(parentShape));
                         if ( _simIsShapeDynamicallyStatic(childShape)&&(_simIsShapeDynamicallyRespondable(childShape)==0) )
-                            _simSetShapeIsStaticAndNotRespondableButDynamicTag(childShape,true);
+                            shapeIDs.push_back(_simGetObjectID(childShape));
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    if ( (objectType==sim_object_joint_type)&&(_simGetJointMode(it)!=sim_jointmode_force)&&(_simIsJointInHybridOperation(it)==0) )
+        return; // not a dynamic joint
+    // we have a dynamic joint or a force sensor here.
+    int itChildListSize;
+    CDummy3DObject** itChildrenPointer=(CDummy3DObject**)_simGetObjectChildren(it,&itChildListSize);
+    if (itChildListSize==1)
+    {
+        CDummy3DObject* parent=(CDummy3DObject*)_simGetParentObject(it);
+        if ( (parent!=nullptr)&&(_simGetObjectType(parent)==sim_object_shape_type) )
+        {
+            CDummyShape* parentShape=(CDummyShape*)parent;
+            if (_simGetObjectType(itChildrenPointer[0])==sim_object_shape_type)
+            { // we might have a regular case (non-looped)
+                CDummyShape* childShape=(CDummyShape*)itChildrenPointer[0];
+                if (_simIsShapeDynamicallyStatic(childShape)==0)
+                {
+                    if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
+                        shapeIDs.push_back(_simGetObjectID(parentShape));
+                }
+            }
+            else
+            {
+                if (_simGetObjectType(itChildrenPointer[0])==sim_object_dummy_type)
+                { // we might have a complex case (looped)
+                    CDummyDummy* dummyA=(CDummyDummy*)itChildrenPointer[0];
+                    int dummyALinkedDummyID;
+                    int dummyALinkType=_simGetDummyLinkType(dummyA,&dummyALinkedDummyID);
+                    CDummyDummy* dummyB=(CDummyDummy*)_simGetObject(dummyALinkedDummyID);
+                    if ((dummyB!=nullptr)&&(dummyALinkType==sim_dummy_linktype_dynamics_loop_closure))
+                    {
+                        int dummyAChildListSize,dummyBChildListSize;
+                        _simGetObjectChildren(dummyA,&dummyAChildListSize);
+                        _simGetObjectChildren(dummyB,&dummyBChildListSize);
+                        if ((dummyAChildListSize==0)&&(dummyBChildListSize==0))
+                        {
+                            CDummy3DObject* par=(CDummy3DObject*)_simGetParentObject(dummyB);
+                            if ((par!=nullptr)&&(_simGetObjectType(par)==sim_object_shape_type))
+                            {
+                                CDummyShape* childShape=(CDummyShape*)par;
+                                if ((_simIsShapeDynamicallyStatic(childShape)==0)||(_simIsShapeDynamicallyStatic(parentShape)==0))
+                                {
+                                    if ( _simIsShapeDynamicallyStatic(parentShape)&&(_simIsShapeDynamicallyRespondable(parentShape)==0) )
+                                        shapeIDs.push_back(_simGetObjectID(parentShape));
+                                    if ( _simIsShapeDynamicallyStatic(childShape)&&(_simIsShapeDynamicallyRespondable(childShape)==0) )
+                                        shapeIDs.push_back(_simGetObjectID(childShape));
+                                }
+                            }
+                        }
                     }
                 }
             }
@@ -1624,10 +2888,63 @@ void CRigidBodyContainerDyn::_tagStaticAndNotCollidableButDynamicShapes()
 
 void CRigidBodyContainerDyn::_handleMotorControls(int passCnt,int totalPasses)
 {
-    std::vector<CConstraintDyn*> constraintsToHandle;
-    std::vector<CDummyJoint*> constraintsToHandle_joint;
-    std::vector<int> constraintsToHandle_order;
+    if (_motorScheduleIsDirty)
+        _rebuildMotorSchedule();
+
+    if (_sleepMode==dyn_sleep_on)
+    { // a new motor target does not wake a sleeping island by itself
+        for (int i=0;i<int(_motorSchedule.size());i++)
+        {
+            if (_motorSchedule[i].constraint->motorTargetChanged(_motorSchedule[i].joint))
+                _motorSchedule[i].constraint->wakeUpBodies();
+        }
+    }
+
+    // Motors in position control go through the joint control callback, in the scheduled order (i.e. by call order):
+    _motorBatch.clear();
+    for (int i=0;i<int(_motorSchedule.size());i++)
+    {
+        SMotorScheduleEntry* entry=&_motorSchedule[i];
+        if (entry->constraint->isMotorPositionControlled(entry->joint))
+            entry->constraint->handleMotorControl(entry->joint,passCnt,totalPasses);
+        else
+            _motorBatch.push_back(i);
+    }
+
+    // The others (velocity mode, or motor disabled) only need their limits and target velocity set, in one loop.
+    // They see target velocities that callbacks modified in this pass:
+    for (int i=0;i<int(_motorBatch.size());i++)
+    {
+        SMotorScheduleEntry* entry=&_motorSchedule[_motorBatch[i]];
+        entry->constraint->handleVelocityMotorControl(entry->joint,entry->jointType,passCnt,totalPasses);
+    }
+
+    if (passCnt==totalPasses)
+    { // a motor can be enabled/disabled or switch to position control anytime, without refresh flag
+        for (int i=0;i<int(_motorSchedule.size());i++)
+            _visualizationFlagMightChange(_motorSchedule[i].constraint->getJointID());
+    }
+}
 
+void CRigidBodyContainerDyn::_validateMotorSchedule()
+{ // joints and constraints that were added/removed already flagged the schedule. The call order of a joint can change anytime
+    if (!_motorScheduleIsDirty)
+    {
+        for (int i=0;i<int(_motorSchedule.size());i++)
+        {
+            if (_simGetJointCallbackCallOrder(_motorSchedule[i].joint)!=_motorSchedule[i].callOrder)
+            {
+                _motorScheduleIsDirty=true;
+                break;
+            }
+        }
+    }
+}
+
+void CRigidBodyContainerDyn::_rebuildMotorSchedule()
+{
+    _motorScheduleIsDirty=false;
+    std::vector<SMotorScheduleEntry> entries;
     int jointListSize=_simGetObjectListSize(sim_object_joint_type);
     for (int i=0;i<jointListSize;i++)
     {
@@ -1635,34 +2952,35 @@ void CRigidBodyContainerDyn::_handleMotorControls(int passCnt,int totalPasses)
         if (it!=nullptr)
         {
             CConstraintDyn* constraint=getConstraintFromJointID(_simGetObjectID(it));
-            if (constraint!=nullptr)
+            int jointType=_simGetJointType(it);
+            if ( (constraint!=nullptr)&&((jointType==sim_joint_revolute_subtype)||(jointType==sim_joint_prismatic_subtype)) ) // spherical joints have no motor
             {
-                constraintsToHandle.push_back(constraint);
-                constraintsToHandle_joint.push_back(it);
-                constraintsToHandle_order.push_back(_simGetJointCallbackCallOrder(it));
+                SMotorScheduleEntry entry;
+                entry.constraint=constraint;
+                entry.joint=it;
+                entry.jointType=jointType;
+                entry.callOrder=_simGetJointCallbackCallOrder(it);
+                entries.push_back(entry);
             }
         }
     }
 
-    // handle first the higher priority joints:
-    for (int i=0;i<int(constraintsToHandle.size());i++)
+    // First the higher priority joints, then the normal priority joints, then the low priority joints:
+    _motorSchedule.clear();
+    for (int i=0;i<int(entries.size());i++)
     {
-        if (constraintsToHandle_order[i]<0)
-            constraintsToHandle[i]->handleMotorControl(constraintsToHandle_joint[i],passCnt,totalPasses);
+        if (entries[i].callOrder<0)
+            _motorSchedule.push_back(entries[i]);
     }
-
-    // now the normal priority joints:
-    for (int i=0;i<int(constraintsToHandle.size());i++)
+    for (int i=0;i<int(entries.size());i++)
     {
-        if (constraintsToHandle_order[i]==0)
-            constraintsToHandle[i]->handleMotorControl(constraintsToHandle_joint[i],passCnt,totalPasses);
+        if (entries[i].callOrder==0)
+            _motorSchedule.push_back(entries[i]);
     }
-
-    // now the low priority joints:
-    for (int i=0;i<int(constraintsToHandle.size());i++)
+    for (int i=0;i<int(entries.size());i++)
     {
-        if (constraintsToHandle_order[i]>0)
-            constraintsToHandle[i]->handleMotorControl(constraintsToHandle_joint[i],passCnt,totalPasses);
+        if (entries[i].callOrder>0)
+            _motorSchedule.push_back(entries[i]);
     }
 }
 
@@ -1684,65 +3002,200 @@ void CRigidBodyContainerDyn::_updateHybridJointTargetPositions()
 
 float* CRigidBodyContainerDyn::getContactPoints(int* cnt)
 {
-    cnt[0]=_contactPoints.size()/3;
+    std::vector<float>& points=_asyncStepRunning?_contactPointsSnapshot:_contactPoints; // the live ones are being written by the worker
+    cnt[0]=int(points.size())/3;
     if (cnt[0]==0)
         return(nullptr);
-    return(&_contactPoints[0]);
+    return(&points[0]);
 }
 
 bool CRigidBodyContainerDyn::getContactForce(int dynamicPass,int objectHandle,int index,int objectHandles[2],float* contactInfo)
 {
-    int scanIndex=0;
     int ind=(index|sim_handleflag_extended)-sim_handleflag_extended;
     bool extended=((index&sim_handleflag_extended)!=0);
-    for (int i=0;i<int(_contactInfo.size());i++)
+    CContactArena& contacts=_asyncStepRunning?_contactsSnapshot:_contacts; // the live ones are being written by the worker
+    int contactIndex=contacts.getIndexedContact(dynamicPass,objectHandle,ind);
+    if (contactIndex<0)
+        return(false);
+    _getContactForce(contacts,contactIndex,objectHandle,extended,objectHandles,contactInfo);
+    return(true);
+}
+
+int CRigidBodyContainerDyn::getContactForces(int dynamicPass,int objectHandle,int maxCount,int* objectHandles,float* contactInfo)
+{ // returns the number of available contacts. At most maxCount are written (2 handles and 9 values each: position, force, normal)
+    CContactArena& contacts=_asyncStepRunning?_contactsSnapshot:_contacts;
+    int retVal=0;
+    for (int p=0;p<contacts.getPassCount();p++)
     {
-        if ( (_contactInfo[i].subPassNumber==dynamicPass)||(dynamicPass==sim_handle_all) )
+        const SContactPassIndex& passIndex=contacts.getPassIndex(p);
+        if ( (passIndex.subPassNumber==dynamicPass)||(dynamicPass==sim_handle_all) )
         {
-            if ( (_contactInfo[i].objectID1==objectHandle)||(_contactInfo[i].objectID2==objectHandle)||(sim_handle_all==objectHandle) )
+            int first=passIndex.firstContact;
+            int count=passIndex.contactCount;
+            if (objectHandle!=sim_handle_all)
+                first=contacts.getObjectRange(passIndex,objectHandle,count);
+            for (int i=0;i<count;i++)
             {
-                if (ind==scanIndex)
+                if ( (retVal<maxCount)&&(objectHandles!=nullptr)&&(contactInfo!=nullptr) )
                 {
-                    contactInfo[0]=_contactInfo[i].position(0);
-                    contactInfo[1]=_contactInfo[i].position(1);
-                    contactInfo[2]=_contactInfo[i].position(2);
-                    if (_contactInfo[i].objectID2==objectHandle)
-                    {
-                        objectHandles[0]=_contactInfo[i].objectID2;
-                        objectHandles[1]=_contactInfo[i].objectID1;
-                        contactInfo[3]=-_contactInfo[i].directionAndAmplitude(0);
-                        contactInfo[4]=-_contactInfo[i].directionAndAmplitude(1);
-                        contactInfo[5]=-_contactInfo[i].directionAndAmplitude(2);
-                        if (extended)
-                        {
-                            contactInfo[6]=-_contactInfo[i].surfaceNormal(0);
-                            contactInfo[7]=-_contactInfo[i].surfaceNormal(1);
-                            contactInfo[8]=-_contactInfo[i].surfaceNormal(2);
-                        }
-                    }
-                    else
-                    {
-                        objectHandles[0]=_contactInfo[i].objectID1;
-                        objectHandles[1]=_contactInfo[i].objectID2;
-                        contactInfo[3]=_contactInfo[i].directionAndAmplitude(0);
-                        contactInfo[4]=_contactInfo[i].directionAndAmplitude(1);
-                        contactInfo[5]=_contactInfo[i].directionAndAmplitude(2);
-                        if (extended)
-                        {
-                            contactInfo[6]=_contactInfo[i].surfaceNormal(0);
-                            contactInfo[7]=_contactInfo[i].surfaceNormal(1);
-                            contactInfo[8]=_contactInfo[i].surfaceNormal(2);
-                        }
-                    }
-                    return(true);
+                    int contactIndex=first+i;
+                    if (objectHandle!=sim_handle_all)
+                        contactIndex=contacts.getObjectContact(first+i);
+                    _getContactForce(contacts,contactIndex,objectHandle,true,objectHandles+2*retVal,contactInfo+9*retVal);
                 }
-                scanIndex++;
+                retVal++;
             }
         }
     }
+    return(retVal);
+}
+
+void CRigidBodyContainerDyn::_getContactForce(CContactArena& contacts,int contactIndex,int objectHandle,bool extended,int objectHandles[2],float* contactInfo)
+{
+    const float* position=contacts.getPosition(contactIndex);
+    const float* force=contacts.getDirectionAndAmplitude(contactIndex);
+    const float* normal=contacts.getSurfaceNormal(contactIndex);
+    float sign=1.0f;
+    objectHandles[0]=contacts.getObjectID1(contactIndex);
+    objectHandles[1]=contacts.getObjectID2(contactIndex);
+    if (objectHandles[1]==objectHandle)
+    {
+        objectHandles[0]=objectHandles[1];
+        objectHandles[1]=contacts.getObjectID1(contactIndex);
+        sign=-1.0f;
+    }
+    contactInfo[0]=position[0];
+    contactInfo[1]=position[1];
+    contactInfo[2]=position[2];
+    contactInfo[3]=sign*force[0];
+    contactInfo[4]=sign*force[1];
+    contactInfo[5]=sign*force[2];
+    if (extended)
+    {
+        contactInfo[6]=sign*normal[0];
+        contactInfo[7]=sign*normal[1];
+        contactInfo[8]=sign*normal[2];
+    }
+}
+
+const SCollisionFilter* CRigidBodyContainerDyn::getCollisionFilter(int objectID)
+{ // returns nullptr if objectID is not a shape with a rigid body (e.g. a particle)
+    if ( (objectID<0)||(objectID>=int(_collisionFilters.size()))||(_allRigidBodiesIndex[objectID]==nullptr) )
+        return(nullptr);
+    SCollisionFilter* filter=&_collisionFilters[objectID];
+    if (filter->generation!=_collisionFilterGeneration)
+    {
+        CDummyShape* shape=(CDummyShape*)_simGetObject(objectID);
+        if (shape==nullptr)
+            return(nullptr);
+        _fillCollisionFilter(filter,shape);
+    }
+    return(filter);
+}
+
+void CRigidBodyContainerDyn::_fillCollisionFilter(SCollisionFilter* filter,CDummyShape* shape)
+{
+    int treeProp=_simGetTreeDynamicProperty(shape);
+    filter->shape=shape;
+    filter->localGlobalCollidableRoot=(void*)_simGetLastParentForLocalGlobalCollidable(shape);
+    filter->collisionMask=_simGetDynamicCollisionMask(shape);
+    filter->flags=0;
+    if (_simIsShapeDynamicallyRespondable(shape))
+        filter->flags|=dyn_collfilter_respondable;
+    if (treeProp&sim_objdynprop_respondable)
+        filter->flags|=dyn_collfilter_treerespondable;
+    if (_simIsShapeDynamicallyStatic(shape)||((treeProp&sim_objdynprop_dynamic)==0))
+        filter->flags|=dyn_collfilter_staticornottreedynamic;
+    filter->generation=_collisionFilterGeneration;
+}
+
+void CRigidBodyContainerDyn::_fillAllCollisionFilters()
+{ // for engines that filter pairs from several threads: getCollisionFilter then only reads
+    for (int i=0;i<int(_allRigidBodiesList.size());i++)
+    {
+        CDummyShape* shape=_allRigidBodiesList[i]->getShape();
+        SCollisionFilter* filter=&_collisionFilters[_simGetObjectID(shape)];
+        if (filter->generation!=_collisionFilterGeneration)
+            _fillCollisionFilter(filter,shape);
+    }
+}
+
+void CRigidBodyContainerDyn::_invalidateCollisionFilters()
+{
+    _collisionFilterGeneration++;
+    if (_collisionFilterGeneration==0)
+        _collisionFilterGeneration=1; // 0 means never valid
+}
+
+bool CRigidBodyContainerDyn::_getContactMaterial(int shapeIdA,int shapeIdB,SContactMaterial*& material)
+{ // returns false if material needs to be (re)computed by the caller. Combined values must be symmetric
+    if (shapeIdA>shapeIdB)
+        std::swap(shapeIdA,shapeIdB);
+    unsigned long long key=(((unsigned long long)shapeIdA)<<32)|((unsigned int)shapeIdB);
+    return(_getContactMaterial(key,_allRigidBodiesIndex[shapeIdA]->getRigidBodyID(),_allRigidBodiesIndex[shapeIdB]->getRigidBodyID(),material));
+}
+
+bool CRigidBodyContainerDyn::_getContactMaterial(int shapeId,CParticleObject* particleObject,SContactMaterial*& material)
+{ // returns false if material needs to be (re)computed by the caller
+    unsigned long long key=(((unsigned long long)shapeId)<<32)|((unsigned int)(-1-particleObject->getObjectID()));
+    return(_getContactMaterial(key,_allRigidBodiesIndex[shapeId]->getRigidBodyID(),particleObject->getUniqueID(),material));
+}
+
+bool CRigidBodyContainerDyn::_getContactMaterial(unsigned long long key,unsigned int validityA,unsigned int validityB,SContactMaterial*& material)
+{ // Rigid bodies are rebuilt when the dynamic properties of their shape change, so the rigid body ID tells us if an entry is still valid
+    if ( (_contactMaterials.size()>=65536)&&(_contactMaterials.find(key)==_contactMaterials.end()) )
+        _contactMaterials.clear(); // keep entries of removed shapes and particle objects from piling up
+    std::pair<std::unordered_map<unsigned long long,SContactMaterial>::iterator,bool> res=_contactMaterials.insert(std::make_pair(key,SContactMaterial()));
+    material=&res.first->second;
+    if ( (!res.second)&&(material->validity[0]==validityA)&&(material->validity[1]==validityB) )
+        return(true);
+    material->validity[0]=validityA;
+    material->validity[1]=validityB;
     return(false);
 }
 
+int CRigidBodyContainerDyn::_handleCustomContact(int objID1,int objID2,int engine,int* dataInt,float* dataFloat)
+{ // same return values as _simHandleCustomContact: 0 means no collision, >0 means use the (possibly modified) data, <0 means use default values
+  // Without contact batch callback, always forwarded: the simulator dispatches to script and plugin contact callbacks, and can't tell us whether any is installed
+    _customContactHandled=true; // can be called from engine threads (e.g. Newton)
+    if (_contactBatchCallback!=nullptr)
+    { // engines that can't collect the pairs of a pass hand them over one by one
+        int objectHandles[2]={objID1,objID2};
+        int result;
+        _contactBatchCallback(engine,1,objectHandles,&result,dataInt,dataFloat);
+        return(result);
+    }
+    return(_simHandleCustomContact(objID1,objID2,engine,dataInt,dataFloat));
+}
+
+bool CRigidBodyContainerDyn::_isContactBatchingActive()
+{ // when true, engines that can should collect the colliding pairs of a pass with _addToContactBatch, then call _handleContactBatch
+    return(_contactBatchCallback!=nullptr);
+}
+
+void CRigidBodyContainerDyn::_addToContactBatch(int objID1,int objID2,const int dataInt[3],const float dataFloat[14])
+{
+    _contacts.reserveCounted(_contactBatch.objectIDs,_contactBatch.objectIDs.size()+2);
+    _contacts.reserveCounted(_contactBatch.dataInt,_contactBatch.dataInt.size()+3);
+    _contacts.reserveCounted(_contactBatch.dataFloat,_contactBatch.dataFloat.size()+14);
+    _contactBatch.objectIDs.push_back(objID1);
+    _contactBatch.objectIDs.push_back(objID2);
+    _contactBatch.dataInt.insert(_contactBatch.dataInt.end(),dataInt,dataInt+3);
+    _contactBatch.dataFloat.insert(_contactBatch.dataFloat.end(),dataFloat,dataFloat+14);
+}
+
+void CRigidBodyContainerDyn::_handleContactBatch(int engine)
+{ // one callback for all pairs collected since the last call. The caller reads _contactBatch, then clears it
+    int pairCount=int(_contactBatch.objectIDs.size())/2;
+    _contacts.reserveCounted(_contactBatch.results,size_t(pairCount));
+    _contactBatch.results.resize(pairCount);
+    if (pairCount>0)
+    {
+        _customContactHandled=true;
+        _contactBatchCallback(engine,pairCount,&_contactBatch.objectIDs[0],&_contactBatch.results[0],&_contactBatch.dataInt[0],&_contactBatch.dataFloat[0]);
+    }
+}
+
 void CRigidBodyContainerDyn::clearAdditionalForcesAndTorques()
 {
     int shapeListSize=_simGetObjectListSize(sim_object_shape_type);
@@ -1762,7 +3215,18 @@ void CRigidBodyContainerDyn::handleAdditionalForcesAndTorques()
         if (shape!=nullptr)
             body->handleAdditionalForcesAndTorques(shape);
     }
-    C3Vector gravity;
-    _simGetGravity(gravity.data);
-    particleCont.handleAntiGravityForces_andFluidFrictionForces(gravity);
+}
+
+int CRigidBodyContainerDyn::collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts)
+{ // not scaled. Returns the contacts of a sphere with the respondable shapes that collide with respondableMask (see CParticleObject::getShapeRespondableMask)
+    return(0);
+}
+
+bool CRigidBodyContainerDyn::_canParticleCollideWithShape(int objectID,int respondableMask)
+{ // same rule as for particles that are engine bodies
+    const SCollisionFilter* filter=getCollisionFilter(objectID);
+    if (filter==nullptr)
+        return(false);
+    const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+    return( ((filter->flags&respFlags)==respFlags)&&((filter->collisionMask&respondableMask&0xff00)!=0) );
 }
@@ -4,32 +4,155 @@
 #include "CollShapeDyn.h"
 #include "ConstraintDyn.h"
 #include "ParticleContainer.h"
+#include "ContactArena.h"
+#include "StepProfiler.h"
 #include "dummyClasses.h"
 #include "3Vector.h"
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
 
-struct SContactInfo
-{
-    int subPassNumber;
-    int objectID1;
-    int objectID2;
+struct SCollisionFilter
+{ // what the engines' pair filtering callbacks need to know about a shape, so that they don't need to call the simulator for each candidate pair
+    CDummyShape* shape;
+    void* localGlobalCollidableRoot; // pairs with the same root use the local mask bits
+    unsigned int collisionMask; // 0x00ff: local, 0xff00: global
+    unsigned char flags; // see dyn_collfilter_*
+    unsigned int generation; // the record is valid for the current step only
+};
+
+enum { // SCollisionFilter flags
+    dyn_collfilter_respondable=1, // shape is dynamically respondable
+    dyn_collfilter_treerespondable=2, // the tree's dynamic property has the respondable bit
+    dyn_collfilter_staticornottreedynamic=4 // shape is static, or the tree's dynamic property doesn't have the dynamic bit
+};
+
+struct SContactMaterial
+{ // combined surface properties of two shapes, or of a shape and a particle object
+    float friction;
+    float restitution;
+    float softErp;
+    float softCfm;
+    int maxContacts;
+    unsigned int validity[2]; // rigid body ID, or particle object unique ID, of each side when computed
+};
+
+typedef void (*dynContactBatchCallback)(int engine,int pairCount,const int* objectHandles,int* results,int* dataInt,float* dataFloat);
+
+struct SContactBatch
+{ // colliding pairs of a pass, waiting for the contact batch callback (one array per input/output)
+    std::vector<int> objectIDs; // 2 per pair
+    std::vector<int> results; // per pair, same meaning as the return value of _simHandleCustomContact
+    std::vector<int> dataInt; // 3 per pair
+    std::vector<float> dataFloat; // 14 per pair
+};
+
+struct SDynWorldSettings
+{ // what a world is created with. The scaling factors and ID ranges are fixed for its lifetime, the modes can be changed with the setters of the world
+    float positionScalingFactor;
+    float linearVelocityScalingFactor;
+    float massScalingFactor;
+    float masslessInertiaScalingFactor;
+    float forceScalingFactor;
+    float torqueScalingFactor;
+    float gravityScalingFactor;
+    float dynamicActivityRange;
+    int dynamicParticlesIdStart;
+    int objectIdStart;
+    int objectIdEnd;
+    int worldSyncMode;
+    int writeBackMode;
+    bool intermediateWriteBackNeeded;
+    int subStepMode;
+    float adaptiveSubStepThresholds[3];
+    int adaptiveSubStepMaxPassFactor;
+    int visualizationFlagMode;
+    int sleepMode;
+    float sleepParams[3];
+    int particleEngine;
+    dynContactBatchCallback contactBatchCallback;
+};
+
+struct SObjectSyncState
+{ // what we last saw of a shape, joint, dummy or force sensor (for incremental world synchronization)
+    void* parent;
+    void* geomProxy;
+    int treeDynamicProperty;
+    int auxState[2]; // shape: static/respondable, joint: mode/hybrid, dummy: link type/linked dummy
+    unsigned int visitGeneration; // to add an object only once to the sync set
+};
+
+struct SMotorScheduleEntry
+{ // a motorizable joint constraint, in the order _handleMotorControls handles it
+    CConstraintDyn* constraint;
+    CDummyJoint* joint;
+    int jointType; // sim_joint_revolute_subtype or sim_joint_prismatic_subtype
+    int callOrder; // joint callback call order at the time of the scheduling
+};
+
+enum { // world synchronization modes
+    dyn_worldsync_fullrescan=0, // the whole scene is rescanned every step (default)
+    dyn_worldsync_incremental, // only changed objects (and the objects connected to them) are revalidated. Changes are taken from the simulator's refresh flags, and a few objects are fully compared in each step, in turn
+    dyn_worldsync_incremental_crosscheck // same as above, followed by a full rescan that reports the objects whose body, constraint or shape tag differ, and an inconsistent collision shape list (debug)
+};
+
+enum { // scene write-back modes
+    dyn_writeback_everypass=0, // body poses, velocities and joint positions are written to the scene after each sub-pass (default)
+    dyn_writeback_finalpass // same as above, but only after the last sub-pass, unless someone needs the intermediate state
+};
+
+enum { // sub-step modes
+    dyn_substep_fixed=0, // dt/(engine step size) passes (default)
+    dyn_substep_adaptive // between 1 and dyn_substep_fixed*maxPassFactor passes, depending on the penetration depth, constraint error and body velocity of the previous step
+};
+
+enum { // reasons for more adaptive sub-steps (bits)
+    dyn_substepreason_penetration=1,
+    dyn_substepreason_constrainterror=2,
+    dyn_substepreason_velocity=4
+};
+
+enum { // visualization flag modes
+    dyn_visflags_always=0, // all flags are set at the end of each step (default)
+    dyn_visflags_onchange, // only flags that changed since they were last set. Only the objects whose body, constraint or motor changed are checked
+    dyn_visflags_off // no flags are set (e.g. headless). They can still be pulled with getVisualizationFlags
+};
+
+enum { // sleep modes
+    dyn_sleep_off=0, // bodies never sleep (default, except for unconstrained Bullet bodies)
+    dyn_sleep_on // resting bodies and islands are deactivated after a while, see setSleepParams
+};
+
+enum { // particle engines, see setParticleEngine
+    dyn_particleengine_bodies=0, // each particle is a rigid body of the physics engine (default)
+    dyn_particleengine_soa // particles are simulated by CParticleSystem. Only their reaction forces go to the engine
+};
+
+struct SParticleShapeContact
+{ // not scaled
     C3Vector position;
-    C3Vector surfaceNormal;
-    C3Vector directionAndAmplitude;
+    C3Vector normal; // pointing towards the particle
+    float depth;
+    int shapeID;
+};
+
+enum {
+    dyn_state_version=2 // format of the saveState/restoreState data. Increase when SRigidBodyState, SConstraintState or SParticleState change
 };
 
 class CRigidBodyContainerDyn  
 {
 public:
-    CRigidBodyContainerDyn();
+    CRigidBodyContainerDyn(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn();
 
     virtual int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
     virtual void applyGravity();
     virtual void serializeDynamicContent(const std::string& filenameAndPath,int maxSerializeBufferSize);
 
-    void removeRigidBodyFromCollisionShapeDependency(int rigidBodyID);
+    void removeRigidBodyFromCollisionShapeDependency(CRigidBodyDyn* body);
     CRigidBodyDyn* getRigidBodyFromShapeID(int shapeID);
     CConstraintDyn* getConstraintFromJointID(int jointID);
     CConstraintDyn* getConstraintFromDummyID(int dummyID);
@@ -37,6 +160,13 @@ public:
     CCollShapeDyn* getCollisionShapeFromGeomObject(CDummyGeomProxy* geomData);
 
     void handleDynamics(float dt,float simulationTime);
+    void startDynamics(float dt,float simulationTime,bool asynchronous);
+    void finishDynamics();
+    bool isStepPending();
+    bool saveState(std::vector<unsigned char>& state);
+    bool restoreState(const unsigned char* state,int stateSize);
+    int getVisualizationFlags(int maxCount,int* objectHandles,int* flags);
+    int getSubStepMeasures(float measures[3]);
     bool isDynamicContentAvailable();
 
     void reportDynamicWorldConfiguration(int totalPassesCount,bool doNotApplyJointIntrinsicPositions,float simulationTime);
@@ -44,11 +174,16 @@ public:
     void reportRigidBodyConfigurationsAndVelocities();
     void reportConstraintConfigurations(int totalPassesCount,bool doNotApplyJointIntrinsicPositions);
     void reportConstraintSecondPartConfigurations();
+    void reportConstraintForces(int totalPassesCount);
 
     void handleAdditionalForcesAndTorques();
     void clearAdditionalForcesAndTorques();
 
+    virtual int collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts);
+
     bool getContactForce(int dynamicPass,int objectHandle,int index,int objectHandles[2],float* contactInfo);
+    const SCollisionFilter* getCollisionFilter(int objectID);
+    int getContactForces(int dynamicPass,int objectHandle,int maxCount,int* objectHandles,float* contactInfo);
 
     int getDynamicsCalculationPasses();
 
@@ -56,66 +191,141 @@ public:
 
     float gravityVectorLength; // updated when handleDynamics is called
 
-    static CParticleContainer particleCont;
-    static CRigidBodyContainerDyn* currentRigidBodyContainerDynObject;
+    CParticleContainer particleCont;
+#ifdef DYN_PROFILING
+    CStepProfiler profiler;
+#endif
+    static thread_local CRigidBodyContainerDyn* currentRigidBodyContainerDynObject; // the container being stepped or queried by this thread (the main thread or the async step worker)
 
-    static void setPositionScalingFactorDyn(float f);
+    void makeCurrent();
+    unsigned int getContactAllocationCount();
+    static void getDefaultWorldSettings(SDynWorldSettings& settings);
+
+    void setDynamicsInternalTimeStep(float dt);
+    void setWorldSyncMode(int mode);
+    void setWriteBackMode(int mode);
+    void setIntermediateWriteBackNeeded(bool needed);
+    void setSubStepMode(int mode);
+    void setAdaptiveSubStepParams(const float thresholds[3],int maxPassFactor);
+    void setVisualizationFlagMode(int mode);
+    void setSleepMode(int mode);
+    void setSleepParams(const float params[3]);
+    void setParticleEngine(int engine);
+    void setContactBatchCallback(dynContactBatchCallback callback);
+
+    // Following return the settings of currentRigidBodyContainerDynObject, for the bodies, shapes, constraints and particles of that world:
     static float getPositionScalingFactorDyn();
-    static void setLinearVelocityScalingFactorDyn(float f);
     static float getLinearVelocityScalingFactorDyn();
-    static void setMassScalingFactorDyn(float f);
     static float getMassScalingFactorDyn();
-    static void setMasslessInertiaScalingFactorDyn(float f);
     static float getMasslessInertiaScalingFactorDyn();
-    static void setForceScalingFactorDyn(float f);
     static float getForceScalingFactorDyn();
-    static void setTorqueScalingFactorDyn(float f);
     static float getTorqueScalingFactorDyn();
-    static void setGravityScalingFactorDyn(float f);
     static float getGravityScalingFactorDyn();
-    static void setDynamicActivityRange(float f);
     static float getDynamicActivityRange();
-    static void setDynamicsInternalTimeStep(float dt);
     static float getDynamicsInternalTimeStep();
-    static void setDynamicParticlesIdStart(int a);
     static int getDynamicParticlesIdStart();
-    static void set3dObjectIdStart(int a);
     static int get3dObjectIdStart();
-    static void set3dObjectIdEnd(int a);
     static int get3dObjectIdEnd();
+    static int getWorldSyncMode();
+    static int getWriteBackMode();
+    static bool getIntermediateWriteBackNeeded();
+    static int getSubStepMode();
+    static void getAdaptiveSubStepParams(float thresholds[3],int& maxPassFactor);
+    static int getVisualizationFlagMode();
+    static int getSleepMode();
+    static void getSleepParams(float params[3]);
+    static int getParticleEngine();
+    static dynContactBatchCallback getContactBatchCallback();
 
 protected:
     virtual void _stepDynamics(float dt,int pass);
+    virtual bool _stepDynamicsCollisions(float dt,int pass);
+    virtual void _stepDynamicsIntegration(float dt,int pass);
     virtual void _createDependenciesBetweenJoints();
     virtual void _removeDependenciesBetweenJoints(CConstraintDyn* theInvolvedConstraint);
 
     bool _updateDynamicWorld();
+    bool _updateDynamicWorldIncrementally();
+    void _crossCheckIncrementalWorldUpdate();
+    void _crossCheckCollisionShapes();
+    void _resetObjectSyncStates();
+    bool _refreshObjectSyncState(CDummy3DObject* it,int objectType);
+    bool _isObjectFlaggedForRefresh(CDummy3DObject* it,int objectID,int objectType);
+    void _invalidateJointAndForceSensorPart2s();
+    void _addToSyncSet(CDummy3DObject* it,std::vector<CDummy3DObject*>& syncSet);
+    void _addConnectedObjectsToSyncSet(CDummy3DObject* it,std::vector<CDummy3DObject*>& syncSet);
+    void _addLinkedDummyToSyncSet(CDummyDummy* dummy,std::vector<CDummy3DObject*>& syncSet);
 
     void _temporarilyDisableShapesOutOfDynamicActivityRange();
     void _tagStaticAndNotCollidableButDynamicShapes();
+    void _updateShapeTagsFromObject(CDummy3DObject* it,int objectType,std::vector<CDummy3DObject*>* syncSet);
+    void _getShapesToTagAsStaticAndNotRespondableButDynamic(CDummy3DObject* it,int objectType,std::vector<int>& shapeIDs);
     void _updateRigidBodiesFromSceneShapes();
     void _updateConstraintsFromSceneJoints();
     void _updateConstraintsFromSceneForceSensors();
     void _updateConstraintsFromSceneDummies();
     void _updateHybridJointTargetPositions();
 
+    bool _isRigidBodyStillValid(CRigidBodyDyn* body);
+    bool _isJointConstraintStillValid(CConstraintDyn* constraint);
+    bool _isDummyConstraintStillValid(CConstraintDyn* constraint);
+    bool _isForceSensorConstraintStillValid(CConstraintDyn* constraint);
+    void _updateRigidBodyFromSceneShape(CDummyShape* shape);
+    void _updateConstraintFromSceneJoint(CDummyJoint* joint);
+    void _updateConstraintFromSceneDummy(CDummyDummy* dummy);
+    void _updateConstraintFromSceneForceSensor(CDummyForceSensor* forceSensor);
+
 
     void _addOrUpdateRigidBody(CDummyShape* shape,bool forceStatic,bool forceNonRespondable);
     void _addOrUpdateJointConstraint(CDummyJoint* joint);
     void _addOrUpdateDummyConstraint(CDummyDummy* dummy);
     void _addOrUpdateForceSensorConstraint(CDummyForceSensor* forceSensor);
     void _handleMotorControls(int passCnt,int totalPasses);
+    void _validateMotorSchedule();
+    void _rebuildMotorSchedule();
 
     int _addRigidBody(CRigidBodyDyn* body);
     void _removeRigidBody(int rigidBodyID);
 
+    virtual void _resetContactCaches();
+    void _updateVisualizationFlags();
+    void _collectVisualizationFlags();
+    int _getVisualizationFlag(int objectID,void* object);
+    void _visualizationFlagMightChange(int objectID);
+    int _getPassesToUse(int fixedPasses);
+    void _wakeBodiesTouchingMovingKinematicBodies();
+    void _measureStepErrors();
+    void _preparePass(int pass);
+    void _finishPass(int pass);
+    void _asyncStepDynamics();
+    void _invalidateCollisionFilters();
+    int _handleCustomContact(int objID1,int objID2,int engine,int* dataInt,float* dataFloat);
+    bool _isContactBatchingActive();
+    void _addToContactBatch(int objID1,int objID2,const int dataInt[3],const float dataFloat[14]);
+    void _handleContactBatch(int engine);
+    bool _getContactMaterial(int shapeIdA,int shapeIdB,SContactMaterial*& material);
+    bool _getContactMaterial(int shapeId,CParticleObject* particleObject,SContactMaterial*& material);
+    bool _getContactMaterial(unsigned long long key,unsigned int validityA,unsigned int validityB,SContactMaterial*& material);
+    void _fillCollisionFilter(SCollisionFilter* filter,CDummyShape* shape);
+    bool _canParticleCollideWithShape(int objectID,int respondableMask);
+    void _fillAllCollisionFilters();
+    void _getContactForce(CContactArena& contacts,int contactIndex,int objectHandle,bool extended,int objectHandles[2],float* contactInfo);
+
+    bool _isSubPassWriteBackNeeded();
+    void _validateWriteBackOrder();
+    void _rebuildWriteBackOrder();
+    void _zeroVelocitiesOfShapesWithoutBody();
+    int _getObjectTreeDepth(CDummy3DObject* it,std::vector<int>& objectDepths);
+
     // Following 3 go in pair:
     void _calculateBodyToShapeTransformations_forKinematicBodies(float dt);
     void reportShapeConfigurations_forKinematicBodies(float t,float cumulatedTimeStep);
     void _applyCorrectEndConfig_forKinematicBodies();
+    void _rebuildKinematicBodyList();
 
     void _announceToConstraintsBodyWillBeDestroyed(int rigidBodyID);
     void _removeConstraintFromIndex(int indexPos);
+    void _removeConstraint(CConstraintDyn* constraint);
 
     std::vector<CRigidBodyDyn*> _allRigidBodiesList;
     std::vector<CRigidBodyDyn*> _allRigidBodiesIndex;
@@ -123,26 +333,100 @@ protected:
     std::vector<CConstraintDyn*> _allConstraintsIndex;
 
     std::vector<CCollShapeDyn*> _allCollisionShapes;
+    std::unordered_map<CDummyGeomProxy*,CCollShapeDyn*> _allCollisionShapesIndex; // keyed by geom proxy
 
     int _nextRigidBodyID;
 
+    // Following used for incremental world synchronization:
+    std::vector<SObjectSyncState> _objectSyncStates; // indexed by object ID
+    std::vector<void*> _syncedObjects[4]; // shapes, joints, dummies and force sensors, in scene order
+    std::vector<int> _syncedObjectIDs[4]; // same as above
+    int _syncAuditPosition; // next object whose properties are fully compared, see _updateDynamicWorldIncrementally
+    bool _dynamicTreeDisabled; // _temporarilyDisableShapesOutOfDynamicActivityRange disabled a tree in this step
+    std::vector<std::vector<int> > _shapesTaggedByObject; // indexed by object ID (joints, force sensors and dummies)
+    std::vector<int> _shapeTagCounts; // indexed by shape ID
+    unsigned int _syncGeneration;
+
+    // Following used to write rigid body poses and velocities back to the scene, from base to tip:
+    std::vector<CRigidBodyDyn*> _writeBackBodies; // sorted by tree depth of their shape
+    std::vector<int> _writeBackHierarchy; // object ID and parent object ID (-1 if none) of each object on the parent chains of the shapes above, at the time of the sorting
+    bool _writeBackOrderIsDirty;
+    std::vector<int> _writeBackShapeIDs; // shape IDs of _writeBackBodies, to find the shapes that lost their rigid body
+    bool _nonBodyShapeVelocitiesZeroed; // the velocities of the shapes without rigid body were zeroed once
+
+    // Following used to move the kinematic bodies along their shapes:
+    std::vector<CRigidBodyDyn*> _kinematicBodies; // all kinematic bodies
+    std::vector<CRigidBodyDyn*> _movedKinematicBodies; // the kinematic bodies that move in the current step
+    std::vector<CDummyShape*> _movedKinematicShapes; // and their shapes
+    bool _kinematicBodiesAreDirty; // bodies were added/removed
+
+    // Following used to handle the joint motors in each sub-pass:
+    std::vector<SMotorScheduleEntry> _motorSchedule; // higher priority joints first, scene order within a same call order group
+    std::vector<int> _motorBatch; // schedule indices of the motors that need no joint control callback in the current pass
+    bool _motorScheduleIsDirty;
+
+    // Following used for the visualization flags:
+    std::vector<void*> _visualizationFlagObjects; // shapes, joints, force sensors and dummies that have a body or constraint
+    std::vector<int> _visualizationFlagObjectIDs;
+    std::vector<int> _visualizationFlagValues;
+    std::vector<int> _visualizationFlagsSet; // indexed by object ID, -1 if not yet set. dyn_visflags_onchange only
+    std::vector<int> _visualizationFlagChanges; // IDs of the objects whose flag might have changed since the last step. dyn_visflags_onchange only
+
     // Following 2 updated when handleDynamics is called:
     float _timeStepPassedToHandleDynamicsFunction;
     int _dynamicsCalculationPasses;
 
     std::vector<float> _contactPoints;
-    std::vector<SContactInfo> _contactInfo; // Not same as above!
-
-    static float _positionScalingFactorDyn;
-    static float _linearVelocityScalingFactorDyn;
-    static float _massScalingFactorDyn;
-    static float _masslessInertiaScalingFactorDyn;
-    static float _forceScalingFactorDyn;
-    static float _torqueScalingFactorDyn;
-    static float _gravityScalingFactorDyn;
-    static float _dynamicActivityRange;
-    static float _dynamicsInternalStepSize;
-    static int _dynamicParticlesIdStart;
-    static int _3dObjectIdStart;
-    static int _3dObjectIdEnd;
+    CContactArena _contacts; // Not same as above!
+
+    // Following used by startDynamics/finishDynamics:
+    float _stepSimulationTime;
+    bool _stepHasDynamicContent;
+    bool _stepPending; // startDynamics was called, finishDynamics not yet
+    bool _stepIsAsynchronous; // the scene is then only written to in finishDynamics, see _finishPass
+    bool _asyncStepRunning; // the last engine step runs on _asyncStepThread. Readers then use the snapshots below
+    std::thread _asyncStepThread;
+    float _asyncStepTime; // in ms, measured by the worker, added to the profiler once joined
+    std::vector<float> _contactPointsSnapshot; // results of the previous step
+    CContactArena _contactsSnapshot;
+
+    // Following used by the adaptive sub-stepping:
+    float _stepMaxPenetration; // unscaled. Engines that know the depth of their contacts update it while stepping
+    float _stepMeasures[3]; // penetration depth, constraint error and body velocity of the last step
+    int _stepMeasuresExceeded; // dyn_substepreason_* bits of the last step
+    int _adaptivePasses; // passes to use for the next step, 0 if not yet known
+    int _adaptiveCalmSteps; // consecutive steps well below the thresholds
+
+    std::vector<int> _previousContactPairs; // object IDs, 2 per contact of the previous step. Used in sleep mode only
+    std::vector<SCollisionFilter> _collisionFilters; // indexed by object ID, filled on first use in a step
+    unsigned int _collisionFilterGeneration;
+    std::unordered_map<unsigned long long,SContactMaterial> _contactMaterials; // keyed by the IDs of the two sides
+    std::atomic<bool> _customContactHandled; // the simulator was asked about a colliding pair in this or the previous step (its contact callbacks could read the scene)
+    bool _customContactHandledInStep;
+    SContactBatch _contactBatch; // reused from pass to pass
+
+    // Following are the settings of this world (see SDynWorldSettings):
+    float _positionScalingFactorDyn;
+    float _linearVelocityScalingFactorDyn;
+    float _massScalingFactorDyn;
+    float _masslessInertiaScalingFactorDyn;
+    float _forceScalingFactorDyn;
+    float _torqueScalingFactorDyn;
+    float _gravityScalingFactorDyn;
+    float _dynamicActivityRange;
+    float _dynamicsInternalStepSize;
+    int _dynamicParticlesIdStart;
+    int _3dObjectIdStart;
+    int _3dObjectIdEnd;
+    int _worldSyncMode;
+    int _writeBackMode;
+    bool _intermediateWriteBackNeeded;
+    int _subStepMode;
+    float _adaptiveSubStepThresholds[3]; // penetration depth, constraint error, body velocity (m, m, m/s)
+    int _adaptiveSubStepMaxPassFactor;
+    int _visualizationFlagMode;
+    int _sleepMode; // applies to bodies created afterwards
+    float _sleepParams[3]; // linear velocity threshold, angular velocity threshold, time to sleep (m/s, rad/s, s)
+    int _particleEngine; // applies to particle objects created afterwards
+    dynContactBatchCallback _contactBatchCallback; // replaces the simulator's contact handling when not nullptr
 };
@@ -5,6 +5,7 @@
 
 CRigidBodyDyn::CRigidBodyDyn()
 {
+    _sleepWrittenBack=false;
 }
 
 CRigidBodyDyn::~CRigidBodyDyn()
@@ -43,6 +44,48 @@ void CRigidBodyDyn::applyCorrectEndConfig_forKinematicBody()
 {
 }
 
+bool CRigidBodyDyn::getState(SRigidBodyState& state)
+{ // returns false if the engine doesn't support state snapshots
+    return(false);
+}
+
+void CRigidBodyDyn::setState(const SRigidBodyState& state)
+{
+}
+
+bool CRigidBodyDyn::isSleeping()
+{ // kinematic bodies never sleep
+    return(false);
+}
+
+void CRigidBodyDyn::wakeUp()
+{
+}
+
+C3Vector CRigidBodyDyn::getVelocityAtPosition(const C3Vector& position)
+{ // not scaled. Velocity of the body point at the given absolute position
+    return(C3Vector(0.0f,0.0f,0.0f));
+}
+
+void CRigidBodyDyn::addForceAtPosition(const C3Vector& force,const C3Vector& position)
+{ // not scaled. The force is applied during the next engine step only
+}
+
+bool CRigidBodyDyn::isKinematicBodyMoving()
+{ // valid after calculateBodyToShapeTransformation_forKinematicBody
+    return(_bodyIsKinematic&&_applyBodyToShapeTransf_kinematicBody);
+}
+
+bool CRigidBodyDyn::getSleepWrittenBack()
+{
+    return(_sleepWrittenBack);
+}
+
+void CRigidBodyDyn::setSleepWrittenBack(bool written)
+{
+    _sleepWrittenBack=written;
+}
+
 
 void CRigidBodyDyn::setDefaultActivationState(int defState)
 {
@@ -4,6 +4,15 @@
 #include "CollShapeDyn.h"
 #include "7Vector.h"
 
+struct SRigidBodyState
+{ // engine units (i.e. scaled), as used by saveState/restoreState
+    dynReal position[3];
+    dynReal quaternion[4]; // in the engine's order
+    dynReal linearVelocity[3];
+    dynReal angularVelocity[3];
+    int activationState; // engine specific (enabled, sleeping, etc.)
+};
+
 class CRigidBodyDyn  
 {
 public:
@@ -16,6 +25,12 @@ public:
     virtual void handleAdditionalForcesAndTorques(CDummyShape* shape);
     virtual void reportShapeConfigurationToRigidBody_forKinematicBody(CDummyShape* shape,float t,float cumulatedTimeStep);
     virtual void applyCorrectEndConfig_forKinematicBody();
+    virtual bool getState(SRigidBodyState& state);
+    virtual void setState(const SRigidBodyState& state);
+    virtual bool isSleeping();
+    virtual void wakeUp();
+    virtual C3Vector getVelocityAtPosition(const C3Vector& position);
+    virtual void addForceAtPosition(const C3Vector& force,const C3Vector& position);
 
     int getRigidBodyID();
     void setRigidBodyID(int newID);
@@ -26,6 +41,9 @@ public:
     void reportConfigurationToShape(CDummyShape* shape);
     void setDefaultActivationState(int defState);
     void calculateBodyToShapeTransformation_forKinematicBody(CDummyShape* shape,float dt);
+    bool isKinematicBodyMoving();
+    bool getSleepWrittenBack();
+    void setSleepWrittenBack(bool written);
 
 protected:    
     int _rigidBodyID;
@@ -43,4 +61,5 @@ protected:
     bool _applyBodyToShapeTransf_kinematicBody;
 
     bool _bodyIsKinematic;
+    bool _sleepWrittenBack; // the scene has the final pose of this sleeping body
 };
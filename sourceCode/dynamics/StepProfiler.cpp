@@ -0,0 +1,80 @@
+#include "StepProfiler.h"
+
+#ifdef DYN_PROFILING
+
+CStepProfiler::CScopedPhase::CScopedPhase(CStepProfiler* profiler,int phase,float* deferredTime)
+{
+    _profiler=profiler;
+    _phase=phase;
+    _deferredTime=deferredTime;
+    _start=std::chrono::steady_clock::now();
+}
+
+CStepProfiler::CScopedPhase::~CScopedPhase()
+{
+    std::chrono::duration<float,std::milli> d=std::chrono::steady_clock::now()-_start;
+    if (_deferredTime!=nullptr)
+        _deferredTime[0]=d.count();
+    else
+        _profiler->addPhaseTime(_phase,d.count());
+}
+
+CStepProfiler::CStepProfiler() : _filteredPairs(0)
+{
+    _current=0;
+    _stepCount=0;
+}
+
+void CStepProfiler::beginStep()
+{
+    _current=_stepCount%DYN_PROFILING_STEPS;
+    for (int i=0;i<dyn_profphase_count;i++)
+        _phaseTimes[_current][i]=0.0f;
+    for (int i=0;i<dyn_profcounter_count;i++)
+        _counters[_current][i]=0;
+    _filteredPairs.store(0,std::memory_order_relaxed);
+    _stepStart=std::chrono::steady_clock::now();
+}
+
+void CStepProfiler::endStep()
+{
+    std::chrono::duration<float,std::milli> d=std::chrono::steady_clock::now()-_stepStart;
+    _phaseTimes[_current][dyn_profphase_total]=d.count();
+    _counters[_current][dyn_profcounter_filteredpairs]=_filteredPairs.load(std::memory_order_relaxed);
+    _stepCount++;
+}
+
+void CStepProfiler::addPhaseTime(int phase,float ms)
+{
+    _phaseTimes[_current][phase]+=ms;
+}
+
+void CStepProfiler::setCounter(int counter,int value)
+{
+    _counters[_current][counter]=value;
+}
+
+void CStepProfiler::countFilteredPair()
+{
+    _filteredPairs.fetch_add(1,std::memory_order_relaxed);
+}
+
+int CStepProfiler::getData(int maxSteps,float* phaseTimes,int* counters)
+{ // copies the last maxSteps completed steps, oldest first. Returns the number of steps copied
+    int cnt=_stepCount;
+    if (cnt>DYN_PROFILING_STEPS)
+        cnt=DYN_PROFILING_STEPS;
+    if (cnt>maxSteps)
+        cnt=maxSteps;
+    for (int i=0;i<cnt;i++)
+    {
+        int slot=(_stepCount-cnt+i)%DYN_PROFILING_STEPS;
+        for (int j=0;j<dyn_profphase_count;j++)
+            phaseTimes[i*dyn_profphase_count+j]=_phaseTimes[slot][j];
+        for (int j=0;j<dyn_profcounter_count;j++)
+            counters[i*dyn_profcounter_count+j]=_counters[slot][j];
+    }
+    return(cnt);
+}
+
+#endif // DYN_PROFILING
@@ -0,0 +1,90 @@
+#pragma once
+
+enum { // profiled phases of a simulation step. Times are summed over all sub-passes
+    dyn_profphase_worldupdate=0,
+    dyn_profphase_gravity,
+    dyn_profphase_kinematicinterpolation,
+    dyn_profphase_motorcontrol,
+    dyn_profphase_additionalforces,
+    dyn_profphase_particles, // anti-gravity and fluid friction forces of particles, and the dyn_particleengine_soa particle step
+    dyn_profphase_stepdynamics,
+    dyn_profphase_contactextraction,
+    dyn_profphase_writeback,
+    dyn_profphase_visualizationflags,
+    dyn_profphase_total,
+    dyn_profphase_count
+};
+
+enum { // profiled counters of a simulation step
+    dyn_profcounter_bodies=0,
+    dyn_profcounter_constraints,
+    dyn_profcounter_collisionshapes, // with dyn_profphase_worldupdate of the first step: how the world build time scales with the scene size
+    dyn_profcounter_contacts,
+    dyn_profcounter_filteredpairs, // candidate pairs that went through the engine's pair filtering callback
+    dyn_profcounter_subpasses,
+    dyn_profcounter_substepreasons, // adaptive sub-stepping: dyn_substepreason_* bits of the measures that exceeded their threshold
+    dyn_profcounter_fluidparticles, // particles that went through the anti-gravity/fluid friction force pass, in the last sub-pass
+    dyn_profcounter_count
+};
+
+#ifdef DYN_PROFILING
+
+#include <chrono>
+#include <atomic>
+
+#define DYN_PROFILING_STEPS 256 // size of the ring buffer
+
+// Following are used in the member functions of CRigidBodyContainerDyn, that owns the profiler:
+#define DYN_PROFILE_BEGIN_STEP() profiler.beginStep()
+#define DYN_PROFILE_END_STEP() profiler.endStep()
+#define DYN_PROFILE_PHASE(phase) CStepProfiler::CScopedPhase _dynProfiledPhase(&profiler,phase)
+#define DYN_PROFILE_PHASE_DEFERRED(ms) CStepProfiler::CScopedPhase _dynProfiledPhase(nullptr,-1,&(ms)) // measures into ms, for threads other than the stepping one
+#define DYN_PROFILE_ADD_PHASE_TIME(phase,ms) profiler.addPhaseTime(phase,ms)
+#define DYN_PROFILE_SET_COUNTER(counter,value) profiler.setCounter(counter,value)
+#define DYN_PROFILE_FILTERED_PAIR(container) (container)->profiler.countFilteredPair()
+
+class CStepProfiler
+{ // keeps the phase times and counters of the last DYN_PROFILING_STEPS simulation steps of a world
+public:
+    class CScopedPhase
+    {
+    public:
+        CScopedPhase(CStepProfiler* profiler,int phase,float* deferredTime=nullptr);
+        ~CScopedPhase();
+
+    private:
+        CStepProfiler* _profiler;
+        int _phase;
+        float* _deferredTime; // if not nullptr, the time goes there instead of into the current step
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    CStepProfiler();
+
+    void beginStep();
+    void endStep();
+    void addPhaseTime(int phase,float ms);
+    void setCounter(int counter,int value);
+    void countFilteredPair();
+    int getData(int maxSteps,float* phaseTimes,int* counters);
+
+private:
+    float _phaseTimes[DYN_PROFILING_STEPS][dyn_profphase_count]; // in ms
+    int _counters[DYN_PROFILING_STEPS][dyn_profcounter_count];
+    std::atomic<int> _filteredPairs; // pair filtering can run on several threads (e.g. Newton)
+    std::chrono::steady_clock::time_point _stepStart;
+    int _current; // ring buffer slot of the step in progress
+    int _stepCount; // completed steps
+};
+
+#else
+
+#define DYN_PROFILE_BEGIN_STEP() ((void)0)
+#define DYN_PROFILE_END_STEP() ((void)0)
+#define DYN_PROFILE_PHASE(phase) ((void)0)
+#define DYN_PROFILE_PHASE_DEFERRED(ms) ((void)0)
+#define DYN_PROFILE_ADD_PHASE_TIME(phase,ms) ((void)0)
+#define DYN_PROFILE_SET_COUNTER(counter,value) ((void)0)
+#define DYN_PROFILE_FILTERED_PAIR(container) ((void)0)
+
+#endif // DYN_PROFILING
@@ -78,8 +78,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((parentRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            parentRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     batr=parentBody->getInertiaFrameTransformation();
     jtrRelToBodyA=batr.getInverse()*jtr;
@@ -87,8 +92,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((childRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        childRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            childRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            childRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     bbtr=childBody->getInertiaFrameTransformation();
     jtrRelToBodyB=bbtr.getInverse()*jtr2;
@@ -235,8 +245,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((parentRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            parentRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     batr=parentBody->getInertiaFrameTransformation();
     jtrRelToBodyA=batr.getInverse()*jtr;
@@ -244,8 +259,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((childRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        childRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            childRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            childRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     bbtr=childBody->getInertiaFrameTransformation();
     jtrRelToBodyB=bbtr.getInverse()*jtr2;
@@ -362,8 +382,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((parentRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            parentRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     batr=parentBody->getInertiaFrameTransformation();
     dtrRelToBodyA=batr.getInverse()*dtr;
@@ -371,8 +396,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((childRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        childRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            childRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            childRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     bbtr=childBody->getInertiaFrameTransformation();
     dtrRelToBodyB=bbtr.getInverse()*dtr2;
@@ -469,8 +499,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((parentRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            parentRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     batr=parentBody->getInertiaFrameTransformation();
     jtrRelToBodyA=batr.getInverse()*jtr;
@@ -478,8 +513,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((childRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        childRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            childRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            childRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     bbtr=childBody->getInertiaFrameTransformation();
     jtrRelToBodyB=bbtr.getInverse()*jtr2;
@@ -578,8 +618,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((parentRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            parentRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            parentRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            parentBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     batr=parentBody->getInertiaFrameTransformation();
     jtrRelToBodyA=batr.getInverse()*jtr;
@@ -587,8 +632,13 @@ CConstraintDyn_bullet278::CConstraintDyn_bullet278(CRigidBodyDyn* parentBody,CRi
 
     if ((childRigidBody->getCollisionFlags()&(btCollisionObject::CF_KINEMATIC_OBJECT|btCollisionObject::CF_STATIC_OBJECT))==0)
     { // this is a dynamic object
-        childRigidBody->setActivationState(DISABLE_DEACTIVATION);
-        childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            childRigidBody->activate(true); // the island can sleep as a whole
+        else
+        {
+            childRigidBody->setActivationState(DISABLE_DEACTIVATION);
+            childBody->setDefaultActivationState(DISABLE_DEACTIVATION);
+        }
     }
     bbtr=childBody->getInertiaFrameTransformation();
     jtrRelToBodyB=bbtr.getInverse()*jtr2;
@@ -652,48 +702,22 @@ void CConstraintDyn_bullet278::_setPrismaticJointLimits(CDummyJoint* joint)
     slider->setUpperLinLimit((jiMin+jiRange)*linScaling); // ********** SCALING
 }
 
-void CConstraintDyn_bullet278::_handleRevoluteMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_bullet278::_getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
+{
+    if (_simGetJointPositionInterval(joint,nullptr,nullptr)==0)
+        error=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset,getHingeAngle()); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
+    else
+        error=_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset-getHingeAngle(); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
+    position=getHingeAngle()-_nonCyclicRevoluteJointPositionOffset;
+}
+
+void CConstraintDyn_bullet278::_applyRevoluteMotorController(float velocity,float force)
 {
     float torqueScaling=CRigidBodyContainerDyn::getTorqueScalingFactorDyn();
     float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
-
     btHingeConstraint* hinge;
     hinge=(btHingeConstraint*)_constraint;
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-
-    float e;
-
-    if (_simGetJointPositionInterval(joint,nullptr,nullptr)==0)
-        e=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset,getHingeAngle()); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
-    else
-        e=_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset-getHingeAngle(); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-
-    inputValuesFloat[0]=getHingeAngle()-_nonCyclicRevoluteJointPositionOffset;
-
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
-    hinge->enableAngularMotor(true,velocityToApply,forceToApply*torqueScaling*dynStepSize); // ********** SCALING
+    hinge->enableAngularMotor(true,velocity,force*torqueScaling*dynStepSize); // ********** SCALING
 }
 
 
@@ -727,44 +751,23 @@ void CConstraintDyn_bullet278::_handleRevoluteMotor_controllerDisabled(CDummyJoi
     }
 }
 
-void CConstraintDyn_bullet278::_handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_bullet278::_getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
 {
     float linScaling=CRigidBodyContainerDyn::getPositionScalingFactorDyn();
+    error=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled()/linScaling; // ********** SCALING
+    position=getSliderPositionScaled()/linScaling; // Scaling was forgotten and added on 22/8/2013, thanks to Ruediger Dehmel.
+}
+
+void CConstraintDyn_bullet278::_applyPrismaticMotorController(float velocity,float force)
+{
     float linVelocityScaling=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn();
     float forceScaling=CRigidBodyContainerDyn::getForceScalingFactorDyn();
     float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
-
     btSliderConstraint* slider;
     slider=(btSliderConstraint*)_constraint;
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-    float e=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled()/linScaling; // ********** SCALING
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-    inputValuesFloat[0]=getSliderPositionScaled()/linScaling; // Scaling was forgotten and added on 22/8/2013, thanks to Ruediger Dehmel.
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
     slider->setPoweredLinMotor(true);
-    slider->setTargetLinMotorVelocity(velocityToApply*linVelocityScaling); // ********** SCALING
-    slider->setMaxLinMotorForce(forceToApply*forceScaling*dynStepSize*dynStepSize); // ********** SCALING
+    slider->setTargetLinMotorVelocity(velocity*linVelocityScaling); // ********** SCALING
+    slider->setMaxLinMotorForce(force*forceScaling*dynStepSize*dynStepSize); // ********** SCALING
 }
 
 void CConstraintDyn_bullet278::_handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses)
@@ -31,10 +31,12 @@ public:
     dynReal getHingeAngle();
 
 protected:
-    void _handleRevoluteMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses);
+    void _getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error);
+    void _applyRevoluteMotorController(float velocity,float force);
     void _handleRevoluteMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses);
 
-    void _handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses);
+    void _getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error);
+    void _applyPrismaticMotorController(float velocity,float force);
     void _handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses);
 
     void _setRevoluteJointLimits(CDummyJoint* joint);
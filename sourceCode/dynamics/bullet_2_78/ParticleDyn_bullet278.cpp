@@ -24,7 +24,17 @@ bool CParticleDyn_bullet278::addToEngineIfNeeded(float parameters[18],int object
     float masslessInertiaScaling=CRigidBodyContainerDyn::getMasslessInertiaScalingFactorDyn();
     float velScaling=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn();
 
-    _collShape=new btSphereShape(_size*linScaling/2.0f); // ********** SCALING
+    btCollisionShape* shape;
+    if (_objectType&sim_particle_itemsizes)
+    { // particles of this object have different sizes
+        _collShape=new btSphereShape(_size*linScaling/2.0f); // ********** SCALING
+        shape=_collShape;
+    }
+    else
+    {
+        _collShape=nullptr;
+        shape=rbc->getParticleShape(_size*linScaling/2.0f); // ********** SCALING
+    }
 
     float mass=_massOverVolume*(4.0f*piValue*(_size*0.5f)*(_size*0.5f)*(_size*0.5f)/3.0f)*massScaling; // ********** SCALING
 
@@ -38,9 +48,29 @@ bool CParticleDyn_bullet278::addToEngineIfNeeded(float parameters[18],int object
 
     C4Vector q;
     q.setIdentity();
-    btDefaultMotionState* myMotionState = new btDefaultMotionState(btTransform(btQuaternion(q(1),q(2),q(3),q(0)),btVector3(_currentPosition(0)*linScaling,_currentPosition(1)*linScaling,_currentPosition(2)*linScaling))); // ********** SCALING
-    btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,myMotionState,_collShape,localInertia);
-    _rigidBody = new btRigidBody(rbInfo);
+    btTransform tr(btQuaternion(q(1),q(2),q(3),q(0)),btVector3(_currentPosition(0)*linScaling,_currentPosition(1)*linScaling,_currentPosition(2)*linScaling)); // ********** SCALING
+    // No motion state: the world is stepped with a fixed time step equal to the pass time step, Bullet never interpolates
+    _rigidBody=rbc->takePooledParticleBody();
+    if (_rigidBody==nullptr)
+    {
+        btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,nullptr,shape,localInertia);
+        rbInfo.m_startWorldTransform=tr;
+        _rigidBody = new btRigidBody(rbInfo);
+    }
+    else
+    { // reset what the previous particle left behind
+        _rigidBody->setCollisionShape(shape);
+        _rigidBody->setWorldTransform(tr);
+        _rigidBody->setInterpolationWorldTransform(tr);
+        _rigidBody->setMassProps(mass,localInertia);
+        _rigidBody->updateInertiaTensor();
+        _rigidBody->setAngularVelocity(btVector3(0,0,0));
+        _rigidBody->setInterpolationAngularVelocity(btVector3(0,0,0));
+        _rigidBody->clearForces();
+        _rigidBody->setCollisionFlags(_rigidBody->getCollisionFlags()&(~btCollisionObject::CF_NO_CONTACT_RESPONSE));
+        _rigidBody->forceActivationState(ACTIVE_TAG);
+        _rigidBody->setDeactivationTime(0.0f);
+    }
 
     _rigidBody->setUserPointer((void*)(CRigidBodyContainerDyn::getDynamicParticlesIdStart()+objectID)); // CRigidBodyContainerDyn::getDynamicParticlesIdStart() is the offset so we don't mix-up with regular shapes
 
@@ -55,75 +85,20 @@ bool CParticleDyn_bullet278::addToEngineIfNeeded(float parameters[18],int object
     return(true);
 }
 
-void CParticleDyn_bullet278::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
-{
-    bool isWaterButInAir=false;
-    if ( (_objectType&sim_particle_ignoresgravity)||(_objectType&sim_particle_water) )
-    {
-        float mass=_massOverVolume*((piValue*_size*_size*_size)/6.0f)*CRigidBodyContainerDyn::getMassScalingFactorDyn(); // ********** SCALING
-        C3Vector f=gravity*-mass*CRigidBodyContainerDyn::getGravityScalingFactorDyn(); // ********** SCALING
-        bool reallyIgnoreGravity=true;
-        if (_objectType&sim_particle_water)
-        { // We ignore gravity only if we are in the water (z<0) (New since 27/6/2011):
-            float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
-            if (_rigidBody->getWorldTransform().getOrigin().getZ()/ps>=0.0f) // ********** SCALING (not really needed here!)
-            {
-                reallyIgnoreGravity=false;
-                isWaterButInAir=true;
-            }
-        }
-
-        if (reallyIgnoreGravity)
-        {
-
-            btVector3 ff;
-            ff.setX(f(0));
-            ff.setY(f(1));
-            ff.setZ(f(2));
-            _rigidBody->applyCentralForce(ff);
-        }
-    }
-    if ((linearFluidFrictionCoeff!=0.0f)||(quadraticFluidFrictionCoeff!=0.0f)||(linearAirFrictionCoeff!=0.0f)||(quadraticAirFrictionCoeff!=0.0f))
-    { // New since 27/6/2011
-        float lfc=linearFluidFrictionCoeff;
-        float qfc=quadraticFluidFrictionCoeff;
-        if (isWaterButInAir)
-        {
-            lfc=linearAirFrictionCoeff;
-            qfc=quadraticAirFrictionCoeff;
-        }
-        C3Vector vVect;
-
-        btVector3 btlv(_rigidBody->getLinearVelocity());
-        vVect.set(btlv.getX(),btlv.getY(),btlv.getZ());
-
-        float v=vVect.getLength();
-        if (v!=0.0f)
-        {
-            float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
-            float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
-            v/=vs; // ********** SCALING
-            C3Vector nv(vVect.getNormalized()*-1.0f);
-            C3Vector f(nv*(v*lfc+v*v*qfc));
-            f*=fs; // ********** SCALING
-
-            btVector3 ff(f(0),f(1),f(2));
-            _rigidBody->applyCentralForce(ff);
-        }
-    }
+void CParticleDyn_bullet278::applyFluidForce(const C3Vector& force)
+{ // scaled
+    btVector3 ff(force(0),force(1),force(2));
+    _rigidBody->applyCentralForce(ff);
 }
 
 void CParticleDyn_bullet278::removeFromEngine()
 {
     if (_initializationState==1)
     {
-        delete _collShape;
         CRigidBodyContainerDyn_bullet278* rbc=(CRigidBodyContainerDyn_bullet278*)(CRigidBodyContainerDyn::currentRigidBodyContainerDynObject);
         rbc->getWorld()->removeCollisionObject(_rigidBody);
-
-        if (_rigidBody->getMotionState()!=nullptr)
-            delete _rigidBody->getMotionState();
-        delete _rigidBody;
+        rbc->poolParticleBody(_rigidBody);
+        delete _collShape; // only set if not shared
         _initializationState=2;
     }
 }
@@ -146,3 +121,12 @@ void CParticleDyn_bullet278::updatePosition()
         _currentPosition(2)=wtx.getZ()/linScaling; // ********** SCALING
     }
 }
+
+C3Vector CParticleDyn_bullet278::getVelocity()
+{
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
+    btVector3 btlv(_rigidBody->getLinearVelocity());
+    return(C3Vector(btlv.getX()/vs,btlv.getY()/vs,btlv.getZ()/vs));
+}
@@ -10,9 +10,10 @@ public:
     virtual ~CParticleDyn_bullet278();
 
     bool addToEngineIfNeeded(float parameters[18],int objectID);
-    void handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff);
+    void applyFluidForce(const C3Vector& force);
     void updatePosition();
     void removeFromEngine();
+    C3Vector getVelocity();
 
 protected:    
     btRigidBody* _rigidBody;
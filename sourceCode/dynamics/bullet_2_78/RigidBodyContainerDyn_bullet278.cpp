@@ -2,6 +2,7 @@
 #include "CollShapeDyn_bullet278.h"
 #include "RigidBodyDyn_bullet278.h"
 #include "ConstraintDyn_bullet278.h"
+#include "StepProfiler.h"
 #include "simLib.h"
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 
@@ -26,11 +27,7 @@
 // btInternalEdgeUtility.h:                        BULLET_MOD_7A_MODIFIED_BY_MARC
 // btInternalEdgeUtility.cpp:                    BULLET_MOD_7B_MODIFIED_BY_MARC
 
-bool CRigidBodyContainerDyn_bullet278::_bulletContactCallback_useCustom;
-float CRigidBodyContainerDyn_bullet278::_bulletContactCallback_combinedFriction;
-float CRigidBodyContainerDyn_bullet278::_bulletContactCallback_combinedRestitution;
-
-CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
+CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278(const SDynWorldSettings& settings) : CRigidBodyContainerDyn(settings)
 {
     _dynamicsCalculationPasses=0;
     _allRigidBodiesIndex.resize(CRigidBodyContainerDyn::get3dObjectIdEnd()-CRigidBodyContainerDyn::get3dObjectIdStart(),nullptr);
@@ -44,6 +41,13 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
     _dynamicsWorld=new btDiscreteDynamicsWorld(_dispatcher,_broadphase,_solver,_collisionConfiguration);
     _dynamicsWorld->getSolverInfo().m_numIterations=simGetEngineInt32Parameter(sim_bullet_global_constraintsolvingiterations,-1,nullptr,nullptr);
     _dynamicsWorld->getSolverInfo().m_solverMode=SOLVER_SIMD+SOLVER_USE_WARMSTARTING+SOLVER_RANDMIZE_ORDER;//+SOLVER_USE_2_FRICTION_DIRECTIONS; // new since 2010/04/04, to obtain better non-slipping contacts
+    gDeactivationTime=btScalar(2.0); // Bullet's default. Unconstrained bodies sleep even when the sleep mode is off
+    if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+    {
+        float sleepParams[3];
+        CRigidBodyContainerDyn::getSleepParams(sleepParams);
+        gDeactivationTime=sleepParams[2];
+    }
     //register algorithm
     btCollisionDispatcher * dispatcher = static_cast<btCollisionDispatcher *>(_dynamicsWorld->getDispatcher());
     btGImpactCollisionAlgorithm::registerAlgorithm(dispatcher);
@@ -51,6 +55,7 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
     {
         virtual ~_myCollisionCallback()
         {}
+        CRigidBodyContainerDyn_bullet278* container; // the engine calls us without context
         // return true when pairs need collision
         virtual bool needBroadphaseCollision(btBroadphaseProxy* childProxy0,btBroadphaseProxy* childProxy1) const
         {
@@ -62,21 +67,22 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
 
             if (collides)
             {
+                DYN_PROFILE_FILTERED_PAIR(container);
                 int objID1;
                 int objID2;
                 btRigidBody* a=(btRigidBody*)multiProxy0->m_clientObject;
                 btRigidBody* b=(btRigidBody*)multiProxy1->m_clientObject;
                 int dataA=(unsigned long long)a->getUserPointer();
                 int dataB=(unsigned long long)b->getUserPointer();
-                CDummyShape* shapeA=(CDummyShape*)_simGetObject(dataA);
-                CDummyShape* shapeB=(CDummyShape*)_simGetObject(dataB);
+                const SCollisionFilter* filterA=container->getCollisionFilter(dataA);
+                const SCollisionFilter* filterB=container->getCollisionFilter(dataB);
                 bool canCollide=false;
-                if ( (shapeA==nullptr)||(shapeB==nullptr) )
+                if ( (filterA==nullptr)||(filterB==nullptr) )
                 { // particle-shape or particle-particle case:
-                    if ( (shapeA==nullptr)&&(shapeB==nullptr) )
+                    if ( (filterA==nullptr)&&(filterB==nullptr) )
                     { // particle-particle case:
-                        CParticleObject* pa=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
-                        CParticleObject* pb=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                        CParticleObject* pa=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                        CParticleObject* pb=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                         objID1=dataA;
                         objID2=dataB;
                         if ( (pa!=nullptr)&&(pb!=nullptr) ) // added this condition on 08/02/2011 because of some crashes when scaling some models
@@ -87,15 +93,15 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
                     else
                     { // particle-shape case:
                         unsigned int collFA=0;
-                        if (shapeA!=nullptr)
+                        if (filterA!=nullptr)
                         {
-                            collFA=_simGetDynamicCollisionMask(shapeA);
-                            canCollide=_simIsShapeDynamicallyRespondable(shapeA)!=0;
-                            objID1=_simGetObjectID(shapeA);
+                            collFA=filterA->collisionMask;
+                            canCollide=(filterA->flags&dyn_collfilter_respondable)!=0;
+                            objID1=dataA;
                         }
                         else
                         {
-                            CParticleObject* po=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                            CParticleObject* po=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                             if (po!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                                 collFA=po->getShapeRespondableMask();
                             else
@@ -103,15 +109,15 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
                             objID1=dataA;
                         }
                         unsigned int collFB=0;
-                        if (shapeB!=nullptr)
+                        if (filterB!=nullptr)
                         {
-                            collFB=_simGetDynamicCollisionMask(shapeB);
-                            canCollide=_simIsShapeDynamicallyRespondable(shapeB)!=0;
-                            objID2=_simGetObjectID(shapeB);
+                            collFB=filterB->collisionMask;
+                            canCollide=(filterB->flags&dyn_collfilter_respondable)!=0;
+                            objID2=dataB;
                         }
                         else
                         {
-                            CParticleObject* po=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                            CParticleObject* po=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                             if (po!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                                 collFB=po->getShapeRespondableMask();
                             else
@@ -123,30 +129,28 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
                 }
                 else
                 { // regular case (shape-shape)
-                    unsigned int collFA=_simGetDynamicCollisionMask(shapeA);
-                    unsigned int collFB=_simGetDynamicCollisionMask(shapeB);
-                    canCollide=(_simIsShapeDynamicallyRespondable(shapeA)&&_simIsShapeDynamicallyRespondable(shapeB));
-                    CDummy3DObject* lastPA=(CDummy3DObject*)_simGetLastParentForLocalGlobalCollidable(shapeA);
-                    CDummy3DObject* lastPB=(CDummy3DObject*)_simGetLastParentForLocalGlobalCollidable(shapeB);
-                    if (lastPA==lastPB)
+                    unsigned int collFA=filterA->collisionMask;
+                    unsigned int collFB=filterB->collisionMask;
+                    canCollide=((filterA->flags&filterB->flags&dyn_collfilter_respondable)!=0);
+                    if (filterA->localGlobalCollidableRoot==filterB->localGlobalCollidableRoot)
                         canCollide=(canCollide&&(collFA&collFB&0x00ff)); // we are local
                     else
                         canCollide=(canCollide&&(collFA&collFB&0xff00)); // we are global
-                    objID1=_simGetObjectID(shapeA);
-                    objID2=_simGetObjectID(shapeB);
+                    objID1=dataA;
+                    objID2=dataB;
                 }
                 if (canCollide)
                 {
                     int dataInt[3]={0,0,0};
                     float dataFloat[14]={1.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f};
 
-                    int customHandleRes=_simHandleCustomContact(objID1,objID2,sim_physics_bullet,dataInt,dataFloat);
+                    int customHandleRes=container->_handleCustomContact(objID1,objID2,sim_physics_bullet,dataInt,dataFloat);
                     bool canReallyCollide=(customHandleRes!=0);
                     if (customHandleRes>0)
                     {
-                        _bulletContactCallback_useCustom=true;
-                        _bulletContactCallback_combinedFriction=dataFloat[0];
-                        _bulletContactCallback_combinedRestitution=dataFloat[1];
+                        container->_bulletContactCallback_useCustom=true;
+                        container->_bulletContactCallback_combinedFriction=dataFloat[0];
+                        container->_bulletContactCallback_combinedRestitution=dataFloat[1];
                     }
 
                     /*
@@ -183,7 +187,10 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
             return(false);
         }
     };
-    _filterCallback = new _myCollisionCallback();
+    _myCollisionCallback* filterCallback=new _myCollisionCallback();
+    filterCallback->container=this;
+    _filterCallback=filterCallback;
+    _bulletContactCallback_useCustom=false;
     _dynamicsWorld->getBroadphase()->getOverlappingPairCache()->setOverlapFilterCallback(_filterCallback);
     gContactAddedCallback=_bulletContactCallback; // For Bullet's custom contact callback
 
@@ -194,6 +201,8 @@ CRigidBodyContainerDyn_bullet278::CRigidBodyContainerDyn_bullet278()
         _simSetGeomProxyDynamicsFullRefreshFlag((void*)_simGetGeomProxyFromShape(_simGetObjectFromIndex(sim_object_shape_type,i)),true);
 
     _nextRigidBodyID=0;
+    _sphereQueryObject=nullptr;
+    _sphereQueryShape=nullptr;
 }
 
 CRigidBodyContainerDyn_bullet278::~CRigidBodyContainerDyn_bullet278()
@@ -214,17 +223,46 @@ CRigidBodyContainerDyn_bullet278::~CRigidBodyContainerDyn_bullet278()
     delete _dispatcher;
     delete _collisionConfiguration;
     delete _filterCallback;
+    delete _sphereQueryObject;
+    delete _sphereQueryShape;
+    for (int i=0;i<int(_particleBodyPool.size());i++)
+        delete _particleBodyPool[i];
+    for (std::map<float,btSphereShape*>::iterator it=_particleShapes.begin();it!=_particleShapes.end();it++)
+        delete it->second;
 
     // Important to destroy it at the very end, otherwise we have memory leaks with bullet (b/c we first need to remove particles from the Bullet world!)
     particleCont.removeAllObjects();
 }
 
+btCollisionShape* CRigidBodyContainerDyn_bullet278::getParticleShape(float radius)
+{ // scaled. The shape is shared and destroyed together with the world
+    btSphereShape*& shape=_particleShapes[radius];
+    if (shape==nullptr)
+        shape=new btSphereShape(radius);
+    return(shape);
+}
+
+btRigidBody* CRigidBodyContainerDyn_bullet278::takePooledParticleBody()
+{ // returns nullptr if the pool is empty. The body keeps the properties of its previous particle
+    if (_particleBodyPool.size()==0)
+        return(nullptr);
+    btRigidBody* retVal=_particleBodyPool[_particleBodyPool.size()-1];
+    _particleBodyPool.pop_back();
+    return(retVal);
+}
+
+void CRigidBodyContainerDyn_bullet278::poolParticleBody(btRigidBody* body)
+{ // the body was removed from the world
+    _particleBodyPool.push_back(body);
+}
+
 bool CRigidBodyContainerDyn_bullet278::_bulletContactCallback(btManifoldPoint& cp,const btCollisionObject* colObj0,int partId0,int index0,const btCollisionObject* colObj1,int partId1,int index1)
-{
-    if (_bulletContactCallback_useCustom)
+{ // only called by the thread stepping the world, i.e. the current container is the right one
+    CRigidBodyContainerDyn_bullet278* container=(CRigidBodyContainerDyn_bullet278*)currentRigidBodyContainerDynObject;
+    if (container->_bulletContactCallback_useCustom)
     { // We want a custom handling of this contact!
-        cp.m_combinedFriction=_bulletContactCallback_combinedFriction;
-        cp.m_combinedRestitution=_bulletContactCallback_combinedRestitution;
+        cp.m_combinedFriction=container->_bulletContactCallback_combinedFriction;
+        cp.m_combinedRestitution=container->_bulletContactCallback_combinedRestitution;
         return(true);
     }
     return(false);
@@ -256,6 +294,66 @@ btDiscreteDynamicsWorld* CRigidBodyContainerDyn_bullet278::getWorld()
     return(_dynamicsWorld);
 }
 
+int CRigidBodyContainerDyn_bullet278::collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts)
+{
+    struct _sphereQueryCallback : public btCollisionWorld::ContactResultCallback
+    {
+        const btCollisionObject* sphere;
+        std::vector<SParticleShapeContact>* contacts;
+        virtual btScalar addSingleResult(btManifoldPoint& cp,const btCollisionObject* colObj0,int partId0,int index0,const btCollisionObject* colObj1,int partId1,int index1)
+        {
+            if (cp.getDistance()>=0.0f)
+                return(0.0f);
+            float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+            btVector3 n(cp.m_normalWorldOnB); // from B towards A
+            const btCollisionObject* other=colObj1;
+            if (colObj1==sphere)
+            {
+                other=colObj0;
+                n=-n;
+            }
+            btVector3 p(cp.getPositionWorldOnB());
+            SParticleShapeContact contact;
+            contact.position.set(p.getX()/ps,p.getY()/ps,p.getZ()/ps);
+            contact.normal.set(n.getX(),n.getY(),n.getZ());
+            contact.depth=-cp.getDistance()/ps;
+            contact.shapeID=(unsigned long long)other->getUserPointer();
+            contacts->push_back(contact);
+            return(0.0f);
+        }
+    };
+
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    if (_sphereQueryObject==nullptr)
+    {
+        _sphereQueryShape=new btSphereShape(radius*ps);
+        _sphereQueryObject=new btCollisionObject();
+        _sphereQueryObject->setCollisionShape(_sphereQueryShape);
+    }
+    else
+        _sphereQueryShape->setUnscaledRadius(radius*ps);
+    btTransform tr;
+    tr.setIdentity();
+    tr.setOrigin(btVector3(center(0)*ps,center(1)*ps,center(2)*ps));
+    _sphereQueryObject->setWorldTransform(tr);
+
+    _sphereQueryContacts.clear();
+    _sphereQueryCallback callback;
+    callback.sphere=_sphereQueryObject;
+    callback.contacts=&_sphereQueryContacts;
+    _dynamicsWorld->contactTest(_sphereQueryObject,callback);
+
+    int retVal=0;
+    for (int i=0;i<int(_sphereQueryContacts.size());i++)
+    {
+        if (retVal>=maxContacts)
+            break;
+        if (_canParticleCollideWithShape(_sphereQueryContacts[i].shapeID,respondableMask)) // particles that are engine bodies are also skipped here
+            contacts[retVal++]=_sphereQueryContacts[i];
+    }
+    return(retVal);
+}
+
 void CRigidBodyContainerDyn_bullet278::serializeDynamicContent(const std::string& filenameAndPath,int maxSerializeBufferSize)
 {
     if (_dynamicsWorld==nullptr) // probably not needed
@@ -316,11 +414,13 @@ void CRigidBodyContainerDyn_bullet278::addBulletContactPoints(int dynamicPassNum
             ci.directionAndAmplitude=d*force;
             ci.surfaceNormal=d;
             ci.subPassNumber=dynamicPassNumber;
-            _contactInfo.push_back(ci);
+            _contacts.addContact(ci);
 
             _contactPoints.push_back(avrg(0)/linScaling);
             _contactPoints.push_back(avrg(1)/linScaling);
             _contactPoints.push_back(avrg(2)/linScaling);
+            if (-pt.getDistance()/linScaling>_stepMaxPenetration)
+                _stepMaxPenetration=-pt.getDistance()/linScaling; // ********** SCALING
         }
     }
 }
@@ -330,3 +430,14 @@ void CRigidBodyContainerDyn_bullet278::_stepDynamics(float dt,int pass)
     _dynamicsWorld->stepSimulation(dt,10000,dt);
     addBulletContactPoints(pass);
 }
+
+void CRigidBodyContainerDyn_bullet278::_resetContactCaches()
+{ // drop the contact manifolds (warm starting) and restart the solver's random sequence
+    btCollisionObjectArray& objects=_dynamicsWorld->getCollisionObjectArray();
+    for (int i=0;i<objects.size();i++)
+    {
+        if (objects[i]->getBroadphaseHandle()!=nullptr)
+            _broadphase->getOverlappingPairCache()->cleanProxyFromPairs(objects[i]->getBroadphaseHandle(),_dispatcher);
+    }
+    _dynamicsWorld->getConstraintSolver()->reset();
+}
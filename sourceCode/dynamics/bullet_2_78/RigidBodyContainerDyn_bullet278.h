@@ -3,6 +3,7 @@
 #include "RigidBodyContainerDyn.h"
 #include "btBulletDynamicsCommon.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include <map>
 
 typedef bool (*ContactAddedCallback)(
     btManifoldPoint& cp,
@@ -16,7 +17,7 @@ typedef bool (*ContactAddedCallback)(
 class CRigidBodyContainerDyn_bullet278 : public CRigidBodyContainerDyn
 {
 public:
-    CRigidBodyContainerDyn_bullet278();
+    CRigidBodyContainerDyn_bullet278(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn_bullet278();
 
     int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
@@ -25,9 +26,14 @@ public:
 
     btDiscreteDynamicsWorld* getWorld();
     void addBulletContactPoints(int dynamicPassNumber);
+    int collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts);
+    btCollisionShape* getParticleShape(float radius);
+    btRigidBody* takePooledParticleBody();
+    void poolParticleBody(btRigidBody* body);
 
 protected:
     void _stepDynamics(float dt,int pass);
+    void _resetContactCaches();
     void _createDependenciesBetweenJoints();
     void _removeDependenciesBetweenJoints(CConstraintDyn* theInvolvedConstraint);
 
@@ -39,7 +45,12 @@ protected:
     btConstraintSolver* _solver;
     btDefaultCollisionConfiguration* _collisionConfiguration;
     btOverlapFilterCallback* _filterCallback;
-    static bool _bulletContactCallback_useCustom;
-    static float _bulletContactCallback_combinedFriction;
-    static float _bulletContactCallback_combinedRestitution;
+    bool _bulletContactCallback_useCustom;
+    float _bulletContactCallback_combinedFriction;
+    float _bulletContactCallback_combinedRestitution;
+    btCollisionObject* _sphereQueryObject; // not part of the world, moved to each queried sphere
+    btSphereShape* _sphereQueryShape;
+    std::vector<SParticleShapeContact> _sphereQueryContacts; // reused from query to query
+    std::map<float,btSphereShape*> _particleShapes; // by scaled radius, shared by the particles of same size
+    std::vector<btRigidBody*> _particleBodyPool; // particle bodies removed from the world, reused by the next particles
 };
@@ -47,7 +47,10 @@ CRigidBodyDyn_bullet278::CRigidBodyDyn_bullet278(CDummyShape* shape,CCollShapeDy
     if (_bodyIsKinematic)
     { // this is for kinematic objects only:
         _rigidBody->setCollisionFlags(_rigidBody->getCollisionFlags()|btCollisionObject::CF_KINEMATIC_OBJECT);
-        _rigidBody->setActivationState(DISABLE_DEACTIVATION); // Important, because if we remove the floor and this is not set, nothing falls!
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            _rigidBody->setActivationState(ISLAND_SLEEPING); // otherwise touching bodies never sleep. Active only while moving, see reportShapeConfigurationToRigidBody_forKinematicBody
+        else
+            _rigidBody->setActivationState(DISABLE_DEACTIVATION); // Important, because if we remove the floor and this is not set, nothing falls!
         // Following is important otherwise kinematic bodies make dynamic bodies jump at the first movement!
         _rigidBody->setInterpolationWorldTransform(_rigidBody->getWorldTransform());
         _rigidBody->setInterpolationLinearVelocity(btVector3(0,0,0));
@@ -70,6 +73,12 @@ CRigidBodyDyn_bullet278::CRigidBodyDyn_bullet278(CDummyShape* shape,CCollShapeDy
             _rigidBody->setAngularVelocity(btVector3(v(0),v(1),v(2)));
             _simSetInitialDynamicAngVelocity(shape,C3Vector::zeroVector.data); // important to reset it
         }
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+        {
+            float sleepParams[3];
+            CRigidBodyContainerDyn::getSleepParams(sleepParams);
+            _rigidBody->setSleepingThresholds(sleepParams[0]*linVelScaling,sleepParams[1]); // ********** SCALING
+        }
         // Kinematic objects are handled elsewhere (at the end of the file)
     }
 
@@ -235,6 +244,8 @@ void CRigidBodyDyn_bullet278::reportShapeConfigurationToRigidBody_forKinematicBo
             ms->setWorldTransform(btTransform(wtq,wtx));
         else
             _rigidBody->setWorldTransform(btTransform(wtq,wtx));
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+            _rigidBody->forceActivationState(DISABLE_DEACTIVATION); // a moving kinematic body wakes the bodies it touches
     }
 }
 
@@ -253,6 +264,88 @@ void CRigidBodyDyn_bullet278::applyCorrectEndConfig_forKinematicBody()
             ms->setWorldTransform(btTransform(wtq,wtx));
         else
             _rigidBody->setWorldTransform(btTransform(wtq,wtx));
+        if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+        { // a resting kinematic body must not keep the bodies it touches awake
+            _rigidBody->forceActivationState(ISLAND_SLEEPING);
+            _rigidBody->setLinearVelocity(btVector3(0,0,0));
+            _rigidBody->setAngularVelocity(btVector3(0,0,0));
+        }
     }
 }
 
+bool CRigidBodyDyn_bullet278::isSleeping()
+{
+    return((!_bodyIsKinematic)&&(_rigidBody->getActivationState()==ISLAND_SLEEPING));
+}
+
+void CRigidBodyDyn_bullet278::wakeUp()
+{
+    if (!_bodyIsKinematic)
+        _rigidBody->activate(true);
+}
+
+C3Vector CRigidBodyDyn_bullet278::getVelocityAtPosition(const C3Vector& position)
+{
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
+    btVector3 relPos(btVector3(position(0)*ps,position(1)*ps,position(2)*ps)-_rigidBody->getCenterOfMassPosition());
+    btVector3 v(_rigidBody->getVelocityInLocalPoint(relPos));
+    return(C3Vector(v.getX()/vs,v.getY()/vs,v.getZ()/vs));
+}
+
+void CRigidBodyDyn_bullet278::addForceAtPosition(const C3Vector& force,const C3Vector& position)
+{
+    if (_bodyIsKinematic)
+        return;
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
+    _bodyWasInitiallySleeping=false;
+    _rigidBody->activate(false);
+    btVector3 relPos(btVector3(position(0)*ps,position(1)*ps,position(2)*ps)-_rigidBody->getCenterOfMassPosition());
+    _rigidBody->applyForce(btVector3(force(0)*fs,force(1)*fs,force(2)*fs),relPos);
+}
+
+bool CRigidBodyDyn_bullet278::getState(SRigidBodyState& state)
+{
+    btTransform wt;
+    btMotionState* ms=_rigidBody->getMotionState();
+    if (ms!=nullptr)
+        ms->getWorldTransform(wt);
+    else
+        wt=_rigidBody->getWorldTransform();
+    btQuaternion wtq(wt.getRotation());
+    btVector3 wtx(wt.getOrigin());
+    btVector3 lvel(_rigidBody->getLinearVelocity());
+    btVector3 avel(_rigidBody->getAngularVelocity());
+    for (int i=0;i<3;i++)
+    {
+        state.position[i]=wtx[i];
+        state.linearVelocity[i]=lvel[i];
+        state.angularVelocity[i]=avel[i];
+    }
+    state.quaternion[0]=wtq.getX();
+    state.quaternion[1]=wtq.getY();
+    state.quaternion[2]=wtq.getZ();
+    state.quaternion[3]=wtq.getW();
+    state.activationState=_rigidBody->getActivationState();
+    return(true);
+}
+
+void CRigidBodyDyn_bullet278::setState(const SRigidBodyState& state)
+{
+    btTransform wt(btQuaternion(state.quaternion[0],state.quaternion[1],state.quaternion[2],state.quaternion[3]),btVector3(state.position[0],state.position[1],state.position[2]));
+    btVector3 lvel(state.linearVelocity[0],state.linearVelocity[1],state.linearVelocity[2]);
+    btVector3 avel(state.angularVelocity[0],state.angularVelocity[1],state.angularVelocity[2]);
+    btMotionState* ms=_rigidBody->getMotionState();
+    if (ms!=nullptr)
+        ms->setWorldTransform(wt);
+    _rigidBody->setWorldTransform(wt);
+    _rigidBody->setInterpolationWorldTransform(wt);
+    _rigidBody->setLinearVelocity(lvel);
+    _rigidBody->setAngularVelocity(avel);
+    _rigidBody->setInterpolationLinearVelocity(lvel);
+    _rigidBody->setInterpolationAngularVelocity(avel);
+    _rigidBody->clearForces();
+    _rigidBody->forceActivationState(state.activationState);
+    _rigidBody->setDeactivationTime(0.0f);
+}
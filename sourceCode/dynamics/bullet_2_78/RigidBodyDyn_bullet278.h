@@ -17,6 +17,12 @@ public:
     void handleAdditionalForcesAndTorques(CDummyShape* shape);
     void reportShapeConfigurationToRigidBody_forKinematicBody(CDummyShape* shape,float t,float cumulatedTimeStep);
     void applyCorrectEndConfig_forKinematicBody();
+    bool getState(SRigidBodyState& state);
+    void setState(const SRigidBodyState& state);
+    bool isSleeping();
+    void wakeUp();
+    C3Vector getVelocityAtPosition(const C3Vector& position);
+    void addForceAtPosition(const C3Vector& force,const C3Vector& position);
 
 protected:    
     btRigidBody* _rigidBody;
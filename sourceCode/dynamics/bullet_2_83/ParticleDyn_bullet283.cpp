@@ -55,58 +55,19 @@ bool CParticleDyn_bullet283::addToEngineIfNeeded(float parameters[18],int object
     return(true);
 }
 
-void CParticleDyn_bullet283::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
+void CParticleDyn_bullet283::applyFluidForce(const C3Vector& force)
+{ // scaled
+    btVector3 ff(force(0),force(1),force(2));
+    _rigidBody->applyCentralForce(ff);
+}
+
+C3Vector CParticleDyn_bullet283::getVelocity()
 {
-    bool isWaterButInAir=false;
-    if ( (_objectType&sim_particle_ignoresgravity)||(_objectType&sim_particle_water) )
-    {
-        float mass=_massOverVolume*((piValue*_size*_size*_size)/6.0f)*CRigidBodyContainerDyn::getMassScalingFactorDyn(); // ********** SCALING
-        C3Vector f=gravity*-mass*CRigidBodyContainerDyn::getGravityScalingFactorDyn(); // ********** SCALING
-        bool reallyIgnoreGravity=true;
-        if (_objectType&sim_particle_water)
-        { // We ignore gravity only if we are in the water (z<0) (New since 27/6/2011):
-            float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
-            if (_rigidBody->getWorldTransform().getOrigin().getZ()/ps>=0.0f) // ********** SCALING (not really needed here!)
-            {
-                reallyIgnoreGravity=false;
-                isWaterButInAir=true;
-            }
-        }
-
-        if (reallyIgnoreGravity)
-        {
-            btVector3 ff;
-            ff.setX(f(0));
-            ff.setY(f(1));
-            ff.setZ(f(2));
-            _rigidBody->applyCentralForce(ff);
-        }
-    }
-    if ((linearFluidFrictionCoeff!=0.0f)||(quadraticFluidFrictionCoeff!=0.0f)||(linearAirFrictionCoeff!=0.0f)||(quadraticAirFrictionCoeff!=0.0f))
-    { // New since 27/6/2011
-        float lfc=linearFluidFrictionCoeff;
-        float qfc=quadraticFluidFrictionCoeff;
-        if (isWaterButInAir)
-        {
-            lfc=linearAirFrictionCoeff;
-            qfc=quadraticAirFrictionCoeff;
-        }
-        C3Vector vVect;
-        btVector3 btlv(_rigidBody->getLinearVelocity());
-        vVect.set(btlv.getX(),btlv.getY(),btlv.getZ());
-        float v=vVect.getLength();
-        if (v!=0.0f)
-        {
-            float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
-            float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
-            v/=vs; // ********** SCALING
-            C3Vector nv(vVect.getNormalized()*-1.0f);
-            C3Vector f(nv*(v*lfc+v*v*qfc));
-            f*=fs; // ********** SCALING
-            btVector3 ff(f(0),f(1),f(2));
-            _rigidBody->applyCentralForce(ff);
-        }
-    }
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
+    btVector3 btlv(_rigidBody->getLinearVelocity());
+    return(C3Vector(btlv.getX()/vs,btlv.getY()/vs,btlv.getZ()/vs));
 }
 
 void CParticleDyn_bullet283::removeFromEngine()
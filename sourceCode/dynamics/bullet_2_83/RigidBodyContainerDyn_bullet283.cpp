@@ -2,6 +2,7 @@
 #include "CollShapeDyn_bullet283.h"
 #include "RigidBodyDyn_bullet283.h"
 #include "ConstraintDyn_bullet283.h"
+#include "StepProfiler.h"
 #include "simLib.h"
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletDynamics/ConstraintSolver/btNNCGConstraintSolver.h"
@@ -10,11 +11,7 @@
 //#include "BulletDynamics/MLCPSolvers/btLemkeSolver.h"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolver.h"
 
-bool CRigidBodyContainerDyn_bullet283::_bulletContactCallback_useCustom;
-float CRigidBodyContainerDyn_bullet283::_bulletContactCallback_combinedFriction;
-float CRigidBodyContainerDyn_bullet283::_bulletContactCallback_combinedRestitution;
-
-CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
+CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283(const SDynWorldSettings& settings) : CRigidBodyContainerDyn(settings)
 {
     _dynamicsCalculationPasses=0;
     _allRigidBodiesIndex.resize(CRigidBodyContainerDyn::get3dObjectIdEnd()-CRigidBodyContainerDyn::get3dObjectIdStart(),nullptr);
@@ -48,6 +45,7 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
     {
         virtual ~_myCollisionCallback()
         {}
+        CRigidBodyContainerDyn_bullet283* container; // the engine calls us without context
         // return true when pairs need collision
         virtual bool needBroadphaseCollision(btBroadphaseProxy* childProxy0,btBroadphaseProxy* childProxy1) const
         {
@@ -59,21 +57,22 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
 
             if (collides)
             {
+                DYN_PROFILE_FILTERED_PAIR(container);
                 int objID1;
                 int objID2;
                 btRigidBody* a=(btRigidBody*)multiProxy0->m_clientObject;
                 btRigidBody* b=(btRigidBody*)multiProxy1->m_clientObject;
                 int dataA=(unsigned long long)a->getUserPointer();
                 int dataB=(unsigned long long)b->getUserPointer();
-                CDummyShape* shapeA=(CDummyShape*)_simGetObject(dataA);
-                CDummyShape* shapeB=(CDummyShape*)_simGetObject(dataB);
+                const SCollisionFilter* filterA=container->getCollisionFilter(dataA);
+                const SCollisionFilter* filterB=container->getCollisionFilter(dataB);
                 bool canCollide=false;
-                if ( (shapeA==nullptr)||(shapeB==nullptr) )
+                if ( (filterA==nullptr)||(filterB==nullptr) )
                 { // particle-shape or particle-particle case:
-                    if ( (shapeA==nullptr)&&(shapeB==nullptr) )
+                    if ( (filterA==nullptr)&&(filterB==nullptr) )
                     { // particle-particle case:
-                        CParticleObject* pa=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
-                        CParticleObject* pb=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                        CParticleObject* pa=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                        CParticleObject* pb=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                         objID1=dataA;
                         objID2=dataB;
                         if ( (pa!=nullptr)&&(pb!=nullptr) ) // added this condition on 08/02/2011 because of some crashes when scaling some models
@@ -84,15 +83,15 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
                     else
                     { // particle-shape case:
                         unsigned int collFA=0;
-                        if (shapeA!=nullptr)
+                        if (filterA!=nullptr)
                         {
-                            collFA=_simGetDynamicCollisionMask(shapeA);
-                            canCollide=_simIsShapeDynamicallyRespondable(shapeA)!=0;
-                            objID1=_simGetObjectID(shapeA);
+                            collFA=filterA->collisionMask;
+                            canCollide=(filterA->flags&dyn_collfilter_respondable)!=0;
+                            objID1=dataA;
                         }
                         else
                         {
-                            CParticleObject* po=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                            CParticleObject* po=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                             if (po!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                                 collFA=po->getShapeRespondableMask();
                             else
@@ -100,15 +99,15 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
                             objID1=dataA;
                         }
                         unsigned int collFB=0;
-                        if (shapeB!=nullptr)
+                        if (filterB!=nullptr)
                         {
-                            collFB=_simGetDynamicCollisionMask(shapeB);
-                            canCollide=_simIsShapeDynamicallyRespondable(shapeB)!=0;
-                            objID2=_simGetObjectID(shapeB);
+                            collFB=filterB->collisionMask;
+                            canCollide=(filterB->flags&dyn_collfilter_respondable)!=0;
+                            objID2=dataB;
                         }
                         else
                         {
-                            CParticleObject* po=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                            CParticleObject* po=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                             if (po!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                                 collFB=po->getShapeRespondableMask();
                             else
@@ -120,30 +119,28 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
                 }
                 else
                 { // regular case (shape-shape)
-                    unsigned int collFA=_simGetDynamicCollisionMask(shapeA);
-                    unsigned int collFB=_simGetDynamicCollisionMask(shapeB);
-                    canCollide=(_simIsShapeDynamicallyRespondable(shapeA)&&_simIsShapeDynamicallyRespondable(shapeB));
-                    CDummy3DObject* lastPA=(CDummy3DObject*)_simGetLastParentForLocalGlobalCollidable(shapeA);
-                    CDummy3DObject* lastPB=(CDummy3DObject*)_simGetLastParentForLocalGlobalCollidable(shapeB);
-                    if (lastPA==lastPB)
+                    unsigned int collFA=filterA->collisionMask;
+                    unsigned int collFB=filterB->collisionMask;
+                    canCollide=((filterA->flags&filterB->flags&dyn_collfilter_respondable)!=0);
+                    if (filterA->localGlobalCollidableRoot==filterB->localGlobalCollidableRoot)
                         canCollide=(canCollide&&(collFA&collFB&0x00ff)); // we are local
                     else
                         canCollide=(canCollide&&(collFA&collFB&0xff00)); // we are global
-                    objID1=_simGetObjectID(shapeA);
-                    objID2=_simGetObjectID(shapeB);
+                    objID1=dataA;
+                    objID2=dataB;
                 }
                 if (canCollide)
                 {
                     int dataInt[3]={0,0,0};
                     float dataFloat[14]={1.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f};
 
-                    int customHandleRes=_simHandleCustomContact(objID1,objID2,sim_physics_bullet,dataInt,dataFloat);
+                    int customHandleRes=container->_handleCustomContact(objID1,objID2,sim_physics_bullet,dataInt,dataFloat);
                     bool canReallyCollide=(customHandleRes!=0);
                     if (customHandleRes>0)
                     {
-                        _bulletContactCallback_useCustom=true;
-                        _bulletContactCallback_combinedFriction=dataFloat[0];
-                        _bulletContactCallback_combinedRestitution=dataFloat[1];
+                        container->_bulletContactCallback_useCustom=true;
+                        container->_bulletContactCallback_combinedFriction=dataFloat[0];
+                        container->_bulletContactCallback_combinedRestitution=dataFloat[1];
                     }
                     return(canReallyCollide);
                 }
@@ -151,7 +148,10 @@ CRigidBodyContainerDyn_bullet283::CRigidBodyContainerDyn_bullet283()
             return(false);
         }
     };
-    _filterCallback = new _myCollisionCallback();
+    _myCollisionCallback* filterCallback=new _myCollisionCallback();
+    filterCallback->container=this;
+    _filterCallback=filterCallback;
+    _bulletContactCallback_useCustom=false;
     _dynamicsWorld->getBroadphase()->getOverlappingPairCache()->setOverlapFilterCallback(_filterCallback);
     gContactAddedCallback=_bulletContactCallback; // For Bullet's custom contact callback
 
@@ -196,11 +196,12 @@ int CRigidBodyContainerDyn_bullet283::getEngineInfo(int& engine,int data1[4],cha
 }
 
 bool CRigidBodyContainerDyn_bullet283::_bulletContactCallback(btManifoldPoint& cp,const btCollisionObjectWrapper* colObjWrap0,int partId0,int index0,const btCollisionObjectWrapper* colObjWrap1,int partId1,int index1)
-{
-    if (_bulletContactCallback_useCustom)
+{ // only called by the thread stepping the world, i.e. the current container is the right one
+    CRigidBodyContainerDyn_bullet283* container=(CRigidBodyContainerDyn_bullet283*)currentRigidBodyContainerDynObject;
+    if (container->_bulletContactCallback_useCustom)
     { // We want a custom handling of this contact!
-        cp.m_combinedFriction=_bulletContactCallback_combinedFriction;
-        cp.m_combinedRestitution=_bulletContactCallback_combinedRestitution;
+        cp.m_combinedFriction=container->_bulletContactCallback_combinedFriction;
+        cp.m_combinedRestitution=container->_bulletContactCallback_combinedRestitution;
         return(true);
     }
     return(false);
@@ -284,7 +285,7 @@ void CRigidBodyContainerDyn_bullet283::addBulletContactPoints(int dynamicPassNum
             ci.directionAndAmplitude=d*force;
             ci.surfaceNormal=d;
             ci.subPassNumber=dynamicPassNumber;
-            _contactInfo.push_back(ci);
+            _contacts.addContact(ci);
 
             _contactPoints.push_back(avrg(0)/linScaling);
             _contactPoints.push_back(avrg(1)/linScaling);
@@ -6,7 +6,7 @@
 class CRigidBodyContainerDyn_bullet283 : public CRigidBodyContainerDyn
 {
 public:
-    CRigidBodyContainerDyn_bullet283();
+    CRigidBodyContainerDyn_bullet283(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn_bullet283();
 
     int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
@@ -31,7 +31,7 @@ protected:
 
     btDefaultCollisionConfiguration* _collisionConfiguration;
     btOverlapFilterCallback* _filterCallback;
-    static bool _bulletContactCallback_useCustom;
-    static float _bulletContactCallback_combinedFriction;
-    static float _bulletContactCallback_combinedRestitution;
+    bool _bulletContactCallback_useCustom;
+    float _bulletContactCallback_combinedFriction;
+    float _bulletContactCallback_combinedRestitution;
 };
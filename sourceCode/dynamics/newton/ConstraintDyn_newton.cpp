@@ -671,15 +671,25 @@ CConstraintDyn_newton::CConstraintDyn_newton(CRigidBodyDyn* parentBody, CRigidBo
     NewtonBody* parentRigidBody=((CRigidBodyDyn_newton*)parentBody)->getNewtonRigidBody();
     NewtonBody* childRigidBody=((CRigidBodyDyn_newton*)childBody)->getNewtonRigidBody();
 
-    // wake up the parent body and disable deactivation for future:
-    NewtonBodySetSleepState(parentRigidBody,1);
-    NewtonBodySetFreezeState(parentRigidBody,0);
-    NewtonBodySetAutoSleep(parentRigidBody,0);
-
-    // wake up the child body and disable deactivation for future:
-    NewtonBodySetSleepState(childRigidBody,1);
-    NewtonBodySetFreezeState(childRigidBody,0);
-    NewtonBodySetAutoSleep(childRigidBody,0);
+    if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+    { // wake up the parent and child bodies. The island can sleep as a whole
+        NewtonBodySetSleepState(parentRigidBody,0);
+        NewtonBodySetFreezeState(parentRigidBody,0);
+        NewtonBodySetSleepState(childRigidBody,0);
+        NewtonBodySetFreezeState(childRigidBody,0);
+    }
+    else
+    {
+        // wake up the parent body and disable deactivation for future:
+        NewtonBodySetSleepState(parentRigidBody,1);
+        NewtonBodySetFreezeState(parentRigidBody,0);
+        NewtonBodySetAutoSleep(parentRigidBody,0);
+
+        // wake up the child body and disable deactivation for future:
+        NewtonBodySetSleepState(childRigidBody,1);
+        NewtonBodySetFreezeState(childRigidBody,0);
+        NewtonBodySetAutoSleep(childRigidBody,0);
+    }
 
     _bodyAID = parentBody->getRigidBodyID();
     _bodyBID = childBody->getRigidBodyID();
@@ -833,46 +843,19 @@ void CConstraintDyn_newton::_setPrismaticJointLimits(CDummyJoint* joint)
     }
 }
 
-void CConstraintDyn_newton::_handleRevoluteMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_newton::_getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
 {
-    float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
-
-    csimNewtonRevoluteJoint* const jointClass = (csimNewtonRevoluteJoint*)_newtonConstraint;
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-
-    float e;
-
     if (_simGetJointPositionInterval(joint,nullptr,nullptr)==0)
-        e=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint), getHingeAngle());
+        error=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint), getHingeAngle());
     else
-        e=_simGetDynamicMotorTargetPosition(joint)-getHingeAngle();
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-
-    inputValuesFloat[0]=getHingeAngle();
-
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
-    jointClass->m_data.SetMotor(true,velocityToApply, forceToApply);
+        error=_simGetDynamicMotorTargetPosition(joint)-getHingeAngle();
+    position=getHingeAngle();
+}
+
+void CConstraintDyn_newton::_applyRevoluteMotorController(float velocity,float force)
+{
+    csimNewtonRevoluteJoint* const jointClass = (csimNewtonRevoluteJoint*)_newtonConstraint;
+    jointClass->m_data.SetMotor(true,velocity, force);
 }
 
 
@@ -901,38 +884,16 @@ void CConstraintDyn_newton::_handleRevoluteMotor_controllerDisabled(CDummyJoint*
     }
 }
 
-void CConstraintDyn_newton::_handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_newton::_getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
 {
-    float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
+    error=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled();
+    position=getSliderPositionScaled();
+}
 
+void CConstraintDyn_newton::_applyPrismaticMotorController(float velocity,float force)
+{
     csimNewtonPrismaticJoint* const jointClass = (csimNewtonPrismaticJoint*)_newtonConstraint;
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-    float e=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled();
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-    inputValuesFloat[0]=getSliderPositionScaled();
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
-    jointClass->m_data.SetMotor(true,velocityToApply, forceToApply);
+    jointClass->m_data.SetMotor(true,velocity, force);
 }
 
 void CConstraintDyn_newton::_handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses)
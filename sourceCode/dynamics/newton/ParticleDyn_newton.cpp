@@ -25,12 +25,16 @@ bool CParticleDyn_newton::addToEngineIfNeeded(float parameters[18],int objectID)
     tr.X=_currentPosition;
     dMatrix matrix (GetDMatrixFromCoppeliaSimTransformation(tr));
 
-    NewtonCollision* const collision = NewtonCreateSphere(world,_size*0.5f,0,nullptr);
-    _newtonBody = NewtonCreateDynamicBody (world,collision,&matrix[0][0]);
-    NewtonDestroyCollision (collision);
+    if (_objectType&sim_particle_itemsizes)
+    { // particles of this object have different sizes
+        NewtonCollision* const collision = NewtonCreateSphere(world,_size*0.5f,0,nullptr);
+        _newtonBody = NewtonCreateDynamicBody (world,collision,&matrix[0][0]);
+        NewtonDestroyCollision (collision);
+    }
+    else
+        _newtonBody = NewtonCreateDynamicBody (world,rbc->getParticleShape(_size*0.5f),&matrix[0][0]);
     
     _particleMass=_massOverVolume*(4.0f*piValue*(_size*0.5f)*(_size*0.5f)*(_size*0.5f)/3.0f);
-    _ignoreGravity=false;
     float I=2.0f*(_size*0.5f)*(_size*0.5f)/5.0f;
     C3Vector im(I,I,I);
     im*=_particleMass;
@@ -65,52 +69,9 @@ bool CParticleDyn_newton::addToEngineIfNeeded(float parameters[18],int objectID)
     return(true);
 }
 
-void CParticleDyn_newton::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
-{
-    bool isWaterButInAir=false;
-    if ( (_objectType&sim_particle_ignoresgravity)||(_objectType&sim_particle_water) )
-    {
-        float mass=_massOverVolume*((piValue*_size*_size*_size)/6.0f);
-        C3Vector f=gravity*-mass;
-        bool reallyIgnoreGravity=true;
-        if (_objectType&sim_particle_water)
-        { // We ignore gravity only if we are in the water (z<0) (New since 27/6/2011):
-            C3Vector pos;
-            NewtonBodyGetPosition(_newtonBody,pos.data);
-            if (pos(2)>=0.0f)
-            {
-                reallyIgnoreGravity=false;
-                isWaterButInAir=true;
-            }
-        }
-
-        _ignoreGravity=reallyIgnoreGravity;
-        if (reallyIgnoreGravity)
-        {
-
-        }
-    }
-    if ((linearFluidFrictionCoeff!=0.0f)||(quadraticFluidFrictionCoeff!=0.0f)||(linearAirFrictionCoeff!=0.0f)||(quadraticAirFrictionCoeff!=0.0f))
-    { // New since 27/6/2011
-        float lfc=linearFluidFrictionCoeff;
-        float qfc=quadraticFluidFrictionCoeff;
-        if (isWaterButInAir)
-        {
-            lfc=linearAirFrictionCoeff;
-            qfc=quadraticAirFrictionCoeff;
-        }
-        C3Vector vVect;
-
-        NewtonBodyGetVelocity(_newtonBody,vVect.data);
-
-        float v=vVect.getLength();
-        if (v!=0.0f)
-        {
-            C3Vector nv(vVect.getNormalized()*-1.0f);
-            C3Vector f(nv*(v*lfc+v*v*qfc));
-            m_externForce=f;
-        }
-    }
+void CParticleDyn_newton::applyFluidForce(const C3Vector& force)
+{ // applied in ApplyExtenalForceCallback, together with gravity
+    m_externForce=force;
 }
 
 void CParticleDyn_newton::removeFromEngine()
@@ -139,16 +100,10 @@ void CParticleDyn_newton::ApplyExtenalForceCallback(const NewtonBody* body, dFlo
     CParticleDyn_newton* const me = (CParticleDyn_newton*)userData[1];
 
     C3Vector gravity;
-    gravity.clear();
-
-    if (!me->_ignoreGravity)
-    {
-        _simGetGravity(gravity.data);
-        gravity *= me->_particleMass;
-    }
-
+    _simGetGravity(gravity.data);
+    gravity *= me->_particleMass;
 
-    gravity += me->m_externForce;
+    gravity += me->m_externForce; // includes the anti-gravity force of water and ignoresgravity particles
     NewtonBodyAddForce(body, &gravity.data[0]);
 /*
 // for testing codename system alignments
@@ -160,3 +115,12 @@ if (mass != 0.0f) {
 }
 */
 }
+
+C3Vector CParticleDyn_newton::getVelocity()
+{
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    C3Vector v;
+    NewtonBodyGetVelocity(_newtonBody,v.data);
+    return(v);
+}
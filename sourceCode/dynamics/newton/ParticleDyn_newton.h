@@ -17,9 +17,10 @@ public:
     virtual ~CParticleDyn_newton();
 
     bool addToEngineIfNeeded(float parameters[18],int objectID);
-    void handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff);
+    void applyFluidForce(const C3Vector& force);
     void updatePosition();
     void removeFromEngine();
+    C3Vector getVelocity();
 
     static void TransformCallback(const NewtonBody* body, const dFloat* matrix, int threadIndex);
     static void ApplyExtenalForceCallback(const NewtonBody* body, dFloat timestep, int threadIndex);
@@ -27,7 +28,6 @@ public:
 protected:    
     NewtonBody* _newtonBody;
     C3Vector m_externForce;
-    bool _ignoreGravity;
     float _particleMass;
     int _particleObjectID_withOffset;
     void* _newtonParticleUserData[5];// particleObjectID,this,stat. friction,kin. friction, restitution
@@ -2,9 +2,10 @@
 #include "CollShapeDyn_newton.h"
 #include "RigidBodyDyn_newton.h"
 #include "ConstraintDyn_newton.h"
+#include "StepProfiler.h"
 #include "simLib.h"
 
-CRigidBodyContainerDyn_newton::CRigidBodyContainerDyn_newton()
+CRigidBodyContainerDyn_newton::CRigidBodyContainerDyn_newton(const SDynWorldSettings& settings) : CRigidBodyContainerDyn(settings)
 {
     _dynamicsCalculationPasses=0;
     _allRigidBodiesIndex.resize(CRigidBodyContainerDyn::get3dObjectIdEnd()-CRigidBodyContainerDyn::get3dObjectIdStart(),nullptr);
@@ -60,6 +61,8 @@ CRigidBodyContainerDyn_newton::CRigidBodyContainerDyn_newton()
     CustomJoint::Initalize(_world);
 
     _rebuildSkeletons = true;
+    _sphereQueryShape = nullptr;
+    _sphereQueryRadius = 0.0f;
 
     // Now flag all objects and geoms as "_dynamicsFullRefresh":
     for (int i=0;i<_simGetObjectListSize(sim_handle_all);i++)
@@ -82,6 +85,10 @@ CRigidBodyContainerDyn_newton::~CRigidBodyContainerDyn_newton()
     }
 
     NewtonWaitForUpdateToFinish (_world);
+    if (_sphereQueryShape != nullptr)
+        NewtonDestroyCollision (_sphereQueryShape);
+    for (std::map<float,NewtonCollision*>::iterator it=_particleShapes.begin();it!=_particleShapes.end();it++)
+        NewtonDestroyCollision(it->second);
     NewtonDestroyAllBodies (_world);
     NewtonDestroy(_world);
 
@@ -89,6 +96,14 @@ CRigidBodyContainerDyn_newton::~CRigidBodyContainerDyn_newton()
     particleCont.removeAllObjects();
 }
 
+NewtonCollision* CRigidBodyContainerDyn_newton::getParticleShape(float radius)
+{ // the shape is shared and destroyed together with the world. Bodies keep their own reference to it
+    NewtonCollision*& shape=_particleShapes[radius];
+    if (shape==nullptr)
+        shape=NewtonCreateSphere(_world,radius,0,nullptr);
+    return(shape);
+}
+
 int CRigidBodyContainerDyn_newton::getEngineInfo(int& engine,int data1[4],char* data2,char* data3)
 {
     engine=sim_physics_newton;
@@ -134,6 +149,7 @@ void CRigidBodyContainerDyn_newton::_addNewtonContactPoints(int dynamicPassNumbe
                         // But keep following commented, in future we will also offer the normal force:
                         // force = normal.Scale (normal % force);
 
+                        _contacts.reserveCounted(_contactPoints,_contactPoints.size()+3);
                         _contactPoints.push_back(point.m_x);
                         _contactPoints.push_back(point.m_y);
                         _contactPoints.push_back(point.m_z);
@@ -150,7 +166,7 @@ void CRigidBodyContainerDyn_newton::_addNewtonContactPoints(int dynamicPassNumbe
                             n=n*-1.0f;
                         ci.surfaceNormal =n;
                         ci.directionAndAmplitude = f;
-                        _contactInfo.push_back(ci);
+                        _contacts.addContact(ci);
                     }
                 }
             }
@@ -163,6 +179,9 @@ int CRigidBodyContainerDyn_newton::NewtonOnAABBOverlap(const NewtonMaterial* con
     // If it returns 0, no further collision is checked between those 2 bodies,
     // and they will not collide with each other.
     // So here, we check if those two bodies can collide
+    CRigidBodyContainerDyn_newton* container=(CRigidBodyContainerDyn_newton*)NewtonWorldGetUserData(NewtonBodyGetWorld(body0)); // we can be called from any thread
+    container->makeCurrent(); // for the static getters, on Newton's worker threads
+    DYN_PROFILE_FILTERED_PAIR(container);
 
     // If we have a contact callback registered, we always return 1:
     if (_simGetContactCallbackCount()>0)
@@ -170,49 +189,52 @@ int CRigidBodyContainerDyn_newton::NewtonOnAABBOverlap(const NewtonMaterial* con
 
     void** userDataA=(void**)NewtonBodyGetUserData(body0);
     void** userDataB=(void**)NewtonBodyGetUserData(body1);
-    CDummyShape* shapeA=(CDummyShape*)_simGetObject(((int*)userDataA[0])[0]);
-    CDummyShape* shapeB=(CDummyShape*)_simGetObject(((int*)userDataB[0])[0]);
+    int dataA=((int*)userDataA[0])[0];
+    int dataB=((int*)userDataB[0])[0];
+    const SCollisionFilter* filterA=container->getCollisionFilter(dataA);
+    const SCollisionFilter* filterB=container->getCollisionFilter(dataB);
     bool canCollide=false;
-    if ( (shapeA!=nullptr)&&(shapeB!=nullptr) )
+    if ( (filterA!=nullptr)&&(filterB!=nullptr) )
     { // regular case (shape-shape)
-        unsigned int collFA=_simGetDynamicCollisionMask(shapeA);
-        unsigned int collFB=_simGetDynamicCollisionMask(shapeB);
-        canCollide=(_simIsShapeDynamicallyRespondable(shapeA)&&_simIsShapeDynamicallyRespondable(shapeB))&&((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_respondable)!=0)&&((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_respondable)!=0);
-        if (_simGetLastParentForLocalGlobalCollidable(shapeA)==_simGetLastParentForLocalGlobalCollidable(shapeB))
+        unsigned int collFA=filterA->collisionMask;
+        unsigned int collFB=filterB->collisionMask;
+        const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+        canCollide=((filterA->flags&filterB->flags&respFlags)==respFlags);
+        if (filterA->localGlobalCollidableRoot==filterB->localGlobalCollidableRoot)
             canCollide=canCollide&&(collFA&collFB&0x00ff); // we are local
         else
             canCollide=canCollide&&(collFA&collFB&0xff00); // we are global
-        if ( (_simIsShapeDynamicallyStatic(shapeA)||((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_dynamic)==0))&&
-            (_simIsShapeDynamicallyStatic(shapeB)||((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_dynamic)==0)) )
+        if ((filterA->flags&filterB->flags&dyn_collfilter_staticornottreedynamic)!=0)
             canCollide=false;
     }
     else
     { // particle-shape or particle-particle case:
-        int dataA=((int*)userDataA[0])[0];
-        int dataB=((int*)userDataB[0])[0];
-        if ( (shapeA==nullptr)&&(shapeB==nullptr) )
+        if ( (filterA==nullptr)&&(filterB==nullptr) )
         { // particle-particle case:
-            CParticleObject* pa=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
-            CParticleObject* pb=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+            CParticleObject* pa=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+            CParticleObject* pb=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
 
             if ( (pa!=nullptr)&&(pb!=nullptr) ) // added this condition on 08/02/2011 because of some crashes when scaling some models
                 canCollide=pa->isParticleRespondable()&&pb->isParticleRespondable();
         }
         else
         { // particle-shape case:
-            CDummyShape* shape=nullptr;
+            const SCollisionFilter* filter=nullptr;
             CParticleObject* particle=nullptr;
-            if (shapeA!=nullptr)
-                shape=shapeA;
+            if (filterA!=nullptr)
+                filter=filterA;
             else
-                particle=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
-            if (shapeB!=nullptr)
-                shape=shapeB;
+                particle=container->particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+            if (filterB!=nullptr)
+                filter=filterB;
             else
-                particle=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                particle=container->particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
 
             if (particle!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
-                canCollide=_simIsShapeDynamicallyRespondable(shape)&&(_simGetDynamicCollisionMask(shape)&particle->getShapeRespondableMask()&0xff00)&&((_simGetTreeDynamicProperty(shape)&sim_objdynprop_respondable)!=0); // we are global
+            {
+                const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+                canCollide=((filter->flags&respFlags)==respFlags)&&(filter->collisionMask&particle->getShapeRespondableMask()&0xff00); // we are global
+            }
         }
     }
 
@@ -316,22 +338,25 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
 
     NewtonBody* const body0 = NewtonJointGetBody0(contactJoint);
     NewtonBody* const body1 = NewtonJointGetBody1(contactJoint);
+    CRigidBodyContainerDyn_newton* container=(CRigidBodyContainerDyn_newton*)NewtonWorldGetUserData(NewtonBodyGetWorld(body0)); // we can be called from any thread
+    container->makeCurrent(); // for the static getters, on Newton's worker threads
 
     void** userDataA=(void**)NewtonBodyGetUserData(body0);
     void** userDataB=(void**)NewtonBodyGetUserData(body1);
 
-    CDummyShape* shapeA=(CDummyShape*)_simGetObject(((int*)userDataA[0])[0]);
-    CDummyShape* shapeB=(CDummyShape*)_simGetObject(((int*)userDataB[0])[0]);
     bool collides=true; // was already checked previously, unless we have a user callback
     int id_A=((int*)userDataA[0])[0];
     int id_B=((int*)userDataB[0])[0];
+    // Surface properties are cached in the body user data, and filter records were filled before NewtonUpdate:
+    bool isShapeA=(container->getCollisionFilter(id_A)!=nullptr);
+    bool isShapeB=(container->getCollisionFilter(id_B)!=nullptr);
     float statFriction_A=0.0f;
     float statFriction_B=0.0f;
     float kinFriction_A=0.0f;
     float kinFriction_B=0.0f;
     float restit_A=0.0f;
     float restit_B=0.0f;
-    if ( (shapeA!=nullptr)&&(shapeB!=nullptr) )
+    if (isShapeA&&isShapeB)
     { // regular case (shape-shape)
         statFriction_A=((float*)userDataA[2])[0];
         statFriction_B=((float*)userDataB[2])[0];
@@ -342,10 +367,10 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
     }
     else
     { // particle-shape or particle-particle case:
-        if ( (shapeA==nullptr)&&(shapeB==nullptr) )
+        if ( (!isShapeA)&&(!isShapeB) )
         { // particle-particle case:
-            CParticleObject* pa=particleCont.getObject(id_A-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
-            CParticleObject* pb=particleCont.getObject(id_B-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+            CParticleObject* pa=container->particleCont.getObject(id_A-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+            CParticleObject* pb=container->particleCont.getObject(id_B-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
 
             if ( (pa!=nullptr)&&(pb!=nullptr) ) // added this condition on 08/02/2011 because of some crashes when scaling some models
             {
@@ -362,7 +387,7 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
         }
         else
         { // particle-shape case:
-            if (shapeA!=nullptr)
+            if (isShapeA)
             {
                 statFriction_A=((float*)userDataA[2])[0];
                 kinFriction_A=((float*)userDataA[3])[0];
@@ -370,7 +395,7 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
             }
             else
             {
-                CParticleObject* particle=particleCont.getObject(id_A-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                CParticleObject* particle=container->particleCont.getObject(id_A-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                 if (particle!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                 {
                     // Get the particle's user data:
@@ -381,7 +406,7 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
                 else
                     collides=false; // not normal
             }
-            if (shapeB!=nullptr)
+            if (isShapeB)
             {
                 statFriction_B=((float*)userDataB[2])[0];
                 kinFriction_B=((float*)userDataB[3])[0];
@@ -389,7 +414,7 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
             }
             else
             {
-                CParticleObject* particle=particleCont.getObject(id_B-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
+                CParticleObject* particle=container->particleCont.getObject(id_B-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                 if (particle!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                 {
                     // Get the particle's user data:
@@ -416,7 +441,7 @@ void CRigidBodyContainerDyn_newton::NewtonOnUserContacts(const NewtonJoint* cont
 #ifndef DG_USE_THREAD_EMULATION
         flag|=1024; // means: the callback scripts won't be called (e.g. when this thread is not the simulation thread)
 #endif
-        int customHandleRes=_simHandleCustomContact(id_A,id_B,sim_physics_newton+flag,dataInt,dataFloat);
+        int customHandleRes=container->_handleCustomContact(id_A,id_B,sim_physics_newton+flag,dataInt,dataFloat);
         collides=(customHandleRes!=0);
         if (customHandleRes>0)
         {
@@ -503,8 +528,56 @@ NewtonWorld* CRigidBodyContainerDyn_newton::getWorld()
     return(_world);
 }
 
+int CRigidBodyContainerDyn_newton::collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts)
+{
+    if ( (_sphereQueryShape==nullptr)||(_sphereQueryRadius!=radius) )
+    {
+        if (_sphereQueryShape!=nullptr)
+            NewtonDestroyCollision(_sphereQueryShape);
+        _sphereQueryShape=NewtonCreateSphere(_world,radius,0,nullptr);
+        _sphereQueryRadius=radius;
+    }
+    dMatrix matrix(dGetIdentityMatrix());
+    matrix.m_posit=dVector(center(0),center(1),center(2),1.0f);
+    _sphereQueryRespondableMask=respondableMask;
+    NewtonWorldConvexCastReturnInfo info[8];
+    if (maxContacts>8)
+        maxContacts=8;
+    int cnt=NewtonWorldCollide(_world,&matrix[0][0],_sphereQueryShape,this,NewtonSphereQueryPrefilter,info,maxContacts,0);
+    int retVal=0;
+    for (int i=0;i<cnt;i++)
+    {
+        if (info[i].m_penetration<=0.0f)
+            continue;
+        void** userData=(void**)NewtonBodyGetUserData(info[i].m_hitBody);
+        SParticleShapeContact& contact=contacts[retVal++];
+        contact.position.set(info[i].m_point[0],info[i].m_point[1],info[i].m_point[2]);
+        contact.normal.set(info[i].m_normal[0],info[i].m_normal[1],info[i].m_normal[2]);
+        contact.normal.normalize();
+        if (contact.normal*(center-contact.position)<0.0f)
+            contact.normal=contact.normal*-1.0f; // we want it pointing towards the particle
+        contact.depth=info[i].m_penetration;
+        contact.shapeID=((int*)userData[0])[0];
+    }
+    return(retVal);
+}
+
+unsigned CRigidBodyContainerDyn_newton::NewtonSphereQueryPrefilter(const NewtonBody* const body, const NewtonCollision* const collision, void* const userData)
+{
+    CRigidBodyContainerDyn_newton* container=(CRigidBodyContainerDyn_newton*)userData;
+    void** bodyUserData=(void**)NewtonBodyGetUserData(body);
+    int objectID=((int*)bodyUserData[0])[0];
+    return(container->_canParticleCollideWithShape(objectID,container->_sphereQueryRespondableMask)?1:0); // particles that are engine bodies are also skipped here
+}
+
 void CRigidBodyContainerDyn_newton::_stepDynamics(float dt,int pass)
 {
+    _fillAllCollisionFilters(); // NewtonOnAABBOverlap is called from several threads
     NewtonUpdate(_world,dt);
     _addNewtonContactPoints(pass);
 }
+
+void CRigidBodyContainerDyn_newton::_resetContactCaches()
+{
+    NewtonInvalidateCache(_world);
+}
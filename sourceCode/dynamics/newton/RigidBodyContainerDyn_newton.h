@@ -9,12 +9,13 @@
 #include "CustomBallAndSocket.h"
 #include "CustomHingeActuator.h"
 #include "CustomSliderActuator.h"
+#include <map>
 
 class CRigidBodyContainerDyn_newton : public CRigidBodyContainerDyn
 {
 public:
 
-    CRigidBodyContainerDyn_newton();
+    CRigidBodyContainerDyn_newton(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn_newton();
 
     int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
@@ -22,6 +23,8 @@ public:
     void serializeDynamicContent(const std::string& filenameAndPath,int maxSerializeBufferSize);
 
     NewtonWorld* getWorld();
+    int collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts);
+    NewtonCollision* getParticleShape(float radius);
 
     void _notifySekeletonRebuild ();
     void _rebuildSkeletonList();
@@ -31,6 +34,7 @@ public:
     bool _rebuildSkeletons;
 protected:
     void _stepDynamics(float dt,int pass);
+    void _resetContactCaches();
     void _createDependenciesBetweenJoints();
     void _removeDependenciesBetweenJoints(CConstraintDyn* theInvolvedConstraint);
 
@@ -38,6 +42,11 @@ protected:
     typedef void (*NewtonSkeletontDestructor) (const NewtonSkeletonContainer* const me);
     static void NewtonOnUserContacts (const NewtonJoint* contactJoint, dFloat timestep, int threadIndex);
     static int NewtonOnAABBOverlap (const NewtonMaterial* const material, const NewtonBody* const body0, const NewtonBody* const body1, int threadIndex);
+    static unsigned NewtonSphereQueryPrefilter (const NewtonBody* const body, const NewtonCollision* const collision, void* const userData);
 
     NewtonWorld* _world;
+    NewtonCollision* _sphereQueryShape; // recreated when the queried radius changes
+    float _sphereQueryRadius;
+    int _sphereQueryRespondableMask;
+    std::map<float,NewtonCollision*> _particleShapes; // by radius, shared by the particles of same size
 };
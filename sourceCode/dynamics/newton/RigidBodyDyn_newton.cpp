@@ -35,8 +35,8 @@ CRigidBodyDyn_newton::CRigidBodyDyn_newton(CDummyShape* const shape,CCollShapeDy
 
     NewtonBodySetUserData(_newtonBody, _newtonBodyUserData);
 
-    // disable auto sleep at all time
-    NewtonBodySetAutoSleep(_newtonBody, 0);
+    // disable auto sleep, except in sleep mode. Newton has no configurable sleep thresholds
+    NewtonBodySetAutoSleep(_newtonBody, (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)?1:0);
 
     // set linear and angular damping
     NewtonBodySetLinearDamping(_newtonBody, _newtonLinearDrag);
@@ -161,6 +161,41 @@ void CRigidBodyDyn_newton::reportVelocityToShape(CDummyShape* shape)
     _simSetShapeDynamicVelocity(shape,lv.data,av.data);
 }
 
+bool CRigidBodyDyn_newton::isSleeping()
+{
+    return((!_bodyIsKinematic)&&(NewtonBodyGetSleepState(_newtonBody)!=0));
+}
+
+void CRigidBodyDyn_newton::wakeUp()
+{
+    if (!_bodyIsKinematic)
+        NewtonBodySetSleepState(_newtonBody,0);
+}
+
+C3Vector CRigidBodyDyn_newton::getVelocityAtPosition(const C3Vector& position)
+{
+    dVector p(position(0),position(1),position(2),0.0f);
+    dVector v;
+    NewtonBodyGetPointVelocity(_newtonBody,&p.m_x,&v.m_x);
+    return(C3Vector(v.m_x,v.m_y,v.m_z));
+}
+
+void CRigidBodyDyn_newton::addForceAtPosition(const C3Vector& force,const C3Vector& position)
+{ // accumulated with the additional force and torque, applied in the force and torque callback
+    if (_bodyIsKinematic)
+        return;
+    dMatrix matrix;
+    NewtonBodyGetMatrix(_newtonBody,&matrix[0][0]);
+    dVector com;
+    NewtonBodyGetCentreOfMass(_newtonBody,&com.m_x);
+    com=matrix.TransformVector(com);
+    C3Vector arm(position(0)-com.m_x,position(1)-com.m_y,position(2)-com.m_z);
+    _bodyWasInitiallySleeping=false;
+    wakeUp();
+    m_externForce+=force;
+    m_externTorque+=arm^force;
+}
+
 void CRigidBodyDyn_newton::handleAdditionalForcesAndTorques(CDummyShape* shape)
 {
     C3Vector vf,vt;
@@ -168,10 +203,11 @@ void CRigidBodyDyn_newton::handleAdditionalForcesAndTorques(CDummyShape* shape)
 
     m_externTorque.clear();
     m_externForce.clear();
-    // In Newton bodies are never sleeping!
+    // In Newton bodies are never sleeping, except in sleep mode!
     if ((vf.getLength() != 0.0f) || (vt.getLength() != 0.0f))
     { // We should wake the body!!
         _bodyWasInitiallySleeping = false;
+        wakeUp();
         m_externTorque=vt;
         m_externForce=vf;
     }
@@ -286,3 +322,39 @@ if (mass != 0.0f) {
 */
 }
 
+bool CRigidBodyDyn_newton::getState(SRigidBodyState& state)
+{
+    dFloat pos[3];
+    dFloat rot[4];
+    dFloat lvel[3];
+    dFloat avel[3];
+    NewtonBodyGetPosition(_newtonBody,pos);
+    NewtonBodyGetRotation(_newtonBody,rot);
+    NewtonBodyGetVelocity(_newtonBody,lvel);
+    NewtonBodyGetOmega(_newtonBody,avel);
+    for (int i=0;i<3;i++)
+    {
+        state.position[i]=pos[i];
+        state.linearVelocity[i]=lvel[i];
+        state.angularVelocity[i]=avel[i];
+    }
+    for (int i=0;i<4;i++)
+        state.quaternion[i]=rot[i];
+    state.activationState=NewtonBodyGetSleepState(_newtonBody);
+    return(true);
+}
+
+void CRigidBodyDyn_newton::setState(const SRigidBodyState& state)
+{
+    dQuaternion rot(dFloat(state.quaternion[0]),dFloat(state.quaternion[1]),dFloat(state.quaternion[2]),dFloat(state.quaternion[3]));
+    dVector pos(dFloat(state.position[0]),dFloat(state.position[1]),dFloat(state.position[2]),1.0f);
+    dMatrix matrix(rot,pos);
+    dVector lvel(dFloat(state.linearVelocity[0]),dFloat(state.linearVelocity[1]),dFloat(state.linearVelocity[2]),0.0f);
+    dVector avel(dFloat(state.angularVelocity[0]),dFloat(state.angularVelocity[1]),dFloat(state.angularVelocity[2]),0.0f);
+    NewtonBodySetMatrix(_newtonBody,&matrix[0][0]);
+    NewtonBodySetVelocity(_newtonBody,&lvel[0]);
+    NewtonBodySetOmega(_newtonBody,&avel[0]);
+    m_externForce.clear();
+    m_externTorque.clear();
+    NewtonBodySetSleepState(_newtonBody,state.activationState);
+}
@@ -75,7 +75,8 @@ CConstraintDyn_ode::CConstraintDyn_ode(CRigidBodyDyn* parentBody,CRigidBodyDyn*
 
     //    if ((parentBody->isBodyKinematic())
     { // this is a dynamic object
-        dBodySetAutoDisableFlag(parentRigidBody,0);
+        if (CRigidBodyContainerDyn::getSleepMode()!=dyn_sleep_on) // in sleep mode, the island can sleep as a whole
+            dBodySetAutoDisableFlag(parentRigidBody,0);
         dBodyEnable(parentRigidBody);
     }
     batr=parentBody->getInertiaFrameTransformation();
@@ -84,7 +85,8 @@ CConstraintDyn_ode::CConstraintDyn_ode(CRigidBodyDyn* parentBody,CRigidBodyDyn*
 
 //    if ((childBody->isBodyKinematic())
     { // this is a dynamic object
-        dBodySetAutoDisableFlag(childRigidBody,0);
+        if (CRigidBodyContainerDyn::getSleepMode()!=dyn_sleep_on) // in sleep mode, the island can sleep as a whole
+            dBodySetAutoDisableFlag(childRigidBody,0);
         dBodyEnable(childRigidBody);
     }
     bbtr=childBody->getInertiaFrameTransformation();
@@ -305,7 +307,8 @@ CConstraintDyn_ode::CConstraintDyn_ode(CRigidBodyDyn* parentBody,CRigidBodyDyn*
 
     //    if ((parentBody->isBodyKinematic())
     { // this is a dynamic object
-        dBodySetAutoDisableFlag(parentRigidBody,0);
+        if (CRigidBodyContainerDyn::getSleepMode()!=dyn_sleep_on) // in sleep mode, the island can sleep as a whole
+            dBodySetAutoDisableFlag(parentRigidBody,0);
         dBodyEnable(parentRigidBody);
     }
     batr=parentBody->getInertiaFrameTransformation();
@@ -314,7 +317,8 @@ CConstraintDyn_ode::CConstraintDyn_ode(CRigidBodyDyn* parentBody,CRigidBodyDyn*
 
 //    if ((childBody->isBodyKinematic())
     { // this is a dynamic object
-        dBodySetAutoDisableFlag(childRigidBody,0);
+        if (CRigidBodyContainerDyn::getSleepMode()!=dyn_sleep_on) // in sleep mode, the island can sleep as a whole
+            dBodySetAutoDisableFlag(childRigidBody,0);
         dBodyEnable(childRigidBody);
     }
     bbtr=childBody->getInertiaFrameTransformation();
@@ -794,46 +798,20 @@ void CConstraintDyn_ode::_setPrismaticJointLimits(CDummyJoint* joint)
     dJointSetSliderParam(_odeConstraint,dParamHiStop,(jiMin+jiRange)*linScaling); // ********** SCALING
 }
 
-void CConstraintDyn_ode::_handleRevoluteMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_ode::_getRevoluteMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
 {
-    float torqueScaling=CRigidBodyContainerDyn::getTorqueScalingFactorDyn();
-    float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-
-    float e;
-
     if (_simGetJointPositionInterval(joint,nullptr,nullptr)==0)
-        e=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset,getHingeAngle()); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
+        error=getAngleMinusAlpha(_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset,getHingeAngle()); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
     else
-        e=_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset-getHingeAngle(); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-
-    inputValuesFloat[0]=getHingeAngle()-_nonCyclicRevoluteJointPositionOffset;
-
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
-    dJointSetHingeParam(_odeConstraint,dParamFMax,forceToApply*torqueScaling); // ********** SCALING
-    dJointSetHingeParam(_odeConstraint,dParamVel,velocityToApply);
+        error=_simGetDynamicMotorTargetPosition(joint)+_nonCyclicRevoluteJointPositionOffset-getHingeAngle(); // since 18/11/2012 we are using an offset between CoppeliaSim joint position and Bullet/ODE joint position to avoid problems with limits (revolute joints only)
+    position=getHingeAngle()-_nonCyclicRevoluteJointPositionOffset;
+}
+
+void CConstraintDyn_ode::_applyRevoluteMotorController(float velocity,float force)
+{
+    float torqueScaling=CRigidBodyContainerDyn::getTorqueScalingFactorDyn();
+    dJointSetHingeParam(_odeConstraint,dParamFMax,force*torqueScaling); // ********** SCALING
+    dJointSetHingeParam(_odeConstraint,dParamVel,velocity);
 }
 
 
@@ -870,40 +848,19 @@ void CConstraintDyn_ode::_handleRevoluteMotor_controllerDisabled(CDummyJoint* jo
     }
 }
 
-void CConstraintDyn_ode::_handlePrismaticMotor_controllerEnabled(CDummyJoint* joint,int passCnt,int totalPasses)
+void CConstraintDyn_ode::_getPrismaticMotorControllerInputs(CDummyJoint* joint,float& position,float& error)
 {
     float linScaling=CRigidBodyContainerDyn::getPositionScalingFactorDyn();
+    error=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled()/linScaling; // ********** SCALING
+    position=getSliderPositionScaled()/linScaling; // Scaling was forgotten and added on 22/8/2013, thanks to Ruediger Dehmel.
+}
+
+void CConstraintDyn_ode::_applyPrismaticMotorController(float velocity,float force)
+{
     float linVelocityScaling=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn();
     float forceScaling=CRigidBodyContainerDyn::getForceScalingFactorDyn();
-    float dynStepSize=CRigidBodyContainerDyn::getDynamicsInternalTimeStep();
-
-    _targetPositionToHoldAtZeroVelOn_velocityMode=false;
-    float e=_simGetDynamicMotorTargetPosition(joint)-getSliderPositionScaled()/linScaling; // ********** SCALING
-
-    int auxV=0;
-    if (_dynPassCount==0)
-        auxV|=1;
-    int inputValuesInt[5];
-    inputValuesInt[0]=passCnt;
-    inputValuesInt[1]=totalPasses;
-    inputValuesInt[2]=0; // reserved for future ext.
-    inputValuesInt[3]=0; // reserved for future ext.
-    inputValuesInt[4]=0; // reserved for future ext.
-    float inputValuesFloat[7];
-    inputValuesFloat[0]=getSliderPositionScaled()/linScaling; // Scaling was forgotten and added on 22/8/2013, thanks to Ruediger Dehmel.
-    inputValuesFloat[1]=_lastEffortOnJoint;
-    inputValuesFloat[2]=dynStepSize;
-    inputValuesFloat[3]=e;
-    inputValuesFloat[4]=0.0f; // reserved for future ext.
-    inputValuesFloat[5]=0.0f; // reserved for future ext.
-    inputValuesFloat[6]=0.0f; // reserved for future ext.
-    float outputValues[5];
-    _simHandleJointControl(joint,auxV,inputValuesInt,inputValuesFloat,outputValues);
-    float velocityToApply=outputValues[0];
-    float forceToApply=outputValues[1];
-
-    dJointSetSliderParam(_odeConstraint,dParamFMax,forceToApply*forceScaling); // ********** SCALING
-    dJointSetSliderParam(_odeConstraint,dParamVel,velocityToApply*linVelocityScaling); // ********** SCALING
+    dJointSetSliderParam(_odeConstraint,dParamFMax,force*forceScaling); // ********** SCALING
+    dJointSetSliderParam(_odeConstraint,dParamVel,velocity*linVelocityScaling); // ********** SCALING
 }
 
 void CConstraintDyn_ode::_handlePrismaticMotor_controllerDisabled(CDummyJoint* joint,int passCnt,int totalPasses)
@@ -18,7 +18,6 @@ bool CParticleDyn_ode::addToEngineIfNeeded(float parameters[18],int objectID)
 
     CRigidBodyContainerDyn_ode* rbc=(CRigidBodyContainerDyn_ode*)(CRigidBodyContainerDyn::currentRigidBodyContainerDynObject);
     dWorldID odeWorld=rbc->getWorld();
-    dSpaceID space=rbc->getOdeSpace();
 
     float linScaling=CRigidBodyContainerDyn::getPositionScalingFactorDyn();
     float massScaling=CRigidBodyContainerDyn::getMassScalingFactorDyn();
@@ -49,7 +48,7 @@ bool CParticleDyn_ode::addToEngineIfNeeded(float parameters[18],int objectID)
 
     dBodySetData(_odeRigidBody,(void*)(CRigidBodyContainerDyn::getDynamicParticlesIdStart()+objectID));
 
-    _odeGeom=dCreateSphere(space,_size*linScaling/2.0f);  // ********** SCALING
+    _odeGeom=rbc->takeParticleGeom(_size*linScaling/2.0f);  // ********** SCALING
     dGeomSetBody(_odeGeom,_odeRigidBody);
 
     // For now, we disable the auto-disable functionality (because there are problems when removing a kinematic object during simulation(e.g. removing the floor, nothing falls)):
@@ -59,62 +58,17 @@ bool CParticleDyn_ode::addToEngineIfNeeded(float parameters[18],int objectID)
     return(true);
 }
 
-void CParticleDyn_ode::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
-{
-    bool isWaterButInAir=false;
-    if ( (_objectType&sim_particle_ignoresgravity)||(_objectType&sim_particle_water) )
-    {
-        float mass=_massOverVolume*((piValue*_size*_size*_size)/6.0f)*CRigidBodyContainerDyn::getMassScalingFactorDyn(); // ********** SCALING
-        C3Vector f=gravity*-mass*CRigidBodyContainerDyn::getGravityScalingFactorDyn(); // ********** SCALING
-        bool reallyIgnoreGravity=true;
-        if (_objectType&sim_particle_water)
-        { // We ignore gravity only if we are in the water (z<0) (New since 27/6/2011):
-            float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
-            const dReal* pos=dBodyGetPosition(_odeRigidBody);
-            if (pos[2]/ps>=0.0f) // ********** SCALING (not really needed here!)
-            {
-                reallyIgnoreGravity=false;
-                isWaterButInAir=true;
-            }
-        }
-
-        if (reallyIgnoreGravity)
-            dBodyAddForce(_odeRigidBody,f(0),f(1),f(2));
-    }
-    if ((linearFluidFrictionCoeff!=0.0f)||(quadraticFluidFrictionCoeff!=0.0f)||(linearAirFrictionCoeff!=0.0f)||(quadraticAirFrictionCoeff!=0.0f))
-    { // New since 27/6/2011
-        float lfc=linearFluidFrictionCoeff;
-        float qfc=quadraticFluidFrictionCoeff;
-        if (isWaterButInAir)
-        {
-            lfc=linearAirFrictionCoeff;
-            qfc=quadraticAirFrictionCoeff;
-        }
-        C3Vector vVect;
-
-        const dReal* lvel=dBodyGetLinearVel(_odeRigidBody);
-        vVect.set((float)lvel[0],(float)lvel[1],(float)lvel[2]);
-
-        float v=vVect.getLength();
-        if (v!=0.0f)
-        {
-            float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
-            float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
-            v/=vs; // ********** SCALING
-            C3Vector nv(vVect.getNormalized()*-1.0f);
-            C3Vector f(nv*(v*lfc+v*v*qfc));
-            f*=fs; // ********** SCALING
-
-            dBodyAddForce(_odeRigidBody,f(0),f(1),f(2));
-        }
-    }
+void CParticleDyn_ode::applyFluidForce(const C3Vector& force)
+{ // scaled
+    dBodyAddForce(_odeRigidBody,force(0),force(1),force(2));
 }
 
 void CParticleDyn_ode::removeFromEngine()
 {
     if (_initializationState==1)
     {
-        dGeomDestroy(_odeGeom);
+        CRigidBodyContainerDyn_ode* rbc=(CRigidBodyContainerDyn_ode*)(CRigidBodyContainerDyn::currentRigidBodyContainerDynObject);
+        rbc->poolParticleGeom(_odeGeom);
         dBodyDestroy(_odeRigidBody);
         _initializationState=2;
     }
@@ -132,3 +86,12 @@ void CParticleDyn_ode::updatePosition()
         _currentPosition(2)=pos[2]/linScaling; // ********** SCALING
     }
 }
+
+C3Vector CParticleDyn_ode::getVelocity()
+{
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
+    const dReal* lvel=dBodyGetLinearVel(_odeRigidBody);
+    return(C3Vector((float)lvel[0]/vs,(float)lvel[1]/vs,(float)lvel[2]/vs));
+}
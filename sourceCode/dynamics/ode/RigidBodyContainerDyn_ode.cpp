@@ -2,6 +2,7 @@
 #include "CollShapeDyn_ode.h"
 #include "RigidBodyDyn_ode.h"
 #include "ConstraintDyn_ode.h"
+#include "StepProfiler.h"
 #include "simLib.h"
 
 // Modifications in ODE source:
@@ -12,7 +13,7 @@
 // ODE_MARC_MOD4
 // ODE_MARC_MOD5
 
-CRigidBodyContainerDyn_ode::CRigidBodyContainerDyn_ode()
+CRigidBodyContainerDyn_ode::CRigidBodyContainerDyn_ode(const SDynWorldSettings& settings) : CRigidBodyContainerDyn(settings)
 {
     _dynamicsCalculationPasses=0;
     _allRigidBodiesIndex.resize(CRigidBodyContainerDyn::get3dObjectIdEnd()-CRigidBodyContainerDyn::get3dObjectIdStart(),nullptr);
@@ -41,6 +42,9 @@ CRigidBodyContainerDyn_ode::CRigidBodyContainerDyn_ode()
         _simSetGeomProxyDynamicsFullRefreshFlag((void*)_simGetGeomProxyFromShape(_simGetObjectFromIndex(sim_object_shape_type,i)),true);
 
     _nextRigidBodyID=0;
+    _odeFeedbackPoolUsed=0;
+    _odeSphereQueryGeom=nullptr;
+    _odeQuickStep=false;
 }
 
 CRigidBodyContainerDyn_ode::~CRigidBodyContainerDyn_ode()
@@ -55,16 +59,40 @@ CRigidBodyContainerDyn_ode::~CRigidBodyContainerDyn_ode()
     }
 
     particleCont.removeAllParticles();
+    if (_odeSphereQueryGeom!=nullptr)
+        dGeomDestroy(_odeSphereQueryGeom);
+    for (int i=0;i<int(_odeParticleGeomPool.size());i++)
+        dGeomDestroy(_odeParticleGeomPool[i]);
     dJointGroupEmpty(_odeContactGroup);
     dJointGroupDestroy(_odeContactGroup);
     dSpaceDestroy(_odeSpace);
     dWorldDestroy(_odeWorld);
     dCloseODE();
+    for (int i=0;i<int(_odeFeedbackPool.size());i++)
+        delete _odeFeedbackPool[i];
 
     // Important to destroy it at the very end, otherwise we have memory leaks with bullet (b/c we first need to remove particles from the Bullet world!)
     particleCont.removeAllObjects();
 }
 
+dGeomID CRigidBodyContainerDyn_ode::takeParticleGeom(float radius)
+{ // scaled. Returns a sphere that is part of the space. ODE geoms can't be shared among bodies, they are recycled instead
+    if (_odeParticleGeomPool.size()==0)
+        return(dCreateSphere(_odeSpace,radius));
+    dGeomID retVal=_odeParticleGeomPool[_odeParticleGeomPool.size()-1];
+    _odeParticleGeomPool.pop_back();
+    dGeomSphereSetRadius(retVal,radius);
+    dSpaceAdd(_odeSpace,retVal);
+    return(retVal);
+}
+
+void CRigidBodyContainerDyn_ode::poolParticleGeom(dGeomID geom)
+{ // detaches the geom from its body and from the space
+    dGeomSetBody(geom,0);
+    dSpaceRemove(_odeSpace,geom);
+    _odeParticleGeomPool.push_back(geom);
+}
+
 int CRigidBodyContainerDyn_ode::getEngineInfo(int& engine,int data1[4],char* data2,char* data3)
 {
     engine=sim_physics_ode;
@@ -74,13 +102,12 @@ int CRigidBodyContainerDyn_ode::getEngineInfo(int& engine,int data1[4],char* dat
 }
 
 void CRigidBodyContainerDyn_ode::_odeCollisionCallbackStatic(void* data,dGeomID o1,dGeomID o2)
-{ // this function is static and will call the corresponding function of the current object:
-    ((CRigidBodyContainerDyn_ode*)currentRigidBodyContainerDynObject)->_odeCollisionCallback(data,o1,o2);
+{ // this function is static and will call the corresponding function of the container passed to dSpaceCollide:
+    ((CRigidBodyContainerDyn_ode*)data)->_odeCollisionCallback(data,o1,o2);
 }
 
 void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGeomID o2)
 {
-    float linScaling=CRigidBodyContainerDyn::getPositionScalingFactorDyn();
     dBodyID b1=dGeomGetBody(o1);
     dBodyID b2=dGeomGetBody(o2);
     
@@ -90,11 +117,19 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
     }
     else
     {
-        CDummyShape* shapeA=(CDummyShape*)_simGetObject((unsigned long long)dBodyGetData(b1));
-        CDummyShape* shapeB=(CDummyShape*)_simGetObject((unsigned long long)dBodyGetData(b2));
+        DYN_PROFILE_FILTERED_PAIR(this);
+        int dataA=(unsigned long long)dBodyGetData(b1);
+        int dataB=(unsigned long long)dBodyGetData(b2);
+        const SCollisionFilter* filterA=getCollisionFilter(dataA);
+        const SCollisionFilter* filterB=getCollisionFilter(dataB);
+        CDummyShape* shapeA=nullptr;
+        if (filterA!=nullptr)
+            shapeA=filterA->shape;
+        CDummyShape* shapeB=nullptr;
+        if (filterB!=nullptr)
+            shapeB=filterB->shape;
 
         bool canCollide=false;
-        dContact contact[64];
         // version,contactCount,contactMode
         int dataInt[3]={0,4,4+8+16+2048}; //dContactBounce|dContactSoftCFM|dContactApprox1|dContactSoftERP};
         //                    mu,mu2,bounce,bunce_vel,soft_erp,soft_cfm,motion1,motion2,motionN,slip1,slip2,fdir1x,fdir1y,fdir1z
@@ -105,47 +140,54 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
 
         if ( (shapeA!=nullptr)&&(shapeB!=nullptr) )
         { // regular case (shape-shape)
-            unsigned int collFA=_simGetDynamicCollisionMask(shapeA);
-            unsigned int collFB=_simGetDynamicCollisionMask(shapeB);
-            canCollide=(_simIsShapeDynamicallyRespondable(shapeA)&&_simIsShapeDynamicallyRespondable(shapeB))&&((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_respondable)!=0)&&((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_respondable)!=0);
-            if (_simGetLastParentForLocalGlobalCollidable(shapeA)==_simGetLastParentForLocalGlobalCollidable(shapeB))
+            unsigned int collFA=filterA->collisionMask;
+            unsigned int collFB=filterB->collisionMask;
+            const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+            canCollide=((filterA->flags&filterB->flags&respFlags)==respFlags);
+            if (filterA->localGlobalCollidableRoot==filterB->localGlobalCollidableRoot)
                 canCollide=canCollide&&(collFA&collFB&0x00ff); // we are local
             else
                 canCollide=canCollide&&(collFA&collFB&0xff00); // we are global
-            if ( (_simIsShapeDynamicallyStatic(shapeA)||((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_dynamic)==0))&&
-                (_simIsShapeDynamicallyStatic(shapeB)||((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_dynamic)==0)) )
+            if ((filterA->flags&filterB->flags&dyn_collfilter_staticornottreedynamic)!=0)
                 canCollide=false;
             if (canCollide)
             { // Ok, the two object have flags that make them respondable to each other
-                CDummyGeomProxy* shapeAProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shapeA);
-                CDummyGeomWrap* shapeAWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeAProxy);
-                CDummyGeomProxy* shapeBProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shapeB);
-                CDummyGeomWrap* shapeBWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeBProxy);
-
-                // Following parameter retrieval is OLD. Use instead following functions:
-                // - simGetEngineFloatParameter
-                // - simGetEngineInt32Parameter
-                // - simGetEngineBoolParameter
-                int maxContactsA,maxContactsB;
-                float frictionA,frictionB;
-                float cfmA,cfmB;
-                float erpA,erpB;
-                _simGetOdeMaxContactFrictionCFMandERP(shapeAWrap,&maxContactsA,&frictionA,&cfmA,&erpA);
-                _simGetOdeMaxContactFrictionCFMandERP(shapeBWrap,&maxContactsB,&frictionB,&cfmB,&erpB);
-                dataInt[1]=(maxContactsA+maxContactsB)/2;
-                if (dataInt[1]<1)
-                    dataInt[1]=1;
-                dataFloat[0]=frictionA*frictionB;
-                dataFloat[4]=(erpA+erpB)/2.0f;
-                dataFloat[5]=(cfmA+cfmB)/2.0f;
-                objID1=_simGetObjectID(shapeA);
-                objID2=_simGetObjectID(shapeB);
+                SContactMaterial* material;
+                if (!_getContactMaterial(dataA,dataB,material))
+                {
+                    CDummyGeomProxy* shapeAProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shapeA);
+                    CDummyGeomWrap* shapeAWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeAProxy);
+                    CDummyGeomProxy* shapeBProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shapeB);
+                    CDummyGeomWrap* shapeBWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeBProxy);
+
+                    // Following parameter retrieval is OLD. Use instead following functions:
+                    // - simGetEngineFloatParameter
+                    // - simGetEngineInt32Parameter
+                    // - simGetEngineBoolParameter
+                    int maxContactsA,maxContactsB;
+                    float frictionA,frictionB;
+                    float cfmA,cfmB;
+                    float erpA,erpB;
+                    _simGetOdeMaxContactFrictionCFMandERP(shapeAWrap,&maxContactsA,&frictionA,&cfmA,&erpA);
+                    _simGetOdeMaxContactFrictionCFMandERP(shapeBWrap,&maxContactsB,&frictionB,&cfmB,&erpB);
+                    material->maxContacts=(maxContactsA+maxContactsB)/2;
+                    if (material->maxContacts<1)
+                        material->maxContacts=1;
+                    material->friction=frictionA*frictionB;
+                    material->restitution=0.0f;
+                    material->softErp=(erpA+erpB)/2.0f;
+                    material->softCfm=(cfmA+cfmB)/2.0f;
+                }
+                dataInt[1]=material->maxContacts;
+                dataFloat[0]=material->friction;
+                dataFloat[4]=material->softErp;
+                dataFloat[5]=material->softCfm;
+                objID1=dataA;
+                objID2=dataB;
             }
         }
         else
         { // particle-shape or particle-particle case:
-            int dataA=(unsigned long long)dBodyGetData(b1);
-            int dataB=(unsigned long long)dBodyGetData(b2);
             if ( (shapeA==nullptr)&&(shapeB==nullptr) )
             { // particle-particle case:
                 CParticleObject* pa=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
@@ -167,22 +209,22 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
             }
             else
             { // particle-shape case:
-                CDummyShape* shape=nullptr;
+                const SCollisionFilter* filter=nullptr;
                 CParticleObject* particle=nullptr;
-                if (shapeA!=nullptr)
+                if (filterA!=nullptr)
                 {
-                    shape=shapeA;
-                    objID1=_simGetObjectID(shapeA);
+                    filter=filterA;
+                    objID1=dataA;
                 }
                 else
                 {
                     particle=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                     objID1=dataA;
                 }
-                if (shapeB!=nullptr)
+                if (filterB!=nullptr)
                 {
-                    shape=shapeB;
-                    objID2=_simGetObjectID(shapeB);
+                    filter=filterB;
+                    objID2=dataB;
                 }
                 else
                 {
@@ -192,25 +234,35 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
 
                 if (particle!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
                 {
-                    canCollide=_simIsShapeDynamicallyRespondable(shape)&&(_simGetDynamicCollisionMask(shape)&particle->getShapeRespondableMask()&0xff00)&&((_simGetTreeDynamicProperty(shape)&sim_objdynprop_respondable)!=0); // we are global
+                    const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+                    canCollide=((filter->flags&respFlags)==respFlags)&&(filter->collisionMask&particle->getShapeRespondableMask()&0xff00); // we are global
                     if (canCollide)
                     {
-                        dataInt[1]=1;
-                        CDummyGeomProxy* shapeProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(shape);
-                        CDummyGeomWrap* shapeWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeProxy);
-
-                        // Following parameter retrieval is OLD. Use instead following functions:
-                        // - simGetEngineFloatParameter
-                        // - simGetEngineInt32Parameter
-                        // - simGetEngineBoolParameter
-                        int maxContacts;
-                        float friction;
-                        float cfm;
-                        float erp;
-                        _simGetOdeMaxContactFrictionCFMandERP(shapeWrap,&maxContacts,&friction,&cfm,&erp);
-                        dataFloat[0]=friction*particle->parameters[2];
-                        dataFloat[4]=(erp+particle->parameters[3])/2.0f;
-                        dataFloat[5]=(cfm+particle->parameters[4])/2.0f;
+                        SContactMaterial* material;
+                        if (!_getContactMaterial((filter==filterA)?dataA:dataB,particle,material))
+                        {
+                            CDummyGeomProxy* shapeProxy=(CDummyGeomProxy*)_simGetGeomProxyFromShape(filter->shape);
+                            CDummyGeomWrap* shapeWrap=(CDummyGeomWrap*)_simGetGeomWrapFromGeomProxy(shapeProxy);
+
+                            // Following parameter retrieval is OLD. Use instead following functions:
+                            // - simGetEngineFloatParameter
+                            // - simGetEngineInt32Parameter
+                            // - simGetEngineBoolParameter
+                            int maxContacts;
+                            float friction;
+                            float cfm;
+                            float erp;
+                            _simGetOdeMaxContactFrictionCFMandERP(shapeWrap,&maxContacts,&friction,&cfm,&erp);
+                            material->maxContacts=1;
+                            material->friction=friction*particle->parameters[2];
+                            material->restitution=0.0f;
+                            material->softErp=(erp+particle->parameters[3])/2.0f;
+                            material->softCfm=(cfm+particle->parameters[4])/2.0f;
+                        }
+                        dataInt[1]=material->maxContacts;
+                        dataFloat[0]=material->friction;
+                        dataFloat[4]=material->softErp;
+                        dataFloat[5]=material->softCfm;
                     }
                 }
             }
@@ -218,7 +270,15 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
 
         if (canCollide)
         {
-            bool canReallyCollide=(_simHandleCustomContact(objID1,objID2,sim_physics_ode,dataInt,dataFloat)!=0);
+            if (_isContactBatchingActive())
+            { // the contact batch callback is called for all pairs of this pass, once all were found
+                _contacts.reserveCounted(_odeContactBatchGeoms,_odeContactBatchGeoms.size()+2);
+                _odeContactBatchGeoms.push_back(o1);
+                _odeContactBatchGeoms.push_back(o2);
+                _addToContactBatch(objID1,objID2,dataInt,dataFloat);
+                return;
+            }
+            bool canReallyCollide=(_handleCustomContact(objID1,objID2,sim_physics_ode,dataInt,dataFloat)!=0);
             /* removed on 19/2/2013
             bool canReallyCollide=true;
             int callbackCount=_simGetContactCallbackCount();
@@ -241,76 +301,107 @@ void CRigidBodyContainerDyn_ode::_odeCollisionCallback(void* data,dGeomID o1,dGe
             }
             */
             if (canReallyCollide)
+                _addOdeContacts(o1,o2,dataInt,dataFloat);
+        }
+    }
+}
+
+void CRigidBodyContainerDyn_ode::_handleOdeContactBatch()
+{ // pairs are handled in the order they were found, i.e. contacts are created in the same order as with the per-pair handling
+    _handleContactBatch(sim_physics_ode);
+    for (int i=0;i<int(_contactBatch.results.size());i++)
+    {
+        if (_contactBatch.results[i]!=0)
+            _addOdeContacts(_odeContactBatchGeoms[2*i+0],_odeContactBatchGeoms[2*i+1],&_contactBatch.dataInt[3*i],&_contactBatch.dataFloat[14*i]);
+    }
+    _odeContactBatchGeoms.clear();
+    _contactBatch.objectIDs.clear();
+    _contactBatch.results.clear();
+    _contactBatch.dataInt.clear();
+    _contactBatch.dataFloat.clear();
+}
+
+void CRigidBodyContainerDyn_ode::_addOdeContacts(dGeomID o1,dGeomID o2,const int dataInt[3],const float dataFloat[14])
+{
+    float linScaling=CRigidBodyContainerDyn::getPositionScalingFactorDyn();
+    dBodyID b1=dGeomGetBody(o1);
+    dBodyID b2=dGeomGetBody(o2);
+    dContact contact[64];
+    // dataInt[0] represents the version. with 0, we have 3 values in dataInt, and 14 values in dataFloat!
+    int contactMode=0;
+    if (dataInt[2]&1)
+        contactMode|=dContactMu2;
+    if (dataInt[2]&2)
+        contactMode|=dContactFDir1;
+    if (dataInt[2]&4)
+        contactMode|=dContactBounce;
+    if (dataInt[2]&8)
+        contactMode|=dContactSoftERP;
+    if (dataInt[2]&16)
+        contactMode|=dContactSoftCFM;
+    if (dataInt[2]&32)
+        contactMode|=dContactMotion1;
+    if (dataInt[2]&64)
+        contactMode|=dContactMotion2;
+    if (dataInt[2]&128)
+        contactMode|=dContactSlip1;
+    if (dataInt[2]&256)
+        contactMode|=dContactSlip2;
+    if (dataInt[2]&512)
+        contactMode|=dContactApprox1_1;
+    if (dataInt[2]&1024)
+        contactMode|=dContactApprox1_2;
+    if (dataInt[2]&2048)
+        contactMode|=dContactApprox1;
+
+    for (int i=0;i<dataInt[1];i++)
+    {
+        contact[i].surface.mode=contactMode;//|dContactSlip1|dContactSlip2;//|dContactSoftERP;
+        contact[i].surface.mu=dataFloat[0];//0.25f; // use 0.25f as CoppeliaSim default value!
+        contact[i].surface.mu2=dataFloat[1];
+        contact[i].surface.bounce=dataFloat[2];
+        contact[i].surface.bounce_vel=dataFloat[3];
+        contact[i].surface.soft_erp=dataFloat[4];//0.25f; // 0.2 appears not bouncy, 0.4 appears medium-bouncy. default is around 0.5
+        contact[i].surface.soft_cfm=dataFloat[5];//0.0f;
+        contact[i].surface.motion1=dataFloat[6];
+        contact[i].surface.motion2=dataFloat[7];
+        contact[i].surface.motionN=dataFloat[8];
+        contact[i].surface.slip1=dataFloat[9];
+        contact[i].surface.slip2=dataFloat[10];
+        contact[i].fdir1[0]=dataFloat[11];
+        contact[i].fdir1[1]=dataFloat[12];
+        contact[i].fdir1[2]=dataFloat[13];
+    }
+    int numc=dCollide(o1,o2,dataInt[1],&contact[0].geom,sizeof(dContact));
+    if (numc) 
+    {
+        _contacts.reserveCounted(_odeContactsRegisteredForFeedback,_odeContactsRegisteredForFeedback.size()+numc);
+        _contacts.reserveCounted(_contactPoints,_contactPoints.size()+3*numc);
+        for (int i=0;i<numc;i++) 
+        {
+            dJointID c=dJointCreateContact(_odeWorld,_odeContactGroup,contact+i);
+            dJointAttach(c,b1,b2);
+
+            if (_odeFeedbackPoolUsed>=int(_odeFeedbackPool.size()))
             {
-                // dataInt[0] represents the version. with 0, we have 3 values in dataInt, and 14 values in dataFloat!
-                int contactMode=0;
-                if (dataInt[2]&1)
-                    contactMode|=dContactMu2;
-                if (dataInt[2]&2)
-                    contactMode|=dContactFDir1;
-                if (dataInt[2]&4)
-                    contactMode|=dContactBounce;
-                if (dataInt[2]&8)
-                    contactMode|=dContactSoftERP;
-                if (dataInt[2]&16)
-                    contactMode|=dContactSoftCFM;
-                if (dataInt[2]&32)
-                    contactMode|=dContactMotion1;
-                if (dataInt[2]&64)
-                    contactMode|=dContactMotion2;
-                if (dataInt[2]&128)
-                    contactMode|=dContactSlip1;
-                if (dataInt[2]&256)
-                    contactMode|=dContactSlip2;
-                if (dataInt[2]&512)
-                    contactMode|=dContactApprox1_1;
-                if (dataInt[2]&1024)
-                    contactMode|=dContactApprox1_2;
-                if (dataInt[2]&2048)
-                    contactMode|=dContactApprox1;
-
-                for (int i=0;i<dataInt[1];i++)
-                {
-                    contact[i].surface.mode=contactMode;//|dContactSlip1|dContactSlip2;//|dContactSoftERP;
-                    contact[i].surface.mu=dataFloat[0];//0.25f; // use 0.25f as CoppeliaSim default value!
-                    contact[i].surface.mu2=dataFloat[1];
-                    contact[i].surface.bounce=dataFloat[2];
-                    contact[i].surface.bounce_vel=dataFloat[3];
-                    contact[i].surface.soft_erp=dataFloat[4];//0.25f; // 0.2 appears not bouncy, 0.4 appears medium-bouncy. default is around 0.5
-                    contact[i].surface.soft_cfm=dataFloat[5];//0.0f;
-                    contact[i].surface.motion1=dataFloat[6];
-                    contact[i].surface.motion2=dataFloat[7];
-                    contact[i].surface.motionN=dataFloat[8];
-                    contact[i].surface.slip1=dataFloat[9];
-                    contact[i].surface.slip2=dataFloat[10];
-                    contact[i].fdir1[0]=dataFloat[11];
-                    contact[i].fdir1[1]=dataFloat[12];
-                    contact[i].fdir1[2]=dataFloat[13];
-                }
-                int numc=dCollide(o1,o2,dataInt[1],&contact[0].geom,sizeof(dContact));
-                if (numc) 
-                {
-                    for (int i=0;i<numc;i++) 
-                    {
-                        dJointID c=dJointCreateContact(_odeWorld,_odeContactGroup,contact+i);
-                        dJointAttach(c,b1,b2);
-
-                        dJointFeedback* feedback=new dJointFeedback;
-                        dJointSetFeedback(c,feedback);
-                        SOdeContactData ctct;
-                        ctct.jointID=c;
-                        ctct.objectID1=(unsigned long long)dBodyGetData(b1);
-                        ctct.objectID2=(unsigned long long)dBodyGetData(b2);
-                        ctct.positionScaled=C3Vector(contact[i].geom.pos[0],contact[i].geom.pos[1],contact[i].geom.pos[2]);
-                        ctct.normalVector=C3Vector(contact[i].geom.normal[0],contact[i].geom.normal[1],contact[i].geom.normal[2]);
-                        _odeContactsRegisteredForFeedback.push_back(ctct);
-
-                        _contactPoints.push_back(contact[i].geom.pos[0]/linScaling);
-                        _contactPoints.push_back(contact[i].geom.pos[1]/linScaling);
-                        _contactPoints.push_back(contact[i].geom.pos[2]/linScaling);
-                    }
-                }
+                _odeFeedbackPool.push_back(new dJointFeedback);
+                _contacts.countAllocation();
             }
+            dJointFeedback* feedback=_odeFeedbackPool[_odeFeedbackPoolUsed++];
+            dJointSetFeedback(c,feedback);
+            SOdeContactData ctct;
+            ctct.jointID=c;
+            ctct.objectID1=(unsigned long long)dBodyGetData(b1);
+            ctct.objectID2=(unsigned long long)dBodyGetData(b2);
+            ctct.positionScaled=C3Vector(contact[i].geom.pos[0],contact[i].geom.pos[1],contact[i].geom.pos[2]);
+            ctct.normalVector=C3Vector(contact[i].geom.normal[0],contact[i].geom.normal[1],contact[i].geom.normal[2]);
+            _odeContactsRegisteredForFeedback.push_back(ctct);
+
+            _contactPoints.push_back(contact[i].geom.pos[0]/linScaling);
+            _contactPoints.push_back(contact[i].geom.pos[1]/linScaling);
+            _contactPoints.push_back(contact[i].geom.pos[2]/linScaling);
+            if (contact[i].geom.depth/linScaling>_stepMaxPenetration)
+                _stepMaxPenetration=contact[i].geom.depth/linScaling; // ********** SCALING
         }
     }
 }
@@ -349,6 +440,56 @@ dSpaceID CRigidBodyContainerDyn_ode::getOdeSpace()
     return(_odeSpace);
 }
 
+int CRigidBodyContainerDyn_ode::collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts)
+{
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    if (_odeSphereQueryGeom==nullptr)
+        _odeSphereQueryGeom=dCreateSphere(0,radius*ps);
+    else
+        dGeomSphereSetRadius(_odeSphereQueryGeom,radius*ps);
+    dGeomSetPosition(_odeSphereQueryGeom,center(0)*ps,center(1)*ps,center(2)*ps);
+    _odeSphereQuery.respondableMask=respondableMask;
+    _odeSphereQuery.contacts=contacts;
+    _odeSphereQuery.maxContacts=maxContacts;
+    _odeSphereQuery.contactCount=0;
+    dSpaceCollide2(_odeSphereQueryGeom,(dGeomID)_odeSpace,this,&_odeSphereQueryCallbackStatic);
+    return(_odeSphereQuery.contactCount);
+}
+
+void CRigidBodyContainerDyn_ode::_odeSphereQueryCallbackStatic(void* data,dGeomID o1,dGeomID o2)
+{
+    CRigidBodyContainerDyn_ode* container=(CRigidBodyContainerDyn_ode*)data;
+    SOdeSphereQuery& query=container->_odeSphereQuery;
+    dGeomID sphere=container->_odeSphereQueryGeom;
+    dGeomID other=(o1==sphere)?o2:o1;
+    if (dGeomIsSpace(other))
+    {
+        dSpaceCollide2(sphere,other,data,&_odeSphereQueryCallbackStatic);
+        return;
+    }
+    dBodyID body=dGeomGetBody(other);
+    if ( (body==0)||(query.contactCount>=query.maxContacts) )
+        return;
+    int shapeID=(unsigned long long)dBodyGetData(body);
+    if (!container->_canParticleCollideWithShape(shapeID,query.respondableMask)) // particles that are engine bodies are also skipped here
+        return;
+    dContactGeom contacts[4];
+    int cnt=dCollide(sphere,other,4,contacts,sizeof(dContactGeom));
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    for (int i=0;i<cnt;i++)
+    {
+        if (query.contactCount>=query.maxContacts)
+            break;
+        if (contacts[i].depth<=0.0)
+            continue;
+        SParticleShapeContact& contact=query.contacts[query.contactCount++];
+        contact.position.set(contacts[i].pos[0]/ps,contacts[i].pos[1]/ps,contacts[i].pos[2]/ps);
+        contact.normal.set(contacts[i].normal[0],contacts[i].normal[1],contacts[i].normal[2]); // moving the sphere along the normal separates it
+        contact.depth=contacts[i].depth/ps;
+        contact.shapeID=shapeID;
+    }
+}
+
 void CRigidBodyContainerDyn_ode::_createDependenciesBetweenJoints()
 {
 }
@@ -358,16 +499,29 @@ void CRigidBodyContainerDyn_ode::_removeDependenciesBetweenJoints(CConstraintDyn
 }
 
 void CRigidBodyContainerDyn_ode::_stepDynamics(float dt,int pass)
+{
+    _stepDynamicsCollisions(dt,pass);
+    _stepDynamicsIntegration(dt,pass);
+}
+
+bool CRigidBodyContainerDyn_ode::_stepDynamicsCollisions(float dt,int pass)
+{ // the contact joints are created here, with all the simulator calls they need
+    dSpaceCollide(_odeSpace,this,&_odeCollisionCallbackStatic);
+    _handleOdeContactBatch();
+    _odeQuickStep=(simGetEngineBoolParameter(sim_ode_global_quickstep,-1,nullptr,nullptr)!=0);
+    return(true);
+}
+
+void CRigidBodyContainerDyn_ode::_stepDynamicsIntegration(float dt,int pass)
 {
     dynReal linScaling=(dynReal)CRigidBodyContainerDyn::getPositionScalingFactorDyn();
     dynReal forceScaling=(dynReal)CRigidBodyContainerDyn::getForceScalingFactorDyn();
-    dSpaceCollide(_odeSpace,0,&_odeCollisionCallbackStatic);
-    if (simGetEngineBoolParameter(sim_ode_global_quickstep,-1,nullptr,nullptr)!=0)
+    if (_odeQuickStep)
         dWorldQuickStep(_odeWorld,dt);
     else
         dWorldStep(_odeWorld,dt);
 
-    // We need to destroy the structure for force feedback:
+    // The structures for force feedback go back to the pool:
     for (int ctfb=0;ctfb<int(_odeContactsRegisteredForFeedback.size());ctfb++)
     {
         SOdeContactData ctct=_odeContactsRegisteredForFeedback[ctfb];
@@ -385,10 +539,10 @@ void CRigidBodyContainerDyn_ode::_stepDynamics(float dt,int pass)
         ci.surfaceNormal=n;
         ci.directionAndAmplitude=f;
         ci.directionAndAmplitude/=dReal(forceScaling); // ********** SCALING
-        delete fbck;
-        _contactInfo.push_back(ci);
+        _contacts.addContact(ci);
     }
     _odeContactsRegisteredForFeedback.clear();
+    _odeFeedbackPoolUsed=0;
 
     dJointGroupEmpty(_odeContactGroup);
 
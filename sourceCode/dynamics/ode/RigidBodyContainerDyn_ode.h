@@ -12,11 +12,19 @@ struct SOdeContactData
     C3Vector normalVector;
 };
 
+struct SOdeSphereQuery
+{ // state of the current collideSphereWithShapes call
+    int respondableMask;
+    SParticleShapeContact* contacts;
+    int maxContacts;
+    int contactCount;
+};
+
 class CRigidBodyContainerDyn_ode : public CRigidBodyContainerDyn
 {
 public:
 
-    CRigidBodyContainerDyn_ode();
+    CRigidBodyContainerDyn_ode(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn_ode();
 
     int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
@@ -25,16 +33,31 @@ public:
 
     dWorldID getWorld();
     dSpaceID getOdeSpace();
+    int collideSphereWithShapes(const C3Vector& center,float radius,int respondableMask,SParticleShapeContact* contacts,int maxContacts);
+    dGeomID takeParticleGeom(float radius);
+    void poolParticleGeom(dGeomID geom);
 
 protected:
     void _stepDynamics(float dt,int pass);
+    bool _stepDynamicsCollisions(float dt,int pass);
+    void _stepDynamicsIntegration(float dt,int pass);
     void _createDependenciesBetweenJoints();
     void _removeDependenciesBetweenJoints(CConstraintDyn* theInvolvedConstraint);
 
     static void _odeCollisionCallbackStatic(void* data,dGeomID o1,dGeomID o2);
     void _odeCollisionCallback(void* data,dGeomID o1,dGeomID o2);
+    void _addOdeContacts(dGeomID o1,dGeomID o2,const int dataInt[3],const float dataFloat[14]);
+    void _handleOdeContactBatch();
+    static void _odeSphereQueryCallbackStatic(void* data,dGeomID o1,dGeomID o2);
     dWorldID _odeWorld;
+    bool _odeQuickStep; // read by _stepDynamicsCollisions, used by _stepDynamicsIntegration
     dSpaceID _odeSpace;
     dJointGroupID _odeContactGroup;
     std::vector<SOdeContactData> _odeContactsRegisteredForFeedback;
+    std::vector<dJointFeedback*> _odeFeedbackPool; // reused from step to step
+    int _odeFeedbackPoolUsed;
+    std::vector<dGeomID> _odeContactBatchGeoms; // 2 per pair of _contactBatch
+    dGeomID _odeSphereQueryGeom; // not part of the space, moved to each queried sphere
+    SOdeSphereQuery _odeSphereQuery;
+    std::vector<dGeomID> _odeParticleGeomPool; // particle spheres removed from the space, reused by the next particles
 };
@@ -92,8 +92,20 @@ CRigidBodyDyn_ode::CRigidBodyDyn_ode(CDummyShape* shape,CCollShapeDyn* collShape
     dBodySetLinearDamping(_odeRigidBody,linD);
     dBodySetAngularDamping(_odeRigidBody,angD);
 
-    // For now, we disable the auto-disable functionality (because there are problems when removing a kinematic object during simulation(e.g. removing the floor, nothing falls)):
-    dBodySetAutoDisableFlag(_odeRigidBody,0);
+    if (CRigidBodyContainerDyn::getSleepMode()==dyn_sleep_on)
+    { // resting bodies get disabled. The container wakes them when their support is removed
+        float sleepParams[3];
+        CRigidBodyContainerDyn::getSleepParams(sleepParams);
+        dBodySetAutoDisableFlag(_odeRigidBody,1);
+        dBodySetAutoDisableLinearThreshold(_odeRigidBody,sleepParams[0]*linVelScaling); // ********** SCALING
+        dBodySetAutoDisableAngularThreshold(_odeRigidBody,sleepParams[1]);
+        dBodySetAutoDisableTime(_odeRigidBody,sleepParams[2]);
+        dBodySetAutoDisableSteps(_odeRigidBody,0);
+    }
+    else
+    { // For now, we disable the auto-disable functionality (because there are problems when removing a kinematic object during simulation(e.g. removing the floor, nothing falls)):
+        dBodySetAutoDisableFlag(_odeRigidBody,0);
+    }
 
     _bodyWasInitiallySleeping=false;
     if (_simGetStartSleeping(shape))
@@ -171,6 +183,37 @@ void CRigidBodyDyn_ode::reportVelocityToShape(CDummyShape* shape)
     _simSetShapeDynamicVelocity(shape,lv.data,av.data);
 }
 
+bool CRigidBodyDyn_ode::isSleeping()
+{
+    return((!_bodyIsKinematic)&&(dBodyIsEnabled(_odeRigidBody)==0));
+}
+
+void CRigidBodyDyn_ode::wakeUp()
+{
+    if (!_bodyIsKinematic)
+        dBodyEnable(_odeRigidBody);
+}
+
+C3Vector CRigidBodyDyn_ode::getVelocityAtPosition(const C3Vector& position)
+{
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    float vs=CRigidBodyContainerDyn::getLinearVelocityScalingFactorDyn(); // ********** SCALING
+    dVector3 v;
+    dBodyGetPointVel(_odeRigidBody,position(0)*ps,position(1)*ps,position(2)*ps,v);
+    return(C3Vector(v[0]/vs,v[1]/vs,v[2]/vs));
+}
+
+void CRigidBodyDyn_ode::addForceAtPosition(const C3Vector& force,const C3Vector& position)
+{
+    if (_bodyIsKinematic)
+        return;
+    float ps=CRigidBodyContainerDyn::getPositionScalingFactorDyn(); // ********** SCALING
+    float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
+    _bodyWasInitiallySleeping=false;
+    dBodyEnable(_odeRigidBody);
+    dBodyAddForceAtPos(_odeRigidBody,force(0)*fs,force(1)*fs,force(2)*fs,position(0)*ps,position(1)*ps,position(2)*ps);
+}
+
 void CRigidBodyDyn_ode::handleAdditionalForcesAndTorques(CDummyShape* shape)
 {
     float fs=CRigidBodyContainerDyn::getForceScalingFactorDyn(); // ********** SCALING
@@ -235,3 +278,37 @@ void CRigidBodyDyn_ode::applyCorrectEndConfig_forKinematicBody()
     }
 }
 
+bool CRigidBodyDyn_ode::getState(SRigidBodyState& state)
+{
+    const dReal* pos=dBodyGetPosition(_odeRigidBody);
+    const dReal* quat=dBodyGetQuaternion(_odeRigidBody);
+    const dReal* lvel=dBodyGetLinearVel(_odeRigidBody);
+    const dReal* avel=dBodyGetAngularVel(_odeRigidBody);
+    for (int i=0;i<3;i++)
+    {
+        state.position[i]=pos[i];
+        state.linearVelocity[i]=lvel[i];
+        state.angularVelocity[i]=avel[i];
+    }
+    for (int i=0;i<4;i++)
+        state.quaternion[i]=quat[i];
+    state.activationState=dBodyIsEnabled(_odeRigidBody);
+    return(true);
+}
+
+void CRigidBodyDyn_ode::setState(const SRigidBodyState& state)
+{
+    dBodySetPosition(_odeRigidBody,state.position[0],state.position[1],state.position[2]);
+    dQuaternion dQ;
+    for (int i=0;i<4;i++)
+        dQ[i]=state.quaternion[i];
+    dBodySetQuaternion(_odeRigidBody,dQ);
+    dBodySetLinearVel(_odeRigidBody,state.linearVelocity[0],state.linearVelocity[1],state.linearVelocity[2]);
+    dBodySetAngularVel(_odeRigidBody,state.angularVelocity[0],state.angularVelocity[1],state.angularVelocity[2]);
+    dBodySetForce(_odeRigidBody,0.0,0.0,0.0);
+    dBodySetTorque(_odeRigidBody,0.0,0.0,0.0);
+    if (state.activationState!=0)
+        dBodyEnable(_odeRigidBody);
+    else
+        dBodyDisable(_odeRigidBody);
+}
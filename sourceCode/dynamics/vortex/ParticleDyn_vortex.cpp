@@ -94,49 +94,16 @@ bool CParticleDyn_vortex::addToEngineIfNeeded(float parameters[18],int objectID)
     return(true);
 }
 
-void CParticleDyn_vortex::handleAntiGravityForces_andFluidFrictionForces(const C3Vector& gravity,float linearFluidFrictionCoeff,float quadraticFluidFrictionCoeff,float linearAirFrictionCoeff,float quadraticAirFrictionCoeff)
+void CParticleDyn_vortex::applyFluidForce(const C3Vector& force)
 {
-    bool isWaterButInAir=false;
-    if ( (_objectType&sim_particle_ignoresgravity)||(_objectType&sim_particle_water) )
-    {
-        float mass=_massOverVolume*((piValue*_size*_size*_size)/6.0f);
-        C3Vector f=gravity*-mass;
-        bool reallyIgnoreGravity=true;
-        if (_objectType&sim_particle_water)
-        { // We ignore gravity only if we are in the water (z<0) (New since 27/6/2011):
-            if (float(_vortexRigidBody->getTransform().t()[2])>=0.0f)
-            {
-                reallyIgnoreGravity=false;
-                isWaterButInAir=true;
-            }
-        }
-
-        if (reallyIgnoreGravity)
-        {
-            _vortexRigidBody->addForce(C3Vector2VxVector3(f)); // TODO f is -gravity?
-        }
-    }
-    if ((linearFluidFrictionCoeff!=0.0f)||(quadraticFluidFrictionCoeff!=0.0f)||(linearAirFrictionCoeff!=0.0f)||(quadraticAirFrictionCoeff!=0.0f))
-    { // New since 27/6/2011
-        float lfc=linearFluidFrictionCoeff;
-        float qfc=quadraticFluidFrictionCoeff;
-        if (isWaterButInAir)
-        {
-            lfc=linearAirFrictionCoeff;
-            qfc=quadraticAirFrictionCoeff;
-        }
-        C3Vector vVect;
-
-        vVect = VxVector32C3Vector(_vortexRigidBody->getLinearVelocity());
+    _vortexRigidBody->addForce(C3Vector2VxVector3(force));
+}
 
-        float v=vVect.getLength();
-        if (v!=0.0f)
-        {
-            C3Vector nv(vVect.getNormalized()*-1.0f);
-            C3Vector f(nv*(v*lfc+v*v*qfc));
-            _vortexRigidBody->addForce(C3Vector2VxVector3(f));
-        }
-    }
+C3Vector CParticleDyn_vortex::getVelocity()
+{
+    if (_initializationState!=1)
+        return(_initialVelocityVector);
+    return(VxVector32C3Vector(_vortexRigidBody->getLinearVelocity()));
 }
 
 void CParticleDyn_vortex::removeFromEngine()
@@ -2,6 +2,7 @@
 #include "CollShapeDyn_vortex.h"
 #include "RigidBodyDyn_vortex.h"
 #include "ConstraintDyn_vortex.h"
+#include "StepProfiler.h"
 #include "simLib.h"
 #include <iostream>
 #include "Vx/VxFrame.h"
@@ -52,16 +53,19 @@ public:
     bool isPairEnabled(Vx::VxCollisionGeometry* cg0, Vx::VxCollisionGeometry* cg1)
     {
         bool canCollide = true;
-        CRigidBodyContainerDyn_vortex::_vortexCollisionCallbackStatic((void*)&canCollide, cg0, cg1);
+        container->_vortexCollisionCallback((void*)&canCollide, cg0, cg1);
         return canCollide;
     }
 
+    CRigidBodyContainerDyn_vortex* container; // collision can be multithreaded, we can't rely on the current container
 };
 static int VortexResponsePart = 0;// Vx::VxUniverse::kResponsePart; TODO: why the compiler doesn't find this
 
 class VortexIntersectSubscriber : public Vx::VxUniverse::IntersectSubscriber
 {
 public:
+    CRigidBodyContainerDyn_vortex* container; // collision can be multithreaded, we can't rely on the current container
+
     virtual void notifyDisjoint(Vx::VxUniverse::eIntersectEventType , Vx::VxIntersectResult* )
     {
         // don't need
@@ -111,7 +115,7 @@ public:
             }
         }
         const float sScale = 0.01f;
-        const float sGravity = CRigidBodyContainerDyn::currentRigidBodyContainerDynObject->gravityVectorLength;
+        const float sGravity = container->gravityVectorLength;
         const float sMaxMassScale = 1000;
         if (autoSlip)
         {
@@ -249,7 +253,7 @@ int CRigidBodyContainerDyn_vortex::getEngineInfo(int& engine,int data1[4],char*
     return(DYNAMICS_PLUGIN_VERSION);
 }
 
-CRigidBodyContainerDyn_vortex::CRigidBodyContainerDyn_vortex()
+CRigidBodyContainerDyn_vortex::CRigidBodyContainerDyn_vortex(const SDynWorldSettings& settings) : CRigidBodyContainerDyn(settings)
 {
     int plugin_verbosity = sim_verbosity_default;
     simGetModuleInfo(LIBRARY_NAME,sim_moduleinfo_verbosity,nullptr,&plugin_verbosity);
@@ -347,9 +351,11 @@ CRigidBodyContainerDyn_vortex::CRigidBodyContainerDyn_vortex()
     _vortexWorld->setCollisionMultithreaded(multiThreading);
 
     vortexIntersectSubscriber = new VortexIntersectSubscriber;
+    vortexIntersectSubscriber->container = this;
     _vortexWorld->addIntersectSubscriber(VortexResponsePart, VortexResponsePart, Vx::VxUniverse::kEventFirst, vortexIntersectSubscriber, 0);
     _vortexWorld->addIntersectSubscriber(VortexResponsePart, VortexResponsePart, Vx::VxUniverse::kEventActive, vortexIntersectSubscriber, 0);
     vortexIntersectFilter = new VortexIntersectFilter;
+    vortexIntersectFilter->container = this;
     CRigidBodyDyn_vortex::setVortexFilter(vortexIntersectFilter);
 
 // Following instructions bring the RELEASE version to crash just after a message was output!
@@ -430,41 +436,37 @@ void CRigidBodyContainerDyn_vortex::licenseCheck()
 }
 
 
-void CRigidBodyContainerDyn_vortex::_vortexCollisionCallbackStatic(void* data,Vx::VxCollisionGeometry* o1,Vx::VxCollisionGeometry* o2)
-{ // this function is static and will call the corresponding function of the current object:
-    ((CRigidBodyContainerDyn_vortex*)currentRigidBodyContainerDynObject)->_vortexCollisionCallback(data,o1,o2);
-}
-
 void CRigidBodyContainerDyn_vortex::_vortexCollisionCallback(void* data,Vx::VxCollisionGeometry* o1,Vx::VxCollisionGeometry* o2)
 {
+    DYN_PROFILE_FILTERED_PAIR(this);
     Vx::VxPart* b1=getCollisionGeometryPart(o1);
     Vx::VxPart* b2=getCollisionGeometryPart(o2);
 
-    CDummyShape* shapeA = b1==nullptr?nullptr:(CDummyShape*)_simGetObject(b1->userData().getData("csim").getValueInteger());
-    CDummyShape* shapeB = b2==nullptr?nullptr:(CDummyShape*)_simGetObject(b2->userData().getData("csim").getValueInteger());
+    const SCollisionFilter* filterA = b1==nullptr?nullptr:getCollisionFilter(b1->userData().getData("csim").getValueInteger());
+    const SCollisionFilter* filterB = b2==nullptr?nullptr:getCollisionFilter(b2->userData().getData("csim").getValueInteger());
 
     bool canCollide=false;
     int objID1;
     int objID2;
 
-    if ( (shapeA!=nullptr)&&(shapeB!=nullptr) )
+    if ( (filterA!=nullptr)&&(filterB!=nullptr) )
     { // regular case (shape-shape)
-        unsigned int collFA=_simGetDynamicCollisionMask(shapeA);
-        unsigned int collFB=_simGetDynamicCollisionMask(shapeB);
-        canCollide=_simIsShapeDynamicallyRespondable(shapeA)&&_simIsShapeDynamicallyRespondable(shapeB)&&((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_respondable)!=0)&&((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_respondable)!=0);
-        if (_simGetLastParentForLocalGlobalCollidable(shapeA)==_simGetLastParentForLocalGlobalCollidable(shapeB))
+        unsigned int collFA=filterA->collisionMask;
+        unsigned int collFB=filterB->collisionMask;
+        const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+        canCollide=((filterA->flags&filterB->flags&respFlags)==respFlags);
+        if (filterA->localGlobalCollidableRoot==filterB->localGlobalCollidableRoot)
             canCollide=canCollide&&(collFA&collFB&0x00ff); // we are local
         else
             canCollide=canCollide&&(collFA&collFB&0xff00); // we are global
-        if ( (_simIsShapeDynamicallyStatic(shapeA)||((_simGetTreeDynamicProperty(shapeA)&sim_objdynprop_dynamic)==0))&&
-            (_simIsShapeDynamicallyStatic(shapeB)||((_simGetTreeDynamicProperty(shapeB)&sim_objdynprop_dynamic)==0)) )
+        if ((filterA->flags&filterB->flags&dyn_collfilter_staticornottreedynamic)!=0)
             canCollide=false;
     }
     else
     { // particle-shape or particle-particle case:
         int dataA=(uint64_t) b1->userData().getData("csim").getValueInteger();
         int dataB=(uint64_t) b2->userData().getData("csim").getValueInteger();
-        if ( (shapeA==nullptr)&&(shapeB==nullptr) )
+        if ( (filterA==nullptr)&&(filterB==nullptr) )
         { // particle-particle case:
             CParticleObject* pa=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
             CParticleObject* pb=particleCont.getObject(dataB-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
@@ -476,22 +478,22 @@ void CRigidBodyContainerDyn_vortex::_vortexCollisionCallback(void* data,Vx::VxCo
         }
         else
         { // particle-shape case:
-            CDummyShape* shape;
+            const SCollisionFilter* filter;
             CParticleObject* particle;
-            if (shapeA!=nullptr)
+            if (filterA!=nullptr)
             {
-                shape=shapeA;
-                objID1=_simGetObjectID(shapeA);
+                filter=filterA;
+                objID1=dataA;
             }
             else
             {
                 particle=particleCont.getObject(dataA-CRigidBodyContainerDyn::getDynamicParticlesIdStart(),false);
                 objID1=dataA;
             }
-            if (shapeB!=nullptr)
+            if (filterB!=nullptr)
             {
-                shape=shapeB;
-                objID2=_simGetObjectID(shapeB);
+                filter=filterB;
+                objID2=dataB;
             }
             else
             {
@@ -501,7 +503,8 @@ void CRigidBodyContainerDyn_vortex::_vortexCollisionCallback(void* data,Vx::VxCo
 
             if (particle!=nullptr) // added this condition on 08/02/2011 because of some crashes when scaling some models
             {
-                canCollide=_simIsShapeDynamicallyRespondable(shape)&&(_simGetDynamicCollisionMask(shape)&particle->getShapeRespondableMask()&0xff00)&&((_simGetTreeDynamicProperty(shape)&sim_objdynprop_respondable)!=0); // we are global
+                const unsigned char respFlags=dyn_collfilter_respondable|dyn_collfilter_treerespondable;
+                canCollide=((filter->flags&respFlags)==respFlags)&&(filter->collisionMask&particle->getShapeRespondableMask()&0xff00); // we are global
             }
         }
     }
@@ -512,7 +515,7 @@ void CRigidBodyContainerDyn_vortex::_vortexCollisionCallback(void* data,Vx::VxCo
         int dataInt[3]={0,0,0};
         float dataFloat[14]={0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f};
         // For now we won't allow modification of contact parameters when using VORTEX
-        bool canReallyCollide=(_simHandleCustomContact(objID1,objID2,sim_physics_vortex,dataInt,dataFloat)!=0);
+        bool canReallyCollide=(_handleCustomContact(objID1,objID2,sim_physics_vortex,dataInt,dataFloat)!=0);
         if (canReallyCollide)
             disableThisContact=false;
     }
@@ -709,7 +712,7 @@ void CRigidBodyContainerDyn_vortex::_addVortexContactPoints(int dynamicPassNumbe
             if (force2*n2<0.0f)
                 n2=n2*-1.0f;
             ci.surfaceNormal=n2;
-            _contactInfo.push_back(ci);
+            _contacts.addContact(ci);
 
             _contactPoints.push_back(pos2(0));
             _contactPoints.push_back(pos2(1));
@@ -913,6 +916,7 @@ void CRigidBodyContainerDyn_vortex::_stepDynamics(float dt,int pass)
         //_vortexWorld->printContent("vxuniverse.txt");
     }
     //Vx::VxInfo(0, "trial=%d, time remaining=%g\n", Vx::LicensingManager::isRunningTrial(), Vx::LicensingManager::getTrialRemainingSeconds());
+    _fillAllCollisionFilters(); // pair filtering can run on several threads
     Vx::VxFrame::currentInstance()->setTimeStep((Vx::VxReal)dt);
     Vx::VxFrame::currentInstance()->step();
     _addVortexContactPoints(pass);
@@ -19,7 +19,7 @@ class CRigidBodyContainerDyn_vortex : public CRigidBodyContainerDyn
 {
 public:
 
-    CRigidBodyContainerDyn_vortex();
+    CRigidBodyContainerDyn_vortex(const SDynWorldSettings& settings);
     virtual ~CRigidBodyContainerDyn_vortex();
 
     int getEngineInfo(int& engine,int data1[4],char* data2,char* data3);
@@ -31,7 +31,6 @@ public:
     void licenseCheck();
 
     static bool _checkingLicense;
-    static void _vortexCollisionCallbackStatic(void* data,Vx::VxCollisionGeometry* o1,Vx::VxCollisionGeometry* o2);
     void _vortexCollisionCallback(void* data,Vx::VxCollisionGeometry* o1,Vx::VxCollisionGeometry* o2);
 
 protected:
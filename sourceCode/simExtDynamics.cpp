@@ -14,6 +14,7 @@
 #ifdef INCLUDE_VORTEX_CODE
 #include "RigidBodyContainerDyn_vortex.h"
 #endif
+#include "StepProfiler.h"
 #include "simLib.h"
 #include <iostream>
 #include <cstdio>
@@ -27,6 +28,10 @@
 #endif
 
 static LIBRARY simLib;
+CRigidBodyContainerDyn* dynWorld=NULL; // the world of the simulation. The exports below apply to it
+std::vector<CRigidBodyContainerDyn*> dynWorlds; // created with dynPlugin_createWorld, indexed by handle. Can contain NULL
+SDynWorldSettings dynSettings; // modes of the worlds created afterwards
+std::vector<unsigned char> dynState; // returned by dynPlugin_saveState
 
 SIM_DLLEXPORT unsigned char simStart(void* reservedPointer,int reservedInt)
 {
@@ -60,6 +65,7 @@ SIM_DLLEXPORT unsigned char simStart(void* reservedPointer,int reservedInt)
          return(0);
     }
 
+    CRigidBodyContainerDyn::getDefaultWorldSettings(dynSettings);
     return(DYNAMICS_PLUGIN_VERSION);
 }
 
@@ -73,56 +79,78 @@ SIM_DLLEXPORT void* simMessage(int message,int* auxiliaryData,void* customData,i
     return(NULL);
 }
 
-CRigidBodyContainerDyn* dynWorld=NULL;
-
-SIM_DLLEXPORT char dynPlugin_startSimulation(int engine,int version,const float floatParams[20],const int intParams[20])
+static CRigidBodyContainerDyn* _createWorld(int engine,int version,const float floatParams[20],const int intParams[20])
 {
-    CRigidBodyContainerDyn::setPositionScalingFactorDyn(floatParams[0]);
-    CRigidBodyContainerDyn::setLinearVelocityScalingFactorDyn(floatParams[1]);
-    CRigidBodyContainerDyn::setMassScalingFactorDyn(floatParams[2]);
-    CRigidBodyContainerDyn::setMasslessInertiaScalingFactorDyn(floatParams[3]);
-    CRigidBodyContainerDyn::setForceScalingFactorDyn(floatParams[4]);
-    CRigidBodyContainerDyn::setTorqueScalingFactorDyn(floatParams[5]);
-    CRigidBodyContainerDyn::setGravityScalingFactorDyn(floatParams[6]);
+    SDynWorldSettings settings=dynSettings;
+    settings.positionScalingFactor=floatParams[0];
+    settings.linearVelocityScalingFactor=floatParams[1];
+    settings.massScalingFactor=floatParams[2];
+    settings.masslessInertiaScalingFactor=floatParams[3];
+    settings.forceScalingFactor=floatParams[4];
+    settings.torqueScalingFactor=floatParams[5];
+    settings.gravityScalingFactor=floatParams[6];
 
-    CRigidBodyContainerDyn::setDynamicActivityRange(floatParams[7]);
+    settings.dynamicActivityRange=floatParams[7];
 
-    CRigidBodyContainerDyn::setDynamicParticlesIdStart(intParams[0]);
-    CRigidBodyContainerDyn::set3dObjectIdStart(intParams[1]);
-    CRigidBodyContainerDyn::set3dObjectIdEnd(intParams[2]);
+    settings.dynamicParticlesIdStart=intParams[0];
+    settings.objectIdStart=intParams[1];
+    settings.objectIdEnd=intParams[2];
 
-
-    simAddLog(LIBRARY_NAME,sim_verbosity_infos,"initializing the physics engine...");
+    CRigidBodyContainerDyn* world=NULL;
 
 #ifdef INCLUDE_BULLET_2_78_CODE
     if ( (engine==sim_physics_bullet)&&(version==0) )
-        dynWorld=new CRigidBodyContainerDyn_bullet278();
+        world=new CRigidBodyContainerDyn_bullet278(settings);
 #endif
 
 #ifdef INCLUDE_BULLET_2_83_CODE
     if ( (engine==sim_physics_bullet)&&(version==283) )
-        dynWorld=new CRigidBodyContainerDyn_bullet283();
+        world=new CRigidBodyContainerDyn_bullet283(settings);
 #endif
 
 #ifdef INCLUDE_ODE_CODE
     if ( (engine==sim_physics_ode)&&(version==0) )
-        dynWorld=new CRigidBodyContainerDyn_ode();
+        world=new CRigidBodyContainerDyn_ode(settings);
 #endif
 
 #ifdef INCLUDE_NEWTON_CODE
     if ( (engine==sim_physics_newton)&&(version==0) )
-        dynWorld=new CRigidBodyContainerDyn_newton();
+        world=new CRigidBodyContainerDyn_newton(settings);
 #endif
 
 #ifdef INCLUDE_VORTEX_CODE
     if ( (engine==sim_physics_vortex)&&(version==0) )
     {
-        dynWorld=new CRigidBodyContainerDyn_vortex();
-        ((CRigidBodyContainerDyn_vortex*)dynWorld)->licenseCheck();
+        world=new CRigidBodyContainerDyn_vortex(settings);
+        ((CRigidBodyContainerDyn_vortex*)world)->licenseCheck();
     }
 #endif
 
+    return(world);
+}
+
+static CRigidBodyContainerDyn* _getWorld()
+{ // returns dynWorld, made current for the static getters of CRigidBodyContainerDyn (another world might have been used last)
     if (dynWorld!=NULL)
+        dynWorld->makeCurrent();
+    return(dynWorld);
+}
+
+static CRigidBodyContainerDyn* _getCreatedWorld(int worldHandle)
+{ // same as above, for a world created with dynPlugin_createWorld
+    if ( (worldHandle<0)||(worldHandle>=int(dynWorlds.size()))||(dynWorlds[worldHandle]==NULL) )
+        return(NULL);
+    dynWorlds[worldHandle]->makeCurrent();
+    return(dynWorlds[worldHandle]);
+}
+
+SIM_DLLEXPORT char dynPlugin_startSimulation(int engine,int version,const float floatParams[20],const int intParams[20])
+{
+    simAddLog(LIBRARY_NAME,sim_verbosity_infos,"initializing the physics engine...");
+
+    dynWorld=_createWorld(engine,version,floatParams,intParams);
+
+    if (_getWorld()!=NULL)
     {
         int    data1[4];
         char versionStr[256];
@@ -140,32 +168,46 @@ SIM_DLLEXPORT char dynPlugin_startSimulation(int engine,int version,const float
 
 SIM_DLLEXPORT void dynPlugin_endSimulation()
 {
+    for (int i=0;i<int(dynWorlds.size());i++)
+    { // the worlds created with dynPlugin_createWorld don't survive the simulation
+        if (_getCreatedWorld(i)!=NULL)
+        {
+            dynWorlds[i]->finishDynamics();
+            delete dynWorlds[i];
+        }
+    }
+    dynWorlds.clear();
+    if (_getWorld()!=NULL)
+        dynWorld->finishDynamics();
     delete dynWorld;
     dynWorld=NULL;
 }
 
 SIM_DLLEXPORT void dynPlugin_step(float timeStep,float simulationTime)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         dynWorld->handleDynamics(timeStep,simulationTime);
 }
 
 SIM_DLLEXPORT char dynPlugin_isDynamicContentAvailable()
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         return(dynWorld->isDynamicContentAvailable());
     return(0);
 }
 
 SIM_DLLEXPORT void dynPlugin_serializeDynamicContent(const char* filenameAndPath,int bulletSerializationBuffer)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->finishDynamics();
         dynWorld->serializeDynamicContent(filenameAndPath,bulletSerializationBuffer);
+    }
 }
 
 SIM_DLLEXPORT int dynPlugin_addParticleObject(int objectType,float size,float massOverVolume,const void* params,float lifeTime,int maxItemCount,const float* ambient,const float* diffuse,const float* specular,const float* emission)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
     {
         CParticleObject* it=new CParticleObject(objectType,size,massOverVolume,params,lifeTime,maxItemCount);
         for (int i=0;i<9;i++)
@@ -181,6 +223,7 @@ SIM_DLLEXPORT int dynPlugin_addParticleObject(int objectType,float size,float ma
             if (emission!=NULL)
                 it->color[9+i]=emission[i];
         }
+        dynWorld->finishDynamics();
         return(dynWorld->particleCont.addObject(it));
     }
     return(-1); // error
@@ -188,8 +231,9 @@ SIM_DLLEXPORT int dynPlugin_addParticleObject(int objectType,float size,float ma
 
 SIM_DLLEXPORT char dynPlugin_removeParticleObject(int objectHandle)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
     {
+        dynWorld->finishDynamics();
         if (objectHandle==sim_handle_all)
             dynWorld->particleCont.removeAllObjects();
         else
@@ -206,7 +250,7 @@ SIM_DLLEXPORT char dynPlugin_removeParticleObject(int objectHandle)
 
 SIM_DLLEXPORT char dynPlugin_addParticleObjectItem(int objectHandle,const float* itemData,float simulationTime)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
     {
         CParticleObject* it=dynWorld->particleCont.getObject(objectHandle,false);
         if (it==NULL)
@@ -220,7 +264,7 @@ SIM_DLLEXPORT char dynPlugin_addParticleObjectItem(int objectHandle,const float*
 SIM_DLLEXPORT int dynPlugin_getParticleObjectOtherFloatsPerItem(int objectHandle)
 {
     int retVal=0;
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
     {
         CParticleObject* it=dynWorld->particleCont.getObject(objectHandle,false);
         if (it!=NULL)
@@ -235,14 +279,14 @@ SIM_DLLEXPORT float* dynPlugin_getContactPoints(int* count)
 {
     float* retVal=NULL;
     count[0]=0;
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         retVal=dynWorld->getContactPoints(count);
     return(retVal);
 }
 
 SIM_DLLEXPORT void** dynPlugin_getParticles(int index,int* particlesCount,int* objectType,float** cols)
 {
-    if (dynWorld==NULL)
+    if (_getWorld()==NULL)
     {
         particlesCount[0]=-1;
         return(NULL);
@@ -259,28 +303,273 @@ SIM_DLLEXPORT char dynPlugin_getParticleData(const void* particle,float* pos,flo
 
 SIM_DLLEXPORT char dynPlugin_getContactForce(int dynamicPass,int objectHandle,int index,int objectHandles[2],float contactInfo[6])
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         return(dynWorld->getContactForce(dynamicPass,objectHandle,index,objectHandles,contactInfo));
     return(false);
 }
 
 SIM_DLLEXPORT void dynPlugin_reportDynamicWorldConfiguration(int totalPassesCount,char doNotApplyJointIntrinsicPositions,float simulationTime)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->finishDynamics();
         dynWorld->reportDynamicWorldConfiguration(totalPassesCount,doNotApplyJointIntrinsicPositions!=0,simulationTime);
+    }
 }
 
 SIM_DLLEXPORT int dynPlugin_getDynamicStepDivider()
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         return(dynWorld->getDynamicsCalculationPasses());
     return(0);
 }
 
 SIM_DLLEXPORT int dynPlugin_getEngineInfo(int* engine,int* data1,char* data2,char* data3)
 {
-    if (dynWorld!=NULL)
+    if (_getWorld()!=NULL)
         return(dynWorld->getEngineInfo(engine[0],data1,data2,data3));
     engine[0]=-1;
     return(-1);
 }
+
+SIM_DLLEXPORT void dynPlugin_setWorldSyncMode(int mode)
+{ // 0=full scene rescan every step (default), 1=incremental, 2=incremental cross-checked with a full rescan (debug)
+  // Like all mode setters below, applies to the world of the simulation and to the worlds created afterwards
+    dynSettings.worldSyncMode=mode;
+    if (_getWorld()!=NULL)
+        dynWorld->setWorldSyncMode(mode);
+}
+
+SIM_DLLEXPORT void dynPlugin_setWriteBackMode(int mode,char intermediateStateNeeded)
+{ // 0=write back to the scene after each sub-pass (default), 1=only after the last sub-pass. intermediateStateNeeded forces the write back after each sub-pass (e.g. dynamics or joint callbacks are registered). Steps with colliding pairs are always written back after each sub-pass, for contact callbacks
+    dynSettings.writeBackMode=mode;
+    dynSettings.intermediateWriteBackNeeded=(intermediateStateNeeded!=0);
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->setWriteBackMode(mode);
+        dynWorld->setIntermediateWriteBackNeeded(intermediateStateNeeded!=0);
+    }
+}
+
+SIM_DLLEXPORT int dynPlugin_getContactForces(int dynamicPass,int objectHandle,int* count,int* objectHandles,float* contactInfo)
+{ // count[0] in: capacity of the buffers (in contacts), out: number of available contacts. objectHandles: 2 per contact, contactInfo: 9 per contact (position, force, normal)
+  // Buffers can be NULL to only query the count. Return value is the number of contacts written
+    int capacity=count[0];
+    count[0]=0;
+    if (_getWorld()==NULL)
+        return(0);
+    if ( (objectHandles==NULL)||(contactInfo==NULL) )
+        capacity=0;
+    count[0]=dynWorld->getContactForces(dynamicPass,objectHandle,capacity,objectHandles,contactInfo);
+    if (count[0]<capacity)
+        return(count[0]);
+    return(capacity);
+}
+
+SIM_DLLEXPORT int dynPlugin_getContactAllocationCount()
+{ // heap allocations done so far by the contact pipeline. Should not increase anymore once the scene is warm
+    if (_getWorld()==NULL)
+        return(0);
+    return(int(dynWorld->getContactAllocationCount()));
+}
+
+SIM_DLLEXPORT int dynPlugin_getProfilingData(int* phaseCount,int* counterCount,int maxSteps,float* phaseTimes,int* counters)
+{ // phaseTimes: phaseCount[0] values per step (ms, see dyn_profphase_*), counters: counterCount[0] values per step (see dyn_profcounter_*)
+  // Fills in the last maxSteps steps, oldest first, and returns their number. Returns -1 if the plugin was built without DYN_PROFILING
+    phaseCount[0]=dyn_profphase_count;
+    counterCount[0]=dyn_profcounter_count;
+#ifdef DYN_PROFILING
+    if ( (_getWorld()==NULL)||(phaseTimes==NULL)||(counters==NULL) )
+        return(0);
+    return(dynWorld->profiler.getData(maxSteps,phaseTimes,counters));
+#else
+    return(-1);
+#endif
+}
+
+SIM_DLLEXPORT void dynPlugin_stepAsync(float timeStep,float simulationTime)
+{ // like dynPlugin_step, but returns before the step is complete. Until dynPlugin_waitStep is called:
+  // - the scene keeps the body poses, velocities and joint positions of the previous step (the sub-passes are not written back, even with dynPlugin_setWriteBackMode(0,..)),
+  // - contact queries return the results of the previous step.
+  // Only the integration of the last sub-pass runs in the background, and only with ODE. Bullet, Newton and Vortex run the whole step before returning
+  // Callbacks that run during the sub-passes (dynamics, joint and contact callbacks) also see the scene of the previous step
+    if (_getWorld()!=NULL)
+        dynWorld->startDynamics(timeStep,simulationTime,true);
+}
+
+SIM_DLLEXPORT void dynPlugin_waitStep()
+{ // completes the step started with dynPlugin_stepAsync (write-back to the scene, etc.). Does nothing if no step is pending
+    if (_getWorld()!=NULL)
+        dynWorld->finishDynamics();
+}
+
+SIM_DLLEXPORT const unsigned char* dynPlugin_saveState(int* size)
+{ // returns the dynamic state (body poses and velocities, motor internals, particles). The data stays valid until the next call
+  // Returns NULL if the engine does not support it (supported: ODE, Bullet 2.78 and Newton)
+    size[0]=0;
+    if (_getWorld()==NULL)
+        return(NULL);
+    dynWorld->finishDynamics();
+    if (!dynWorld->saveState(dynState))
+        return(NULL);
+    size[0]=int(dynState.size());
+    return(&dynState[0]);
+}
+
+SIM_DLLEXPORT char dynPlugin_restoreState(const unsigned char* state,int size)
+{ // applies a state returned by dynPlugin_saveState, in the same simulation. Call dynPlugin_reportDynamicWorldConfiguration afterwards to move the scene objects
+    if (_getWorld()==NULL)
+        return(false);
+    dynWorld->finishDynamics();
+    return(dynWorld->restoreState(state,size));
+}
+
+SIM_DLLEXPORT void dynPlugin_setSubStepMode(int mode,const float thresholds[3],int maxPassFactor)
+{ // 0=fixed sub-step count (default), 1=adaptive. thresholds: penetration depth, constraint error and body velocity (m, m, m/s), can be NULL
+  // In adaptive mode, the sub-step count is doubled (up to the fixed count times maxPassFactor) after a step that exceeded a threshold, and halved after a series of calm steps
+    dynSettings.subStepMode=mode;
+    if (thresholds!=NULL)
+    {
+        for (int i=0;i<3;i++)
+            dynSettings.adaptiveSubStepThresholds[i]=thresholds[i];
+        if (maxPassFactor<1)
+            maxPassFactor=1;
+        dynSettings.adaptiveSubStepMaxPassFactor=maxPassFactor;
+    }
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->setSubStepMode(mode);
+        if (thresholds!=NULL)
+            dynWorld->setAdaptiveSubStepParams(thresholds,maxPassFactor);
+    }
+}
+
+SIM_DLLEXPORT int dynPlugin_getSubStepMeasures(float measures[3])
+{ // penetration depth, constraint error and body velocity measured after the last finished step (adaptive mode only). Returns the bits of the exceeded thresholds (1, 2, 4), or -1
+    if (_getWorld()==NULL)
+        return(-1);
+    return(dynWorld->getSubStepMeasures(measures));
+}
+
+SIM_DLLEXPORT void dynPlugin_setSleepMode(int mode,const float params[3])
+{ // 0=bodies never sleep (default), 1=resting bodies and islands sleep. params: linear velocity threshold, angular velocity threshold and time to sleep (m/s, rad/s, s), can be NULL
+  // Applies to bodies created afterwards, i.e. call this before starting the simulation. Newton ignores the thresholds
+    dynSettings.sleepMode=mode;
+    if (params!=NULL)
+    {
+        for (int i=0;i<3;i++)
+            dynSettings.sleepParams[i]=params[i];
+    }
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->setSleepMode(mode);
+        if (params!=NULL)
+            dynWorld->setSleepParams(params);
+    }
+}
+
+SIM_DLLEXPORT void dynPlugin_setVisualizationFlagMode(int mode)
+{ // 0=all visualization flags are set after each step (default), 1=only the flags that changed, 2=none (e.g. headless)
+    dynSettings.visualizationFlagMode=mode;
+    if (_getWorld()!=NULL)
+        dynWorld->setVisualizationFlagMode(mode);
+}
+
+SIM_DLLEXPORT int dynPlugin_getVisualizationFlags(int maxCount,int* objectHandles,int* flags)
+{ // pulls the current visualization flags (e.g. when actually rendering). Copies up to maxCount flags, returns the total count, or -1
+    if (_getWorld()==NULL)
+        return(-1);
+    return(dynWorld->getVisualizationFlags(maxCount,objectHandles,flags));
+}
+
+SIM_DLLEXPORT void dynPlugin_setParticleEngine(int engine)
+{ // 0=each particle is a rigid body of the physics engine (default), 1=particles are simulated by the plugin (structure of arrays), only their reaction forces go to the engine
+  // Applies to particle objects created afterwards. Not supported with Bullet 2.83 and Vortex
+    dynSettings.particleEngine=engine;
+    if (_getWorld()!=NULL)
+        dynWorld->setParticleEngine(engine);
+}
+
+SIM_DLLEXPORT char dynPlugin_addParticleObjectItems(int objectHandle,int itemCount,const float* itemData,float simulationTime)
+{ // adds a whole emitter burst. itemData: itemCount items laid out as for dynPlugin_addParticleObjectItem (see dynPlugin_getParticleObjectOtherFloatsPerItem)
+    if ( (_getWorld()!=NULL)&&(itemData!=NULL) )
+    {
+        CParticleObject* it=dynWorld->particleCont.getObject(objectHandle,false);
+        if (it==NULL)
+            return(false); // error
+        it->addParticles(simulationTime,itemCount,itemData);
+        return(true);
+    }
+    return(false); // error
+}
+
+SIM_DLLEXPORT int dynPlugin_getParticleRenderData(int index,int sinceFrame,int maxCount,int* slots,float* positions,float* sizes,float* colors,int* frame)
+{ // index as for dynPlugin_getParticles. Fills contiguous arrays (slot, xyz, size, additional rgb) with up to maxCount items in one call, any array can be NULL
+  // sinceFrame=-1: all particles. Otherwise only the slots that changed since a frame previously returned in frame (emptied slots have a size of 0)
+  // Returns the total item count (can be larger than maxCount), 0 for an empty index, -1 past the last index
+    if ( (_getWorld()==NULL)||(index>=dynWorld->particleCont.getObjectCount()) )
+        return(-1);
+    CParticleObject* it=dynWorld->particleCont.getObject(index,false);
+    if (it==NULL)
+        return(0);
+    return(it->getRenderData(sinceFrame,maxCount,slots,positions,sizes,colors,frame));
+}
+
+SIM_DLLEXPORT int dynPlugin_getParticleRenderBuffers(int index,int sinceFrame,int** slots,float** positions,float** sizes,float** colors,int* frame)
+{ // same as dynPlugin_getParticleRenderData, but returns plugin-owned arrays, valid until the next call for that particle object
+    if ( (_getWorld()==NULL)||(index>=dynWorld->particleCont.getObjectCount()) )
+        return(-1);
+    CParticleObject* it=dynWorld->particleCont.getObject(index,false);
+    if (it==NULL)
+        return(0);
+    return(it->getRenderBuffers(sinceFrame,slots,positions,sizes,colors,frame));
+}
+
+SIM_DLLEXPORT void dynPlugin_setContactBatchCallback(void (*callback)(int engine,int pairCount,const int* objectHandles,int* results,int* dataInt,float* dataFloat))
+{ // replaces the simulator's contact handling (i.e. script and plugin contact callbacks) with callback, NULL restores it (default)
+  // Per pair: 2 object handles, 3 dataInt and 14 dataFloat values (in/out), and a result with the meaning of simHandleCustomContact's return value
+  // ODE hands over all colliding pairs of a pass in one call. Bullet 2.78 and Newton call it for each pair as it is found (Newton possibly from several threads). Not supported with Bullet 2.83 and Vortex
+    dynSettings.contactBatchCallback=callback;
+    if (_getWorld()!=NULL)
+    {
+        dynWorld->finishDynamics();
+        dynWorld->setContactBatchCallback(callback);
+    }
+}
+
+SIM_DLLEXPORT int dynPlugin_createWorld(int engine,int version,const float floatParams[20],const int intParams[20])
+{ // creates an additional world, with parameters as for dynPlugin_startSimulation and the current modes. Returns its handle, or -1 if the engine is not available
+  // Each world has its own engine world, bodies, particles, modes, contacts and profiler. It mirrors the scene like the world of the simulation, and writes its results back to it,
+  // so stepping several worlds over the same objects makes the last stepped one win. Worlds are stepped one after the other, by the simulation thread (the simulator API is not thread-safe)
+  // The world is destroyed with dynPlugin_destroyWorld, or when the simulation ends
+    CRigidBodyContainerDyn* world=_createWorld(engine,version,floatParams,intParams);
+    if (world==NULL)
+        return(-1);
+    int handle=0;
+    while ( (handle<int(dynWorlds.size()))&&(dynWorlds[handle]!=NULL) )
+        handle++;
+    if (handle>=int(dynWorlds.size()))
+        dynWorlds.push_back(NULL);
+    dynWorlds[handle]=world;
+    return(handle);
+}
+
+SIM_DLLEXPORT char dynPlugin_destroyWorld(int worldHandle)
+{
+    CRigidBodyContainerDyn* world=_getCreatedWorld(worldHandle);
+    if (world==NULL)
+        return(false);
+    world->finishDynamics();
+    delete world;
+    dynWorlds[worldHandle]=NULL;
+    return(true);
+}
+
+SIM_DLLEXPORT char dynPlugin_stepWorld(int worldHandle,float timeStep,float simulationTime)
+{ // same as dynPlugin_step, for a world created with dynPlugin_createWorld
+    CRigidBodyContainerDyn* world=_getCreatedWorld(worldHandle);
+    if (world==NULL)
+        return(false);
+    world->handleDynamics(timeStep,simulationTime);
+    return(true);
+}
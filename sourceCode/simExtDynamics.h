@@ -29,4 +29,26 @@ SIM_DLLEXPORT char dynPlugin_getContactForce(int dynamicPass,int objectHandle,in
 SIM_DLLEXPORT void dynPlugin_reportDynamicWorldConfiguration(int totalPassesCount,char doNotApplyJointIntrinsicPositions,float simulationTime);
 SIM_DLLEXPORT int dynPlugin_getDynamicStepDivider();
 SIM_DLLEXPORT int dynPlugin_getEngineInfo(int* engine,int* data1,char* data2,char* data3);
+SIM_DLLEXPORT void dynPlugin_setWorldSyncMode(int mode);
+SIM_DLLEXPORT void dynPlugin_setWriteBackMode(int mode,char intermediateStateNeeded);
+SIM_DLLEXPORT int dynPlugin_getContactForces(int dynamicPass,int objectHandle,int* count,int* objectHandles,float* contactInfo);
+SIM_DLLEXPORT int dynPlugin_getContactAllocationCount();
+SIM_DLLEXPORT int dynPlugin_getProfilingData(int* phaseCount,int* counterCount,int maxSteps,float* phaseTimes,int* counters);
+SIM_DLLEXPORT void dynPlugin_stepAsync(float timeStep,float simulationTime);
+SIM_DLLEXPORT void dynPlugin_waitStep();
+SIM_DLLEXPORT const unsigned char* dynPlugin_saveState(int* size);
+SIM_DLLEXPORT char dynPlugin_restoreState(const unsigned char* state,int size);
+SIM_DLLEXPORT void dynPlugin_setSubStepMode(int mode,const float thresholds[3],int maxPassFactor);
+SIM_DLLEXPORT int dynPlugin_getSubStepMeasures(float measures[3]);
+SIM_DLLEXPORT void dynPlugin_setSleepMode(int mode,const float params[3]);
+SIM_DLLEXPORT void dynPlugin_setVisualizationFlagMode(int mode);
+SIM_DLLEXPORT int dynPlugin_getVisualizationFlags(int maxCount,int* objectHandles,int* flags);
+SIM_DLLEXPORT void dynPlugin_setParticleEngine(int engine);
+SIM_DLLEXPORT char dynPlugin_addParticleObjectItems(int objectHandle,int itemCount,const float* itemData,float simulationTime);
+SIM_DLLEXPORT int dynPlugin_getParticleRenderData(int index,int sinceFrame,int maxCount,int* slots,float* positions,float* sizes,float* colors,int* frame);
+SIM_DLLEXPORT int dynPlugin_getParticleRenderBuffers(int index,int sinceFrame,int** slots,float** positions,float** sizes,float** colors,int* frame);
+SIM_DLLEXPORT void dynPlugin_setContactBatchCallback(void (*callback)(int engine,int pairCount,const int* objectHandles,int* results,int* dataInt,float* dataFloat));
+SIM_DLLEXPORT int dynPlugin_createWorld(int engine,int version,const float floatParams[20],const int intParams[20]);
+SIM_DLLEXPORT char dynPlugin_destroyWorld(int worldHandle);
+SIM_DLLEXPORT char dynPlugin_stepWorld(int worldHandle,float timeStep,float simulationTime);
 #endif // SIMEXTDYNAMICS_H